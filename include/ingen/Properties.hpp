@@ -54,6 +54,13 @@ private:
 	Graph _ctx;
 };
 
+/** A set of properties keyed by URI.
+ *
+ * This is the description of a resource passed between the engine, clients,
+ * parser, and serialiser, so keys are full URIs rather than URIDs, which are
+ * only meaningful within one URI map.  Within the engine, events use
+ * URIDProperties instead, so key comparisons there are integer comparisons.
+ */
 class Properties : public std::multimap<URI, Property>
 {
 public:
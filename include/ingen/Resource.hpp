@@ -29,6 +29,7 @@
 namespace ingen {
 
 class Atom;
+class URIDProperties;
 
 /** A resource with a URI described by properties.
  *
@@ -185,6 +186,14 @@ public:
 	                 bool&             port,
 	                 bool&             is_output);
 
+	/** Get the ingen type from a set of URID-keyed properties. */
+	static bool type(const URIs&           uris,
+	                 const URIDProperties& properties,
+	                 bool&                 graph,
+	                 bool&                 block,
+	                 bool&                 port,
+	                 bool&                 is_output);
+
 	virtual void set_uri(const URI& uri) { _uri = uri; }
 
 	/** Get all the properties with a given context. */
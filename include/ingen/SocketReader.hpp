@@ -17,12 +17,16 @@
 #ifndef INGEN_SOCKETREADER_HPP
 #define INGEN_SOCKETREADER_HPP
 
+#include <ingen/WireFormat.hpp>
 #include <ingen/ingen.h>
 #include <serd/serd.h>
 #include <sord/sord.h>
 
+#include <chrono>
 #include <cstddef>
+#include <functional>
 #include <memory>
+#include <string>
 #include <thread>
 
 namespace raul {
@@ -34,13 +38,28 @@ namespace ingen {
 class Interface;
 class World;
 
-/** Calls Interface methods based on Turtle messages received via socket. */
+/** Calls Interface methods based on messages received via socket.
+ *
+ * Messages are Turtle, unless the peer starts the connection with a request
+ * for atoms, in which case `on_format` is called before reading any.  If
+ * `format` is WireFormat::ATOM, this has requested atoms from the peer, so
+ * input is skipped until the peer's acknowledgement.  If that does not arrive
+ * in time, the peer does not support atoms, so `on_format` is called with
+ * WireFormat::TURTLE and the skipped input is read as Turtle.
+ *
+ * Turtle is parsed into a private RDF world, so readers for different
+ * connections run in parallel without taking the world's RDF mutex.
+ */
 class INGEN_API SocketReader
 {
 public:
+	using FormatSink = std::function<void(WireFormat)>;
+
 	SocketReader(World&                        world,
 	             Interface&                    iface,
-	             std::shared_ptr<raul::Socket> sock);
+	             std::shared_ptr<raul::Socket> sock,
+	             WireFormat                    format    = WireFormat::TURTLE,
+	             FormatSink                    on_format = {});
 
 	virtual ~SocketReader();
 
@@ -56,6 +75,21 @@ private:
 
 	void run();
 
+	/// Read the format request or acknowledgement from the peer
+	WireFormat negotiate();
+
+	/// Read exactly `len` bytes, returning false on error or hangup
+	bool recv_all(void* buf, size_t len);
+
+	/// Wait for input until `deadline`, returning false on timeout
+	bool wait_for_input(std::chrono::steady_clock::time_point deadline);
+
+	/// Return true iff input received during negotiation is not yet read
+	bool has_pending() const { return _pending_pos < _pending.size(); }
+
+	void run_turtle();
+	void run_atoms();
+
 	static SerdStatus set_base_uri(SocketReader*   iface,
 	                               const SerdNode* uri_node);
 
@@ -74,10 +108,15 @@ private:
 
 	World&                        _world;
 	Interface&                    _iface;
+	SordWorld*                    _sord_world{nullptr};
 	SerdEnv*                      _env{nullptr};
 	SordInserter*                 _inserter{nullptr};
 	SordNode*                     _msg_node{nullptr};
 	std::shared_ptr<raul::Socket> _socket;
+	WireFormat                    _format;
+	FormatSink                    _on_format;
+	std::string                   _pending;        ///< Skipped input
+	size_t                        _pending_pos{0}; ///< Read offset in _pending
 	int                           _socket_error{0};
 	bool                          _exit_flag{false};
 	std::thread                   _thread;
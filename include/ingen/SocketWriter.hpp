@@ -19,10 +19,18 @@
 
 #include <ingen/Message.hpp>
 #include <ingen/TurtleWriter.hpp>
+#include <ingen/WireFormat.hpp>
 #include <ingen/ingen.h>
+#include <lv2/atom/atom.h>
+#include <lv2/atom/forge.h>
+#include <lv2/urid/urid.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
 
 namespace raul {
 class Socket;
@@ -34,7 +42,11 @@ class URI;
 class URIMap;
 class URIs;
 
-/** An Interface that writes Turtle messages to a socket.
+/** An Interface that writes Turtle or atom messages to a socket.
+ *
+ * If `format` is WireFormat::ATOM, this requests the atom format from the
+ * peer immediately, and writes atom messages.  Otherwise, messages are
+ * written as Turtle until set_format() is called.
  */
 class INGEN_API SocketWriter : public TurtleWriter
 {
@@ -42,14 +54,43 @@ public:
 	SocketWriter(URIMap&                       map,
 	             URIs&                         uris,
 	             const URI&                    uri,
-	             std::shared_ptr<raul::Socket> sock);
+	             std::shared_ptr<raul::Socket> sock,
+	             WireFormat                    format = WireFormat::TURTLE);
+
+	/** Switch format for all following messages (thread-safe).
+	 *
+	 * This is used by a server as soon as the peer requested a format, and
+	 * immediately sends the peer an acknowledgement, so a peer waiting for it
+	 * does not depend on the server having anything else to send.  A client
+	 * uses it to fall back to Turtle if the peer did not accept atoms.
+	 */
+	void set_format(WireFormat format);
 
 	void message(const Message& message) override;
 
+	bool write(const LV2_Atom* msg, int32_t default_id=0) override;
+
 	size_t text_sink(const void* buf, size_t len) override;
 
 protected:
+	/** Write a message atom, defining any URIDs the peer has not seen. */
+	bool write_atom(const LV2_Atom* msg);
+
+	/** Send all of `buf` to the socket.
+	 *
+	 * All output goes through this, so it can be overridden to send
+	 * differently, for example without blocking.
+	 */
+	virtual bool send_all(const void* buf, size_t len);
+
 	std::shared_ptr<raul::Socket> _socket;
+
+private:
+	std::mutex                   _mutex;      ///< Serialises output
+	LV2_Atom_Forge               _types{};    ///< For local atom type URIDs
+	WireFormat                   _format{WireFormat::TURTLE};
+	std::unordered_set<LV2_URID> _defined;    ///< URIDs sent to peer
+	std::vector<uint8_t>         _frames;     ///< Buffer for atom output
 };
 
 } // namespace ingen
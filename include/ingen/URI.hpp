@@ -108,24 +108,29 @@ private:
 	SerdNode _node;
 };
 
+/* Comparisons use views of the URI string, since these are used for every
+   lookup in Properties and copying long URIs to strings is expensive. */
+
 inline bool operator==(const URI& lhs, const URI& rhs)
 {
-	return lhs.string() == rhs.string();
+	return URI::Chunk{lhs.c_str(), lhs.length()} ==
+	       URI::Chunk{rhs.c_str(), rhs.length()};
 }
 
 inline bool operator==(const URI& lhs, const std::string& rhs)
 {
-	return lhs.string() == rhs;
+	return URI::Chunk{lhs.c_str(), lhs.length()} == rhs;
 }
 
 inline bool operator==(const URI& lhs, const char* rhs)
 {
-	return lhs.string() == rhs;
+	return URI::Chunk{lhs.c_str(), lhs.length()} == rhs;
 }
 
 inline bool operator==(const URI& lhs, const Sord::Node& rhs)
 {
-	return rhs.type() == Sord::Node::URI && lhs.string() == rhs.to_string();
+	return rhs.type() == Sord::Node::URI &&
+	       URI::Chunk{lhs.c_str(), lhs.length()} == rhs.to_c_string();
 }
 
 inline bool operator==(const Sord::Node& lhs, const URI& rhs)
@@ -135,17 +140,17 @@ inline bool operator==(const Sord::Node& lhs, const URI& rhs)
 
 inline bool operator!=(const URI& lhs, const URI& rhs)
 {
-	return lhs.string() != rhs.string();
+	return !(lhs == rhs);
 }
 
 inline bool operator!=(const URI& lhs, const std::string& rhs)
 {
-	return lhs.string() != rhs;
+	return !(lhs == rhs);
 }
 
 inline bool operator!=(const URI& lhs, const char* rhs)
 {
-	return lhs.string() != rhs;
+	return !(lhs == rhs);
 }
 
 inline bool operator!=(const URI& lhs, const Sord::Node& rhs)
@@ -160,7 +165,8 @@ inline bool operator!=(const Sord::Node& lhs, const URI& rhs)
 
 inline bool operator<(const URI& lhs, const URI& rhs)
 {
-	return lhs.string() < rhs.string();
+	return URI::Chunk{lhs.c_str(), lhs.length()} <
+	       URI::Chunk{rhs.c_str(), rhs.length()};
 }
 
 template <typename Char, typename Traits>
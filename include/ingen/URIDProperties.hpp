@@ -0,0 +1,209 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef INGEN_URIDPROPERTIES_HPP
+#define INGEN_URIDPROPERTIES_HPP
+
+#include <ingen/Atom.hpp>
+#include <ingen/Properties.hpp>
+#include <ingen/URI.hpp>
+#include <ingen/URIMap.hpp>
+#include <ingen/URIs.hpp>
+#include <lv2/urid/urid.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace ingen {
+
+/** A set of properties keyed by URID.
+ *
+ * This is a flat vector sorted by key, where values with equal keys keep the
+ * order they were added in.  Lookups compare integers and copies do not
+ * allocate per key, so this is used for properties that only live within the
+ * engine.  Conversion to and from Properties maps every key, so it should
+ * only happen where properties cross an Interface or are applied to a
+ * Resource.
+ */
+class URIDProperties
+{
+public:
+	using Graph          = Property::Graph;
+	using value_type     = std::pair<LV2_URID, Property>;
+	using iterator       = std::vector<value_type>::iterator;
+	using const_iterator = std::vector<value_type>::const_iterator;
+
+	URIDProperties() = default;
+
+	URIDProperties(std::initializer_list<value_type> l)
+	{
+		_entries.reserve(l.size());
+		for (const auto& p : l) {
+			emplace(p.first, p.second);
+		}
+	}
+
+	/** Map the keys of URI-keyed properties. */
+	URIDProperties(URIMap& map, const Properties& props)
+	{
+		_entries.reserve(props.size());
+		for (const auto& p : props) {
+			_entries.emplace_back(map.map_uri(p.first.c_str()), p.second);
+		}
+
+		std::stable_sort(_entries.begin(), _entries.end(), entry_less);
+	}
+
+	/** Return URI-keyed properties, with every key unmapped. */
+	Properties to_properties(const URIMap& map) const
+	{
+		Properties props;
+		for (const auto& p : _entries) {
+			props.emplace(URI(map.unmap_uri(p.first)), p.second);
+		}
+
+		return props;
+	}
+
+	iterator       begin() { return _entries.begin(); }
+	iterator       end() { return _entries.end(); }
+	const_iterator begin() const { return _entries.begin(); }
+	const_iterator end() const { return _entries.end(); }
+
+	size_t size() const { return _entries.size(); }
+	bool   empty() const { return _entries.empty(); }
+	void   clear() { _entries.clear(); }
+	void   reserve(size_t n) { _entries.reserve(n); }
+
+	iterator lower_bound(LV2_URID key)
+	{
+		return std::lower_bound(
+		    _entries.begin(), _entries.end(), key, entry_less_key);
+	}
+
+	const_iterator lower_bound(LV2_URID key) const
+	{
+		return std::lower_bound(
+		    _entries.begin(), _entries.end(), key, entry_less_key);
+	}
+
+	iterator upper_bound(LV2_URID key)
+	{
+		return std::upper_bound(
+		    _entries.begin(), _entries.end(), key, key_less_entry);
+	}
+
+	const_iterator upper_bound(LV2_URID key) const
+	{
+		return std::upper_bound(
+		    _entries.begin(), _entries.end(), key, key_less_entry);
+	}
+
+	std::pair<iterator, iterator> equal_range(LV2_URID key)
+	{
+		return {lower_bound(key), upper_bound(key)};
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(LV2_URID key) const
+	{
+		return {lower_bound(key), upper_bound(key)};
+	}
+
+	/** Return the first value with `key`, or end(). */
+	iterator find(LV2_URID key)
+	{
+		const auto i = lower_bound(key);
+		return (i != end() && i->first == key) ? i : end();
+	}
+
+	/** Return the first value with `key`, or end(). */
+	const_iterator find(LV2_URID key) const
+	{
+		const auto i = lower_bound(key);
+		return (i != end() && i->first == key) ? i : end();
+	}
+
+	size_t count(LV2_URID key) const
+	{
+		const auto range = equal_range(key);
+		return static_cast<size_t>(range.second - range.first);
+	}
+
+	bool contains(LV2_URID key, const Atom& value) const
+	{
+		const auto range = equal_range(key);
+		return std::any_of(range.first,
+		                   range.second,
+		                   [&value](const value_type& p) {
+			                   return p.second == value;
+		                   });
+	}
+
+	/** Add a value after any others with the same key. */
+	iterator emplace(LV2_URID key, const Property& value)
+	{
+		return _entries.emplace(upper_bound(key), key, value);
+	}
+
+	void put(LV2_URID key, const Atom& value, Graph ctx = Graph::DEFAULT)
+	{
+		emplace(key, Property(value, ctx));
+	}
+
+	void put(LV2_URID           key,
+	         const URIs::Quark& value,
+	         Graph              ctx = Graph::DEFAULT)
+	{
+		emplace(key, Property(value, ctx));
+	}
+
+	iterator erase(const_iterator i) { return _entries.erase(i); }
+
+	/** Erase all values with `key` and return how many there were. */
+	size_t erase(LV2_URID key)
+	{
+		const auto range = equal_range(key);
+		const auto n     = static_cast<size_t>(range.second - range.first);
+		_entries.erase(range.first, range.second);
+		return n;
+	}
+
+private:
+	static bool entry_less(const value_type& lhs, const value_type& rhs)
+	{
+		return lhs.first < rhs.first;
+	}
+
+	static bool entry_less_key(const value_type& lhs, LV2_URID rhs)
+	{
+		return lhs.first < rhs;
+	}
+
+	static bool key_less_entry(LV2_URID lhs, const value_type& rhs)
+	{
+		return lhs < rhs.first;
+	}
+
+	std::vector<value_type> _entries;
+};
+
+} // namespace ingen
+
+#endif // INGEN_URIDPROPERTIES_HPP
@@ -112,7 +112,11 @@ public:
 	Quark ingen_internalContext;
 	Quark ingen_loadedBundle;
 	Quark ingen_maxRunLoad;
+	Quark ingen_maxRunTime;
+	Quark ingen_maxWakeups;
 	Quark ingen_meanRunLoad;
+	Quark ingen_meanRunTime;
+	Quark ingen_meanWakeups;
 	Quark ingen_minRunLoad;
 	Quark ingen_numThreads;
 	Quark ingen_polyphonic;
@@ -120,6 +124,7 @@ public:
 	Quark ingen_prototype;
 	Quark ingen_sprungLayout;
 	Quark ingen_tail;
+	Quark ingen_threadLoad;
 	Quark ingen_uiEmbedded;
 	Quark ingen_value;
 	Quark log_Error;
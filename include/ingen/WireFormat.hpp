@@ -0,0 +1,232 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_WIREFORMAT_HPP
+#define INGEN_WIREFORMAT_HPP
+
+#include <lv2/atom/atom.h>
+#include <lv2/atom/forge.h>
+#include <lv2/atom/util.h>
+#include <lv2/urid/urid.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ingen {
+
+/** The format of messages sent over a socket.
+ *
+ * Connections start with Turtle, which any peer understands.  A client that
+ * wants atoms sends wire_atom_magic as its first bytes, and the server
+ * replies with the same bytes as soon as it has read them.  Anything the
+ * server sent before that is Turtle, which the client skips.  A client only
+ * falls back to Turtle if no reply arrives in time, which means that the
+ * server does not know the request and will read it as (invalid) Turtle.
+ *
+ * In the atom format, every message is an LV2_Atom with its header, and
+ * URIDs are those of the sender.  Before a message that uses a URID for the
+ * first time, the sender defines it with a frame of type 0 whose body is the
+ * URID followed by its null-terminated URI.
+ *
+ * @ingroup Ingen
+ */
+enum class WireFormat {
+	TURTLE, ///< Turtle text messages (default)
+	ATOM    ///< Binary LV2 atom messages
+};
+
+/** Bytes sent by both sides to switch a connection to WireFormat::ATOM.
+ *
+ * This starts with a control character, which never occurs in Turtle.
+ */
+static constexpr const char wire_atom_magic[]  = "\001ingen-atom-1\n";
+static constexpr size_t     wire_atom_magic_len = sizeof(wire_atom_magic) - 1;
+
+/** Atom type of a frame that defines a URID rather than carrying a message. */
+static constexpr LV2_URID wire_urid_definition = 0;
+
+namespace wire {
+
+/// Maximum nesting depth of containers in a received atom
+static constexpr unsigned max_depth = 64U;
+
+/// Return true iff a child with a header and body fits in `space` bytes
+inline bool
+fits(uint32_t space, uint32_t head_size, uint32_t body_size)
+{
+	return space >= head_size && body_size <= space - head_size;
+}
+
+/// Return the size of elements of type `type` in a vector, or 0 if invalid
+inline uint32_t
+vector_child_size(const LV2_Atom_Forge& forge, LV2_URID type)
+{
+	if (type == forge.Int || type == forge.Float || type == forge.Bool) {
+		return 4U;
+	}
+
+	if (type == forge.Long || type == forge.Double) {
+		return 8U;
+	}
+
+	return (type == forge.URID) ? static_cast<uint32_t>(sizeof(LV2_URID)) : 0U;
+}
+
+template<typename F>
+bool
+for_each_urid(const LV2_Atom_Forge& forge,
+              LV2_Atom*             atom,
+              F&                    f,
+              unsigned              depth)
+{
+	const auto visit = [&f](LV2_URID& urid) {
+		if (urid) {
+			f(urid);
+		}
+	};
+
+	if (depth > max_depth) {
+		return false;
+	}
+
+	visit(atom->type);
+
+	auto* const    body = reinterpret_cast<uint8_t*>(atom + 1);
+	const uint32_t size = atom->size;
+	if (atom->type == forge.Object) {
+		if (size < sizeof(LV2_Atom_Object_Body)) {
+			return false;
+		}
+
+		visit(reinterpret_cast<LV2_Atom_Object_Body*>(body)->otype);
+		for (uint32_t o = sizeof(LV2_Atom_Object_Body); o < size;) {
+			auto* const p = reinterpret_cast<LV2_Atom_Property_Body*>(body + o);
+			if (!fits(size - o, sizeof(*p), 0U) ||
+			    !fits(size - o, sizeof(*p), p->value.size)) {
+				return false;
+			}
+
+			visit(p->key);
+			visit(p->context);
+			if (!for_each_urid(forge, &p->value, f, depth + 1U)) {
+				return false;
+			}
+
+			o += lv2_atom_pad_size(sizeof(*p) + p->value.size);
+		}
+	} else if (atom->type == forge.Tuple) {
+		for (uint32_t o = 0U; o < size;) {
+			auto* const child = reinterpret_cast<LV2_Atom*>(body + o);
+			if (!fits(size - o, sizeof(*child), 0U) ||
+			    !fits(size - o, sizeof(*child), child->size) ||
+			    !for_each_urid(forge, child, f, depth + 1U)) {
+				return false;
+			}
+
+			o += lv2_atom_pad_size(sizeof(*child) + child->size);
+		}
+	} else if (atom->type == forge.Sequence) {
+		if (size < sizeof(LV2_Atom_Sequence_Body)) {
+			return false;
+		}
+
+		visit(reinterpret_cast<LV2_Atom_Sequence_Body*>(body)->unit);
+		for (uint32_t o = sizeof(LV2_Atom_Sequence_Body); o < size;) {
+			auto* const ev = reinterpret_cast<LV2_Atom_Event*>(body + o);
+			if (!fits(size - o, sizeof(*ev), 0U) ||
+			    !fits(size - o, sizeof(*ev), ev->body.size) ||
+			    !for_each_urid(forge, &ev->body, f, depth + 1U)) {
+				return false;
+			}
+
+			o += lv2_atom_pad_size(sizeof(*ev) + ev->body.size);
+		}
+	} else if (atom->type == forge.Vector) {
+		if (size < sizeof(LV2_Atom_Vector_Body)) {
+			return false;
+		}
+
+		// Only vectors of fixed size scalars, which contain no atom headers
+		auto* const vec = reinterpret_cast<LV2_Atom_Vector_Body*>(body);
+		visit(vec->child_type);
+		const uint32_t child_size = vector_child_size(forge, vec->child_type);
+		const uint32_t n_bytes    = size - sizeof(LV2_Atom_Vector_Body);
+		if (!child_size || vec->child_size != child_size ||
+		    n_bytes % child_size) {
+			return false;
+		}
+
+		if (vec->child_type == forge.URID) {
+			auto* const ids = reinterpret_cast<LV2_URID*>(vec + 1);
+			for (uint32_t i = 0; i < n_bytes / child_size; ++i) {
+				visit(ids[i]);
+			}
+		}
+	} else if (atom->type == forge.URID) {
+		if (size < sizeof(LV2_URID)) {
+			return false;
+		}
+
+		visit(*reinterpret_cast<LV2_URID*>(body));
+	} else if (atom->type == forge.Literal) {
+		if (size < sizeof(LV2_Atom_Literal_Body)) {
+			return false;
+		}
+
+		auto* const lit = reinterpret_cast<LV2_Atom_Literal_Body*>(body);
+		visit(lit->datatype);
+		visit(lit->lang);
+	} else if (atom->type == forge.Property) {
+		auto* const prop = reinterpret_cast<LV2_Atom_Property_Body*>(body);
+		if (!fits(size, sizeof(*prop), 0U) ||
+		    !fits(size, sizeof(*prop), prop->value.size)) {
+			return false;
+		}
+
+		visit(prop->key);
+		visit(prop->context);
+		return for_each_urid(forge, &prop->value, f, depth + 1U);
+	}
+
+	return true;
+}
+
+} // namespace wire
+
+/** Call `f` with a reference to every non-zero URID in `atom`, recursively.
+ *
+ * Each URID is visited before it is used to interpret the atom, so `f` may
+ * change it to translate a received atom to local URIDs in place.  The URIDs
+ * of `forge` must be local.
+ *
+ * Received atoms are untrusted, so every child is checked to fit in the
+ * remaining space of its container, vectors must have a scalar child type of
+ * the correct size, and containers may only be nested wire::max_depth deep.
+ * The `atom->size` bytes after the header must be readable.
+ *
+ * @return False if the atom is malformed, in which case it must be rejected
+ * as a whole, since it may have only been partially visited.
+ */
+template<typename F>
+bool
+for_each_urid(const LV2_Atom_Forge& forge, LV2_Atom* atom, F&& f)
+{
+	return wire::for_each_urid(forge, atom, f, 0U);
+}
+
+} // namespace ingen
+
+#endif // INGEN_WIREFORMAT_HPP
@@ -17,10 +17,13 @@
 #ifndef INGEN_CLIENT_SOCKETCLIENT_HPP
 #define INGEN_CLIENT_SOCKETCLIENT_HPP
 
+#include <ingen/Atom.hpp>
+#include <ingen/Configuration.hpp>
 #include <ingen/Log.hpp>
 #include <ingen/SocketReader.hpp>
 #include <ingen/SocketWriter.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/WireFormat.hpp>
 #include <ingen/World.hpp>
 #include <ingen/ingen.h>
 #include <raul/Socket.hpp>
@@ -43,9 +46,13 @@ public:
 	             const URI&                           uri,
 	             const std::shared_ptr<raul::Socket>& sock,
 	             const std::shared_ptr<Interface>&    respondee)
-	    : SocketWriter(world.uri_map(), world.uris(), uri, sock)
+	    : SocketWriter(world.uri_map(), world.uris(), uri, sock, format(world))
 	    , _respondee(respondee)
-	    , _reader(world, *respondee, sock)
+	    , _reader(world,
+	              *respondee,
+	              sock,
+	              format(world),
+	              [this](WireFormat f) { set_format(f); })
 	{}
 
 	std::shared_ptr<Interface> respondee() const override {
@@ -82,6 +89,13 @@ public:
 	}
 
 private:
+	static WireFormat format(World& world) {
+		const Atom& opt = world.conf().option("wire-format");
+		return (opt.is_valid() && !strcmp(opt.ptr<char>(), "atom"))
+		           ? WireFormat::ATOM
+		           : WireFormat::TURTLE;
+	}
+
 	std::shared_ptr<Interface> _respondee;
 	SocketReader               _reader;
 };
@@ -54,7 +54,11 @@
 #define INGEN__internalContext INGEN_NS "internalContext"
 #define INGEN__loadedBundle    INGEN_NS "loadedBundle"
 #define INGEN__maxRunLoad      INGEN_NS "maxRunLoad"
+#define INGEN__maxRunTime      INGEN_NS "maxRunTime"
+#define INGEN__maxWakeups      INGEN_NS "maxWakeups"
 #define INGEN__meanRunLoad     INGEN_NS "meanRunLoad"
+#define INGEN__meanRunTime     INGEN_NS "meanRunTime"
+#define INGEN__meanWakeups     INGEN_NS "meanWakeups"
 #define INGEN__minRunLoad      INGEN_NS "minRunLoad"
 #define INGEN__numThreads      INGEN_NS "numThreads"
 #define INGEN__polyphonic      INGEN_NS "polyphonic"
@@ -62,6 +66,7 @@
 #define INGEN__prototype       INGEN_NS "prototype"
 #define INGEN__sprungLayout    INGEN_NS "sprungLayout"
 #define INGEN__tail            INGEN_NS "tail"
+#define INGEN__threadLoad      INGEN_NS "threadLoad"
 #define INGEN__uiEmbedded      INGEN_NS "uiEmbedded"
 #define INGEN__value           INGEN_NS "value"
 
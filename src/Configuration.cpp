@@ -68,10 +68,13 @@ Configuration::Configuration(Forge& forge)
 	add("atomicBundles",  "atomic-bundles", 'a', "Execute bundles atomically", GLOBAL, forge.Bool, forge.make(false));
 	add("bufferSize",     "buffer-size",    'b', "Buffer size in samples", GLOBAL, forge.Int, forge.make(1024));
 	add("clientPort",     "client-port",    'C', "Client port", GLOBAL, forge.Int, Atom());
+	add("clientQueueSize", "client-queue-size", 0, "Messages queued for each socket client", GLOBAL, forge.Int, forge.make(4096));
+	add("controlEpsilon", "control-epsilon", 0, "Smallest control output change sent before the value settles (0 for any change)", GLOBAL, forge.Float, forge.make(0.0f));
 	add("connect",        "connect",        'c', "Connect to engine URI", SESSION, forge.String, forge.alloc("unix:///tmp/ingen.sock"));
 	add("engine",         "engine",         'e', "Run (JACK) engine", SESSION, forge.Bool, forge.make(false));
 	add("enginePort",     "engine-port",    'E', "Engine listen port", GLOBAL, forge.Int, forge.make(16180));
 	add("socket",         "socket",         'S', "Engine socket path", GLOBAL, forge.String, forge.alloc("/tmp/ingen.sock"));
+	add("socketThreads",  "socket-threads",  0,  "Threads for serving socket connections (0 for one each)", GLOBAL, forge.Int, forge.make(2));
 	add("gui",            "gui",            'g', "Launch the GTK graphical interface", SESSION, forge.Bool, forge.make(false));
 	add("",               "help",           'h', "Print this help message", SESSION, forge.Bool, forge.make(false));
 	add("",               "version",        'V', "Print version information", SESSION, forge.Bool, forge.make(false));
@@ -88,6 +91,15 @@ Configuration::Configuration(Forge& forge)
 	add("dump",           "dump",           'd', "Print debug output", SESSION, forge.Bool, forge.make(false));
 	add("trace",          "trace",          't', "Show LV2 plugin trace messages", SESSION, forge.Bool, forge.make(false));
 	add("threads",        "threads",        'p', "Number of processing threads", GLOBAL, forge.Int, forge.make(default_n_threads));
+	add("dataflow",       "dataflow",        0,  "Run blocks as soon as their inputs are ready", GLOBAL, forge.Bool, forge.make(false));
+	add("waitPolicy",     "wait-policy",     0,  "Idle thread wait policy (spin, backoff, park)", GLOBAL, forge.String, forge.alloc("park"));
+	add("spinCount",      "spin-count",      0,  "Backoff rounds before an idle thread parks", GLOBAL, forge.Int, forge.make(64));
+	add("loadThreads",    "load-threads",    0,  "Threads for creating blocks when loading graphs", GLOBAL, forge.Int, forge.make(1));
+	add("minSlice",       "min-slice",       0,  "Minimum frames a block runs for between control changes (1 for sample accuracy)", GLOBAL, forge.Int, forge.make(1));
+	add("voiceRelease",   "voice-release",   0,  "Milliseconds that released voices run while silent (0 to always run all voices)", GLOBAL, forge.Int, forge.make(500));
+	add("monitorRate",    "monitor-rate",    0,  "Maximum port monitor updates per second to each client (0 for no limit)", GLOBAL, forge.Int, forge.make(25));
+	add("profile",        "profile",         0,  "Measure and publish the run time of every block", GLOBAL, forge.Bool, forge.make(false));
+	add("wireFormat",     "wire-format",     0,  "Format of socket messages to request (turtle, atom)", SESSION, forge.String, forge.alloc("turtle"));
 	add("humanNames",     "human-names",     0,  "Show human names in GUI", GUI, forge.Bool, forge.make(true));
 	add("portLabels",     "port-labels",     0,  "Show port labels in GUI", GUI, forge.Bool, forge.make(true));
 	add("graphDirectory", "graph-directory", 0,  "Default directory for opening graphs", GUI, forge.String, Atom());
@@ -125,6 +137,10 @@ Configuration::variable_string(LV2_URID type) const
 		return "=INT";
 	}
 
+	if (type == _forge.Float) {
+		return "=FLOAT";
+	}
+
 	return "";
 }
 
@@ -163,6 +179,15 @@ Configuration::set_value_from_string(Configuration::Option& option,
 			throw OptionError(fmt("Option `%1%' has non-integer value `%2%'",
 			                      option.name, value));
 		}
+	} else if (option.type == _forge.Float) {
+		char*       endptr   = nullptr;
+		const float floatval = strtof(value.c_str(), &endptr);
+		if (endptr && *endptr == '\0') {
+			option.value = _forge.make(floatval);
+		} else {
+			throw OptionError(fmt("Option `%1%' has non-numeric value `%2%'",
+			                      option.name, value));
+		}
 	} else if (option.type == _forge.String) {
 		option.value = _forge.alloc(value.c_str());
 		assert(option.value.type() == _forge.String);
@@ -20,6 +20,7 @@
 #include <ingen/Forge.hpp>
 #include <ingen/Properties.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/URIDProperties.hpp>
 #include <ingen/URIs.hpp>
 
 #include <map>
@@ -141,13 +142,16 @@ Resource::get_property(const URI& uri) const
 	return (i != _properties.end()) ? i->second : nil;
 }
 
+namespace {
+
+template <typename Props>
 bool
-Resource::type(const URIs&       uris,
-               const Properties& properties,
-               bool&             graph,
-               bool&             block,
-               bool&             port,
-               bool&             is_output)
+get_type(const URIs&  uris,
+         const Props& properties,
+         bool&        graph,
+         bool&        block,
+         bool&        port,
+         bool&        is_output)
 {
 	const auto types_range = properties.equal_range(uris.rdf_type);
 
@@ -184,6 +188,30 @@ Resource::type(const URIs&       uris,
 	return graph || block || port; // recognized type
 }
 
+} // namespace
+
+bool
+Resource::type(const URIs&       uris,
+               const Properties& properties,
+               bool&             graph,
+               bool&             block,
+               bool&             port,
+               bool&             is_output)
+{
+	return get_type(uris, properties, graph, block, port, is_output);
+}
+
+bool
+Resource::type(const URIs&           uris,
+               const URIDProperties& properties,
+               bool&                 graph,
+               bool&                 block,
+               bool&                 port,
+               bool&                 is_output)
+{
+	return get_type(uris, properties, graph, block, port, is_output);
+}
+
 void
 Resource::set_properties(const Properties& props)
 {
@@ -20,30 +20,44 @@
 #include <ingen/AtomReader.hpp>
 #include <ingen/Log.hpp>
 #include <ingen/URIMap.hpp>
+#include <ingen/WireFormat.hpp>
 #include <ingen/World.hpp>
+#include <lv2/atom/atom.h>
 #include <lv2/urid/urid.h>
 #include <raul/Socket.hpp>
 #include <serd/serd.h>
 #include <sord/sord.h>
 #include <sord/sordmm.hpp>
 
+#include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace ingen {
 
+/// Time to wait for the peer to acknowledge a request for atoms
+static constexpr std::chrono::milliseconds ack_timeout{2000};
+
 SocketReader::SocketReader(ingen::World&                 world,
                            Interface&                    iface,
-                           std::shared_ptr<raul::Socket> sock)
+                           std::shared_ptr<raul::Socket> sock,
+                           WireFormat                    format,
+                           FormatSink                    on_format)
     : _world(world)
     , _iface(iface)
     , _socket(std::move(sock))
+    , _format(format)
+    , _on_format(std::move(on_format))
     , _thread(&SocketReader::run, this)
 {}
 
@@ -81,7 +95,7 @@ SocketReader::write_statement(SocketReader*      iface,
 {
 	if (!iface->_msg_node) {
 		iface->_msg_node = sord_node_from_serd_node(
-			iface->_world.rdf_world()->c_obj(), iface->_env, subject, nullptr, nullptr);
+			iface->_sord_world, iface->_env, subject, nullptr, nullptr);
 	}
 
 	return sord_inserter_write_statement(
@@ -95,6 +109,15 @@ SocketReader::c_recv(void* buf, size_t size, size_t nmemb, void* stream)
 {
 	auto* self = static_cast<SocketReader*>(stream);
 
+	if (self->has_pending()) {
+		// Read input received during negotiation first
+		const size_t n = std::min(size * nmemb,
+		                          self->_pending.size() - self->_pending_pos);
+		memcpy(buf, self->_pending.data() + self->_pending_pos, n);
+		self->_pending_pos += n;
+		return n;
+	}
+
 	const ssize_t c = recv(self->_socket->fd(), buf, size * nmemb, MSG_WAITALL);
 	if (c < 0) {
 		self->_socket_error = errno;
@@ -112,31 +135,213 @@ SocketReader::c_err(void* stream)
 	return self->_socket_error;
 }
 
+bool
+SocketReader::recv_all(void* buf, size_t len)
+{
+	auto* ptr = static_cast<uint8_t*>(buf);
+	while (len > 0) {
+		const ssize_t c = recv(_socket->fd(), ptr, len, MSG_WAITALL);
+		if (c <= 0) {
+			_socket_error = (c < 0) ? errno : 0;
+			return false;
+		}
+
+		ptr += c;
+		len -= static_cast<size_t>(c);
+	}
+
+	return true;
+}
+
+WireFormat
+SocketReader::negotiate()
+{
+	if (_format == WireFormat::ATOM) {
+		// Skip any Turtle sent before the peer acknowledged our request
+		const auto deadline = std::chrono::steady_clock::now() + ack_timeout;
+		size_t     matched  = 0;
+		char       c        = 0;
+		while (matched < wire_atom_magic_len) {
+			if (!wait_for_input(deadline)) {
+				// Peer does not speak atoms, so read what it sent as Turtle
+				_world.log().warn("Peer did not accept atoms, using Turtle\n");
+				if (_on_format) {
+					_on_format(WireFormat::TURTLE);
+				}
+
+				return WireFormat::TURTLE;
+			}
+
+			if (!recv_all(&c, 1)) {
+				break; // Hangup, which reading atoms will notice
+			}
+
+			_pending.push_back(c);
+			if (c == wire_atom_magic[matched]) {
+				++matched;
+			} else {
+				matched = (c == wire_atom_magic[0]) ? 1 : 0;
+			}
+		}
+
+		_pending.clear();
+		return WireFormat::ATOM;
+	}
+
+	// Peek at the first byte to see if the peer is requesting atoms
+	char c = 0;
+	if (recv(_socket->fd(), &c, 1, MSG_PEEK) != 1 || c != wire_atom_magic[0]) {
+		return WireFormat::TURTLE;
+	}
+
+	char magic[wire_atom_magic_len];
+	if (!recv_all(magic, sizeof(magic)) ||
+	    memcmp(magic, wire_atom_magic, wire_atom_magic_len)) {
+		_world.log().error("Invalid wire format request\n");
+		return WireFormat::TURTLE;
+	}
+
+	if (_on_format) {
+		_on_format(WireFormat::ATOM);
+	}
+
+	return WireFormat::ATOM;
+}
+
+bool
+SocketReader::wait_for_input(std::chrono::steady_clock::time_point deadline)
+{
+	struct pollfd pfd{};
+	pfd.fd     = _socket->fd();
+	pfd.events = POLLIN|POLLPRI;
+
+	while (true) {
+		const auto remaining =
+			std::chrono::duration_cast<std::chrono::milliseconds>(
+				deadline - std::chrono::steady_clock::now());
+		if (remaining.count() <= 0) {
+			return false;
+		}
+
+		const int ret = poll(&pfd, 1, static_cast<int>(remaining.count()));
+		if (ret != 0 && !(ret < 0 && errno == EINTR)) {
+			return true; // Input, hangup, or error which recv() will report
+		}
+	}
+}
+
 void
 SocketReader::run()
 {
-	Sord::World*  world = _world.rdf_world();
-	LV2_URID_Map& map   = _world.uri_map().urid_map();
+	if (negotiate() == WireFormat::ATOM) {
+		run_atoms();
+	} else {
+		run_turtle();
+	}
+}
 
-	// Set up a forge to build LV2 atoms from model
-	SordNode*  base_uri = nullptr;
-	SordModel* model    = nullptr;
-	AtomForge  forge(map);
+void
+SocketReader::run_atoms()
+{
+	static constexpr uint32_t max_message_size = 1U << 24U;
+
+	LV2_URID_Map& map = _world.uri_map().urid_map();
+	AtomForge     forge(map);
+	AtomReader    ar(_world.uri_map(), _world.uris(), _world.log(), _iface);
+
+	std::unordered_map<LV2_URID, LV2_URID> urids; // Peer URID => local URID
+	std::vector<uint64_t>                  buf;   // Aligned message buffer
+
+	LV2_Atom head{};
+	while (!_exit_flag && recv_all(&head, sizeof(head))) {
+		if (head.size > max_message_size) {
+			_world.log().error("Message too large (%1% bytes)\n", head.size);
+			break;
+		}
+
+		// Read body after header in buffer
+		buf.resize(1U + ((sizeof(LV2_Atom) + head.size) / sizeof(uint64_t)));
+		auto* const atom = reinterpret_cast<LV2_Atom*>(buf.data());
+		*atom = head;
+		if (!recv_all(atom + 1, head.size)) {
+			break;
+		}
+
+		if (head.type == wire_urid_definition) {
+			// Map the URI of a peer URID
+			const auto* const body = reinterpret_cast<const char*>(atom + 1);
+			if (head.size <= sizeof(LV2_URID) || body[head.size - 1]) {
+				_world.log().error("Invalid URID definition\n");
+				continue;
+			}
+
+			LV2_URID peer_urid = 0;
+			memcpy(&peer_urid, body, sizeof(peer_urid));
+			urids[peer_urid] = map.map(map.handle, body + sizeof(peer_urid));
+			continue;
+		}
+
+		// Translate peer URIDs in message to local URIDs
+		bool       defined = true;
+		const bool valid   = for_each_urid(
+			forge, atom, [&urids, &defined](LV2_URID& urid) {
+				const auto u = urids.find(urid);
+				if (u != urids.end()) {
+					urid = u->second;
+				} else {
+					defined = false;
+				}
+			});
+
+		if (!valid) {
+			_world.log().error("Invalid atom message\n");
+			continue;
+		}
+
+		if (!defined) {
+			_world.log().error("Message with undefined URID\n");
+			continue;
+		}
+
+		// Call _iface methods based on atom content
+		ar.write(atom);
+	}
+
+	if (!_exit_flag) {
+		on_hangup();
+	}
+
+	_socket.reset();
+}
+
+void
+SocketReader::run_turtle()
+{
+	// Parse into a private world, so connections never contend for the RDF lock
+	Sord::World   world;
+	LV2_URID_Map& map = _world.uri_map().urid_map();
+
+	_sord_world = world.c_obj();
+	_env        = world.prefixes().c_obj();
 	{
-		// Lock RDF world
+		// Lock RDF world just long enough to copy the standard prefixes
 		const std::lock_guard<std::mutex> lock{_world.rdf_mutex()};
 
-		// Use <ingen:/> as base URI, so relative URIs are like bundle paths
-		base_uri = sord_new_uri(world->c_obj(),
-		                        reinterpret_cast<const uint8_t*>("ingen:/"));
+		serd_env_foreach(_world.rdf_world()->prefixes().c_obj(),
+		                 reinterpret_cast<SerdPrefixSink>(serd_env_set_prefix),
+		                 _env);
+	}
+
+	// Use <ingen:/> as base URI, so relative URIs are like bundle paths
+	SordNode* base_uri =
+		sord_new_uri(world.c_obj(), reinterpret_cast<const uint8_t*>("ingen:/"));
 
-		// Make a model and reader to parse the next Turtle message
-		_env = world->prefixes().c_obj();
-		model = sord_new(world->c_obj(), SORD_SPO, false);
+	// Make a model and an inserter for writing incoming triples to it
+	SordModel* model = sord_new(world.c_obj(), SORD_SPO, false);
+	_inserter        = sord_inserter_new(model, _env);
 
-		// Create an inserter for writing incoming triples to model
-		_inserter = sord_inserter_new(model, _env);
-	}
+	// Set up a forge to build LV2 atoms from model
+	AtomForge forge(map);
 
 	SerdReader* reader = serd_reader_new(
 		SERD_TURTLE, this, nullptr,
@@ -163,8 +368,8 @@ SocketReader::run()
 	pfd.revents = 0;
 
 	while (!_exit_flag && !_socket_error) {
-		// Wait for input to arrive at socket
-		const int ret = poll(&pfd, 1, -1);
+		// Wait for input to arrive at socket, unless some is already pending
+		const int ret = has_pending() ? 1 : poll(&pfd, 1, -1);
 		if (ret == -1 || (pfd.revents & (POLLERR|POLLHUP|POLLNVAL))) {
 			on_hangup();
 			break; // Hangup
@@ -174,9 +379,6 @@ SocketReader::run()
 			continue; // No data, shouldn't happen
 		}
 
-		// Lock RDF world
-		const std::lock_guard<std::mutex> lock{_world.rdf_mutex()};
-
 		// Read until the next '.'
 		const SerdStatus st = serd_reader_read_chunk(reader);
 		if (st == SERD_FAILURE || !_msg_node) {
@@ -189,25 +391,26 @@ SocketReader::run()
 		}
 
 		// Build an LV2_Atom at chunk.buf from the message
-		forge.read(*world, model, _msg_node);
+		forge.read(world, model, _msg_node);
 
 		// Call _iface methods based on atom content
 		ar.write(forge.atom());
 
 		// Reset everything for the next iteration
 		forge.clear();
-		sord_node_free(world->c_obj(), _msg_node);
+		sord_node_free(world.c_obj(), _msg_node);
 		_msg_node = nullptr;
 	}
 
-	// Lock RDF world
-	const std::lock_guard<std::mutex> lock{_world.rdf_mutex()};
-
 	// Destroy everything
 	sord_inserter_free(_inserter);
 	serd_reader_end_stream(reader);
 	serd_reader_free(reader);
+	sord_node_free(world.c_obj(), base_uri);
 	sord_free(model);
+	_inserter   = nullptr;
+	_env        = nullptr;
+	_sord_world = nullptr;
 	_socket.reset();
 }
 
@@ -19,9 +19,18 @@
 #include <ingen/Message.hpp>
 #include <ingen/TurtleWriter.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/URIMap.hpp>
+#include <ingen/WireFormat.hpp>
+#include <lv2/atom/atom.h>
+#include <lv2/atom/forge.h>
+#include <lv2/atom/util.h>
+#include <lv2/urid/urid.h>
 #include <raul/Socket.hpp>
 
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <mutex>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <utility>
@@ -36,30 +45,111 @@ namespace ingen {
 SocketWriter::SocketWriter(URIMap&                       map,
                            URIs&                         uris,
                            const URI&                    uri,
-                           std::shared_ptr<raul::Socket> sock)
+                           std::shared_ptr<raul::Socket> sock,
+                           WireFormat                    format)
 	: TurtleWriter(map, uris, uri)
 	, _socket(std::move(sock))
-{}
+{
+	lv2_atom_forge_init(&_types, &map.urid_map());
+
+	if (format == WireFormat::ATOM) {
+		// Request atoms from the peer, and send them from now on
+		send_all(wire_atom_magic, wire_atom_magic_len);
+		_format = WireFormat::ATOM;
+	}
+}
+
+void
+SocketWriter::set_format(WireFormat format)
+{
+	const std::lock_guard<std::mutex> lock{_mutex};
+	if (format != _format) {
+		if (format == WireFormat::ATOM) {
+			// Acknowledge request now, so the peer knows where atoms start
+			send_all(wire_atom_magic, wire_atom_magic_len);
+		}
+		_format = format;
+	}
+}
 
 void
 SocketWriter::message(const Message& message)
 {
+	const std::lock_guard<std::mutex> lock{_mutex};
+
 	TurtleWriter::message(message);
-	if (std::get_if<BundleEnd>(&message)) {
+	if (_format == WireFormat::TURTLE && std::get_if<BundleEnd>(&message)) {
 		// Send a null byte to indicate end of bundle
 		const char end[] = { 0 };
-		send(_socket->fd(), end, 1, MSG_NOSIGNAL);
+		send_all(end, 1);
 	}
 }
 
+bool
+SocketWriter::write(const LV2_Atom* msg, int32_t default_id)
+{
+	return (_format == WireFormat::ATOM) ? write_atom(msg)
+	                                     : TurtleWriter::write(msg, default_id);
+}
+
+bool
+SocketWriter::write_atom(const LV2_Atom* msg)
+{
+	_frames.clear();
+
+	// Define URIDs first used by this message (the walk does not modify it)
+	LV2_URID_Unmap& unmap = _map.urid_unmap();
+	for_each_urid(
+	    _types, const_cast<LV2_Atom*>(msg), [this, &unmap](LV2_URID& urid) {
+		    if (!_defined.insert(urid).second) {
+			    return;
+		    }
+
+		    const char* const uri = unmap.unmap(unmap.handle, urid);
+		    if (!uri) {
+			    return; // Peer will reject message with undefined URID
+		    }
+
+		    const auto     uri_len = static_cast<uint32_t>(strlen(uri) + 1);
+		    const LV2_Atom head{static_cast<uint32_t>(sizeof(urid) + uri_len),
+		                        wire_urid_definition};
+
+		    const auto* const h = reinterpret_cast<const uint8_t*>(&head);
+		    const auto* const u = reinterpret_cast<const uint8_t*>(&urid);
+		    const auto* const s = reinterpret_cast<const uint8_t*>(uri);
+		    _frames.insert(_frames.end(), h, h + sizeof(head));
+		    _frames.insert(_frames.end(), u, u + sizeof(urid));
+		    _frames.insert(_frames.end(), s, s + uri_len);
+	    });
+
+	// Append message
+	const auto* const m = reinterpret_cast<const uint8_t*>(msg);
+	_frames.insert(_frames.end(), m, m + lv2_atom_total_size(msg));
+
+	return send_all(_frames.data(), _frames.size());
+}
+
+bool
+SocketWriter::send_all(const void* buf, size_t len)
+{
+	const auto* ptr = static_cast<const uint8_t*>(buf);
+	while (len > 0) {
+		const ssize_t ret = send(_socket->fd(), ptr, len, MSG_NOSIGNAL);
+		if (ret <= 0) {
+			return false;
+		}
+
+		ptr += ret;
+		len -= static_cast<size_t>(ret);
+	}
+
+	return true;
+}
+
 size_t
 SocketWriter::text_sink(const void* buf, size_t len)
 {
-	const ssize_t ret = send(_socket->fd(), buf, len, MSG_NOSIGNAL);
-	if (ret < 0) {
-		return 0;
-	}
-	return ret;
+	return send_all(buf, len) ? len : 0;
 }
 
 } // namespace ingen
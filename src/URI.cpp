@@ -21,9 +21,39 @@
 #include <sord/sordmm.hpp>
 
 #include <cassert>
+#include <cstdint>
 
 namespace ingen {
 
+namespace {
+
+/// Return `chunk` moved from the buffer of node `from` to that of node `to`
+SerdChunk
+rebase_chunk(const SerdChunk& chunk, const SerdNode& from, const SerdNode& to)
+{
+	const auto begin = reinterpret_cast<uintptr_t>(from.buf);
+	const auto ptr   = reinterpret_cast<uintptr_t>(chunk.buf);
+	if (!chunk.buf || ptr < begin || ptr > begin + from.n_bytes) {
+		return chunk;
+	}
+
+	return {to.buf + (ptr - begin), chunk.len};
+}
+
+/// Return the parsed `uri` of node `from`, moved to the identical node `to`
+SerdURI
+rebase_uri(const SerdURI& uri, const SerdNode& from, const SerdNode& to)
+{
+	return {rebase_chunk(uri.scheme, from, to),
+	        rebase_chunk(uri.authority, from, to),
+	        rebase_chunk(uri.path_base, from, to),
+	        rebase_chunk(uri.path, from, to),
+	        rebase_chunk(uri.query, from, to),
+	        rebase_chunk(uri.fragment, from, to)};
+}
+
+} // namespace
+
 URI::URI() : _uri(SERD_URI_NULL), _node(SERD_NODE_NULL) {}
 
 URI::URI(const std::string& str)
@@ -76,9 +106,13 @@ URI::URI(const FilePath& path)
 {
 }
 
+/* Copies duplicate the node and point the parsed URI into the copy, rather
+   than serialising and parsing it again, since properties are copied often. */
+
 URI::URI(const URI& uri)
-    : _uri(SERD_URI_NULL), _node(serd_node_new_uri(&uri._uri, nullptr, &_uri))
+    : _uri(SERD_URI_NULL), _node(serd_node_copy(&uri._node))
 {
+	_uri = rebase_uri(uri._uri, uri._node, _node);
 }
 
 URI&
@@ -86,7 +120,8 @@ URI::operator=(const URI& uri)
 {
 	if (&uri != this) {
 		serd_node_free(&_node);
-		_node = serd_node_new_uri(&uri._uri, nullptr, &_uri);
+		_node = serd_node_copy(&uri._node);
+		_uri  = rebase_uri(uri._uri, uri._node, _node);
 	}
 
 	return *this;
@@ -107,7 +107,11 @@ URIs::URIs(Forge& ingen_forge, URIMap* map, LilvWorld* lworld)
 	, ingen_internalContext (forge, map, lworld, INGEN__internalContext)
 	, ingen_loadedBundle    (forge, map, lworld, INGEN__loadedBundle)
 	, ingen_maxRunLoad      (forge, map, lworld, INGEN__maxRunLoad)
+	, ingen_maxRunTime      (forge, map, lworld, INGEN__maxRunTime)
+	, ingen_maxWakeups      (forge, map, lworld, INGEN__maxWakeups)
 	, ingen_meanRunLoad     (forge, map, lworld, INGEN__meanRunLoad)
+	, ingen_meanRunTime     (forge, map, lworld, INGEN__meanRunTime)
+	, ingen_meanWakeups     (forge, map, lworld, INGEN__meanWakeups)
 	, ingen_minRunLoad      (forge, map, lworld, INGEN__minRunLoad)
 	, ingen_numThreads      (forge, map, lworld, INGEN__numThreads)
 	, ingen_polyphonic      (forge, map, lworld, INGEN__polyphonic)
@@ -115,6 +119,7 @@ URIs::URIs(Forge& ingen_forge, URIMap* map, LilvWorld* lworld)
 	, ingen_prototype       (forge, map, lworld, INGEN__prototype)
 	, ingen_sprungLayout    (forge, map, lworld, INGEN__sprungLayout)
 	, ingen_tail            (forge, map, lworld, INGEN__tail)
+	, ingen_threadLoad      (forge, map, lworld, INGEN__threadLoad)
 	, ingen_uiEmbedded      (forge, map, lworld, INGEN__uiEmbedded)
 	, ingen_value           (forge, map, lworld, INGEN__value)
 	, log_Error             (forge, map, lworld, LV2_LOG__Error)
@@ -122,6 +122,19 @@
 #		endif
 #	endif
 
+// Linux epoll
+#	ifndef HAVE_EPOLL
+#		ifdef __has_include
+#			if __has_include("sys/epoll.h")
+#				define HAVE_EPOLL 1
+#			else
+#				define HAVE_EPOLL 0
+#			endif
+#		else
+#			define HAVE_EPOLL 0
+#		endif
+#	endif
+
 // Webkit
 #	ifndef HAVE_WEBKIT
 #		ifdef __has_include
@@ -168,6 +181,12 @@
 #	define USE_ISATTY 0
 #endif
 
+#if defined(HAVE_EPOLL)
+#	define USE_EPOLL HAVE_EPOLL
+#else
+#	define USE_EPOLL 0
+#endif
+
 #if defined(HAVE_POSIX_MEMALIGN)
 #	define USE_POSIX_MEMALIGN HAVE_POSIX_MEMALIGN
 #else
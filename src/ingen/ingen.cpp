@@ -202,9 +202,19 @@ run(int argc, char** argv)
 		engine_interface->get(URI("ingen:/plugins"));
 		engine_interface->get(main_uri());
 
+		// Load in a bundle so the engine can create blocks in parallel
+		const bool bundle = conf.option("load-threads").get<int32_t>() > 1;
+		if (bundle) {
+			engine_interface->bundle_begin();
+		}
+
 		const std::lock_guard<std::mutex> lock{world->rdf_mutex()};
 		world->parser()->parse_file(
 			*world, *engine_interface, graph, parent, symbol);
+
+		if (bundle) {
+			engine_interface->bundle_end();
+		}
 	} else if (conf.option("server-load").is_valid()) {
 		const char* path = conf.option("server-load").ptr<char>();
 		if (serd_uri_string_has_scheme(reinterpret_cast<const uint8_t*>(path))) {
@@ -0,0 +1,139 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_BACKOFF_HPP
+#define INGEN_ENGINE_BACKOFF_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#endif
+
+namespace ingen::server {
+
+/** How a run context waits when there is no work available. */
+enum class WaitPolicy {
+	SPIN,    ///< Busy-wait, lowest latency but burns a core while idle
+	BACKOFF, ///< Spin with exponential backoff, then yield to the scheduler
+	PARK,    ///< Spin with exponential backoff, then sleep until signalled
+};
+
+/** Parse a wait policy name ("spin", "backoff", or "park"). */
+inline WaitPolicy
+parse_wait_policy(const char* name)
+{
+	if (name && !strcmp(name, "spin")) {
+		return WaitPolicy::SPIN;
+	}
+
+	if (name && !strcmp(name, "backoff")) {
+		return WaitPolicy::BACKOFF;
+	}
+
+	return WaitPolicy::PARK;
+}
+
+/** Bounded spinning with exponential backoff for idle run contexts.
+ *
+ * Each call to pause() waits a little longer than the last, doubling the
+ * number of CPU pause instructions up to a limit.  After `spin_limit` rounds,
+ * the behaviour depends on the policy: SPIN and BACKOFF keep trying (the
+ * latter yielding the CPU), while PARK tells the caller to go to sleep.
+ *
+ * Since pause() may yield, only worker threads use it.  Code that may run in
+ * the audio thread uses spin(), which never leaves the CPU.
+ *
+ * \ingroup engine
+ */
+class Backoff
+{
+public:
+	Backoff(WaitPolicy policy, uint32_t spin_limit)
+		: _policy(policy)
+		, _spin_limit(spin_limit)
+	{}
+
+	/** Wait a moment after failing to find work.
+	 *
+	 * @return true if the caller should try again, false if it should park.
+	 */
+	bool pause() {
+		if (_policy == WaitPolicy::SPIN) {
+			cpu_relax();
+			return true;
+		}
+
+		if (_round < _spin_limit) {
+			const uint32_t n_pauses = 1U << std::min(_round, max_shift);
+			for (uint32_t i = 0; i < n_pauses; ++i) {
+				cpu_relax();
+			}
+			++_round;
+			return true;
+		}
+
+		if (_policy == WaitPolicy::BACKOFF) {
+			std::this_thread::yield();
+			return true;
+		}
+
+		return false;
+	}
+
+	/** Wait a moment without ever yielding or parking.
+	 *
+	 * This backs off like pause(), but keeps spinning with the longest pause
+	 * once the limit is reached, regardless of the policy.
+	 */
+	void spin() {
+		const uint32_t n_pauses = 1U << std::min(_round, max_shift);
+		for (uint32_t i = 0; i < n_pauses; ++i) {
+			cpu_relax();
+		}
+		if (_round < max_shift) {
+			++_round;
+		}
+	}
+
+	/** Reset after successfully finding work. */
+	void reset() { _round = 0; }
+
+	WaitPolicy policy() const { return _policy; }
+
+	/** Hint to the CPU that this is a spin-wait loop. */
+	static void cpu_relax() {
+#if defined(__SSE2__) || defined(_M_X64)
+		_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+		__asm__ __volatile__("yield");
+#endif
+	}
+
+private:
+	static constexpr uint32_t max_shift = 6U; ///< At most 64 pauses per round
+
+	WaitPolicy _policy;
+	uint32_t   _spin_limit;
+	uint32_t   _round{0};
+};
+
+} // namespace ingen::server
+
+#endif // INGEN_ENGINE_BACKOFF_HPP
@@ -18,15 +18,18 @@
 
 #include "InternalPlugin.hpp"
 #include "LV2Plugin.hpp"
+#include "PluginCache.hpp"
 #include "PluginImpl.hpp"
 #include "PortType.hpp"
 #include "ThreadManager.hpp"
 
+#include <ingen/FilePath.hpp>
 #include <ingen/LV2Features.hpp>
 #include <ingen/Log.hpp>
 #include <ingen/URI.hpp>
 #include <ingen/URIs.hpp>
 #include <ingen/World.hpp>
+#include <ingen/runtime_paths.hpp>
 #include <internals/BlockDelay.hpp>
 #include <internals/Controller.hpp>
 #include <internals/Note.hpp>
@@ -38,6 +41,7 @@
 #include <cstdint>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -46,7 +50,11 @@ namespace ingen::server {
 
 BlockFactory::BlockFactory(ingen::World& world)
 	: _world(world)
+	, _cache(user_cache_dir().empty()
+	             ? FilePath{}
+	             : user_cache_dir() / "ingen" / "plugins.cache")
 {
+	_cache.load();
 	load_internal_plugins();
 }
 
@@ -102,6 +110,12 @@ BlockFactory::plugin(const URI& uri)
 	return ((i != _plugins.end()) ? i->second.get() : nullptr);
 }
 
+void
+BlockFactory::add_plugin(const std::shared_ptr<PluginImpl>& plugin)
+{
+	_plugins.emplace(plugin->uri(), plugin);
+}
+
 void
 BlockFactory::load_internal_plugins()
 {
@@ -132,6 +146,8 @@ BlockFactory::load_plugin(const URI& uri)
 		return;
 	}
 
+	const std::lock_guard<std::mutex> lock{_lilv_mutex};
+
 	LilvNode*          node  = lilv_new_uri(_world.lilv_world(), uri.c_str());
 	const LilvPlugins* plugs = lilv_world_get_all_plugins(_world.lilv_world());
 	const LilvPlugin*  plug  = lilv_plugins_get_by_uri(plugs, node);
@@ -142,13 +158,26 @@ BlockFactory::load_plugin(const URI& uri)
 	lilv_node_free(node);
 }
 
+std::mutex&
+BlockFactory::library_mutex(const LilvPlugin* plugin)
+{
+	const LilvNode* const lib = lilv_plugin_get_library_uri(plugin);
+	const std::string     key = lib ? lilv_node_as_uri(lib) : "";
+
+	auto& mutex = _library_mutexes[key];
+	if (!mutex) {
+		mutex = std::make_unique<std::mutex>();
+	}
+
+	return *mutex;
+}
+
 /** Loads information about all LV2 plugins into internal plugin database.
  */
 void
 BlockFactory::load_lv2_plugins()
 {
 	// Build an array of port type nodes for checking compatibility
-	using Types = std::vector<std::shared_ptr<LilvNode>>;
 	Types types;
 	for (auto t = static_cast<unsigned>(PortType::AUDIO);
 	     t <= static_cast<unsigned>(PortType::ATOM);
@@ -158,57 +187,42 @@ BlockFactory::load_lv2_plugins()
 		    lilv_new_uri(_world.lilv_world(), uri.c_str()), lilv_node_free));
 	}
 
+	using Status = PluginCache::Entry::Status;
+
+	_cache.revalidate();
+
 	const LilvPlugins* plugins = lilv_world_get_all_plugins(_world.lilv_world());
 	LILV_FOREACH (plugins, i, plugins) {
 		const LilvPlugin* lv2_plug = lilv_plugins_get(plugins, i);
 		const URI         uri(lilv_node_as_uri(lilv_plugin_get_uri(lv2_plug)));
-
-		// Ignore plugins that require features Ingen doesn't support
-		LilvNodes* features  = lilv_plugin_get_required_features(lv2_plug);
-		bool       supported = true;
-		LILV_FOREACH (nodes, f, features) {
-			const char* feature = lilv_node_as_uri(lilv_nodes_get(features, f));
-			if (!_world.lv2_features().is_supported(feature)) {
-				supported = false;
-				_world.log().warn("Ignoring <%1%>; required feature <%2%>\n",
-				                  uri, feature);
-				break;
-			}
-		}
-		lilv_nodes_free(features);
-		if (!supported) {
-			continue;
+		const std::string bundle(
+			lilv_node_as_uri(lilv_plugin_get_bundle_uri(lv2_plug)));
+
+		// Check plugin if it is not cached, or missed a feature we now support
+		const PluginCache::Entry* cached = _cache.find(bundle, uri);
+		PluginCache::Entry        entry  = cached ? *cached : PluginCache::Entry{};
+		if (!cached || (entry.status == Status::UNSUPPORTED_FEATURE &&
+		                _world.lv2_features().is_supported(entry.detail))) {
+			entry = check_lv2_plugin(lv2_plug, types);
+			_cache.insert(bundle, uri, entry);
 		}
 
-		// Ignore plugins that are missing ports
-		if (!lilv_plugin_get_port_by_index(lv2_plug, 0)) {
-			_world.log().warn("Ignoring <%1%>; missing or corrupt ports\n",
-			                  uri);
+		// Ignore plugins that require features Ingen doesn't support
+		if (entry.status == Status::UNSUPPORTED_FEATURE) {
+			_world.log().warn("Ignoring <%1%>; required feature <%2%>\n",
+			                  uri, entry.detail);
 			continue;
 		}
 
-		const uint32_t n_ports = lilv_plugin_get_num_ports(lv2_plug);
-		for (uint32_t p = 0; p < n_ports; ++p) {
-			const LilvPort* port = lilv_plugin_get_port_by_index(lv2_plug, p);
-			supported =
-			    std::any_of(types.begin(),
-			                types.end(),
-			                [&lv2_plug, &port](const auto& t) {
-				                return lilv_port_is_a(lv2_plug, port, t.get());
-			                });
-
-			if (!supported &&
-			    !lilv_port_has_property(lv2_plug,
-			                            port,
-			                            _world.uris().lv2_connectionOptional)) {
+		// Ignore plugins that are missing ports or have unsupported ones
+		if (entry.status == Status::UNSUPPORTED_PORT) {
+			if (entry.detail.empty()) {
+				_world.log().warn("Ignoring <%1%>; missing or corrupt ports\n",
+				                  uri);
+			} else {
 				_world.log().warn("Ignoring <%1%>; unsupported port <%2%>\n",
-				                  uri,
-				                  lilv_node_as_string(
-					                  lilv_port_get_symbol(lv2_plug, port)));
-				break;
+				                  uri, entry.detail);
 			}
-		}
-		if (!supported) {
 			continue;
 		}
 
@@ -221,7 +235,55 @@ BlockFactory::load_lv2_plugins()
 		}
 	}
 
+	_cache.save();
+
 	_world.log().info("Loaded %1% plugins\n", _plugins.size());
 }
 
+PluginCache::Entry
+BlockFactory::check_lv2_plugin(const LilvPlugin* lv2_plug,
+                               const Types&      types) const
+{
+	using Status = PluginCache::Entry::Status;
+
+	// Check that all required features are supported
+	LilvNodes* features = lilv_plugin_get_required_features(lv2_plug);
+	LILV_FOREACH (nodes, f, features) {
+		const char* feature = lilv_node_as_uri(lilv_nodes_get(features, f));
+		if (!_world.lv2_features().is_supported(feature)) {
+			PluginCache::Entry entry{Status::UNSUPPORTED_FEATURE, feature};
+			lilv_nodes_free(features);
+			return entry;
+		}
+	}
+	lilv_nodes_free(features);
+
+	// Check that ports are present
+	if (!lilv_plugin_get_port_by_index(lv2_plug, 0)) {
+		return {Status::UNSUPPORTED_PORT, {}};
+	}
+
+	// Check that all ports are of a supported type or optional
+	const uint32_t n_ports = lilv_plugin_get_num_ports(lv2_plug);
+	for (uint32_t p = 0; p < n_ports; ++p) {
+		const LilvPort* port = lilv_plugin_get_port_by_index(lv2_plug, p);
+		const bool      supported =
+		    std::any_of(types.begin(),
+		                types.end(),
+		                [&lv2_plug, &port](const auto& t) {
+			                return lilv_port_is_a(lv2_plug, port, t.get());
+		                });
+
+		if (!supported &&
+		    !lilv_port_has_property(lv2_plug,
+		                            port,
+		                            _world.uris().lv2_connectionOptional)) {
+			return {Status::UNSUPPORTED_PORT,
+			        lilv_node_as_string(lilv_port_get_symbol(lv2_plug, port))};
+		}
+	}
+
+	return {Status::SUPPORTED, {}};
+}
+
 } // namespace ingen::server
@@ -17,12 +17,18 @@
 #ifndef INGEN_ENGINE_BLOCKFACTORY_HPP
 #define INGEN_ENGINE_BLOCKFACTORY_HPP
 
+#include "PluginCache.hpp"
+
 #include <ingen/URI.hpp>
+#include <lilv/lilv.h>
 #include <raul/Noncopyable.hpp>
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace ingen {
 
@@ -56,13 +62,46 @@ public:
 
 	PluginImpl* plugin(const URI& uri);
 
+	/** Add a plugin that is implemented outside the engine, such as in tests.
+	 *
+	 * This must be called before any block of the plugin is created.
+	 */
+	void add_plugin(const std::shared_ptr<PluginImpl>& plugin);
+
+	/** Return the mutex that must be held while using the LV2 world.
+	 *
+	 * Lilv is not thread-safe, but blocks may be created in parallel when
+	 * loading graphs, so anything that may run at the same time as a
+	 * BlockLoader job must hold this.
+	 */
+	std::mutex& lilv_mutex() { return _lilv_mutex; }
+
+	/** Return the mutex for calling into plugins from the same library.
+	 *
+	 * Plugins in one library may share state that is not thread-safe, so
+	 * this serialises slow calls like state restoration per library.  The
+	 * lilv mutex must be held.
+	 */
+	std::mutex& library_mutex(const LilvPlugin* plugin);
+
 private:
+	using Types = std::vector<std::shared_ptr<LilvNode>>;
+
 	void load_lv2_plugins();
 	void load_internal_plugins();
 
-	Plugins       _plugins;
-	ingen::World& _world;
-	bool          _has_loaded{false};
+	/** Check if an LV2 plugin has only supported features and port types. */
+	PluginCache::Entry check_lv2_plugin(const LilvPlugin* lv2_plug,
+	                                    const Types&      types) const;
+
+	using LibraryMutexes = std::map<std::string, std::unique_ptr<std::mutex>>;
+
+	Plugins        _plugins;
+	ingen::World&  _world;
+	PluginCache    _cache;
+	std::mutex     _lilv_mutex;
+	LibraryMutexes _library_mutexes;
+	bool           _has_loaded{false};
 };
 
 } // namespace server
@@ -17,13 +17,19 @@
 #include "BlockImpl.hpp"
 
 #include "Buffer.hpp"
+#include "BufferFactory.hpp"
+#include "Engine.hpp"
 #include "GraphImpl.hpp"
+#include "OffsetSet.hpp"
 #include "PluginImpl.hpp"
 #include "PortImpl.hpp"
 #include "PortType.hpp"
 #include "RunContext.hpp"
 #include "ThreadManager.hpp"
 
+#include <ingen/Forge.hpp>
+#include <ingen/Properties.hpp>
+#include <ingen/URIs.hpp>
 #include <lv2/urid/urid.h>
 #include <raul/Array.hpp>
 #include <raul/Symbol.hpp>
@@ -87,6 +93,9 @@ BlockImpl::activate(BufferFactory& bufs)
 		PortImpl* const port = _ports->at(p);
 		port->activate(bufs);
 	}
+
+	_engine = &bufs.engine();
+	_engine->add_profiled_block(this);
 }
 
 void
@@ -97,6 +106,10 @@ BlockImpl::deactivate()
 		PortImpl* const port = _ports->at(p);
 		port->deactivate();
 	}
+
+	if (_engine) {
+		_engine->remove_profiled_block(this);
+	}
 }
 
 bool
@@ -237,16 +250,110 @@ BlockImpl::process(RunContext& ctx)
 		return;
 	}
 
-	RunContext subcontext(ctx);
-	for (SampleCount offset = 0; offset < ctx.nframes();) {
-		// Find earliest offset of a value change
-		SampleCount chunk_end = ctx.nframes();
+	process_voices(ctx, 0, _polyphony);
+	post_process(ctx);
+}
+
+void
+BlockImpl::process_voices(RunContext& ctx, uint32_t begin, uint32_t end)
+{
+	// Run each range of consecutive active voices, and silence the others
+	end = std::min(end, _polyphony);
+	for (uint32_t v = begin; v < end;) {
+		if (!voice_active(ctx, v)) {
+			silence_voice(v++);
+			continue;
+		}
+
+		uint32_t run_end = v + 1;
+		while (run_end < end && voice_active(ctx, run_end)) {
+			++run_end;
+		}
+
+		for (uint32_t w = v; w < std::min(run_end, VoiceMask::max_voices); ++w) {
+			_silent[w] = false;
+		}
+
+		process_chunks(ctx, v, run_end);
+		v = run_end;
+	}
+}
+
+bool
+BlockImpl::voice_active(const RunContext& ctx, uint32_t voice) const
+{
+	return _polyphony < 2 || !voices_independent() ||
+	       parent_graph()->voice_mask().active(voice, ctx.start());
+}
+
+void
+BlockImpl::listen(const RunContext& ctx, uint32_t voice, const Buffer& buf) const
+{
+	if (_polyphony < 2 || !voices_independent() || !buf.is_audio()) {
+		return;
+	}
+
+	VoiceMask& mask = parent_graph()->voice_mask();
+	if (mask.released(voice, ctx.end()) &&
+	    buf.peak(ctx) > VoiceMask::silence) {
+		mask.touch(voice, ctx.end());
+	}
+}
+
+void
+BlockImpl::silence_voice(uint32_t voice)
+{
+	if (voice >= VoiceMask::max_voices || _silent[voice]) {
+		return;
+	}
+
+	// Clear signal outputs once, events are cleared every cycle anyway
+	for (uint32_t i = 0; _ports && i < _ports->size(); ++i) {
+		const PortImpl* const port = _ports->at(i);
+		if (port->is_output() && voice < port->poly() &&
+		    (port->is_a(PortType::AUDIO) || port->is_a(PortType::CV))) {
+			port->buffer(voice)->clear();
+		}
+	}
+
+	_silent[voice] = true;
+}
+
+void
+BlockImpl::process_chunks(RunContext& ctx, uint32_t begin, uint32_t end)
+{
+	const SampleCount nframes   = ctx.nframes();
+	const SampleCount min_slice = ctx.engine().min_slice();
+	const float       epsilon   = ctx.engine().control_epsilon();
+
+	// Find all offsets of value changes at once, if there is space for them
+	OffsetSet& changes = ctx.value_offsets();
+	const bool merged  = changes.capacity() >= nframes;
+	if (merged) {
+		changes.clear(nframes);
 		for (uint32_t i = 0; _ports && i < _ports->size(); ++i) {
 			const PortImpl* const port = _ports->at(i);
 			if (port->type() == PortType::CONTROL && port->is_input()) {
-				const SampleCount o = port->next_value_offset(
-					offset, ctx.nframes());
-				chunk_end = std::min(o, chunk_end);
+				port->value_offsets(nframes, begin, end, changes);
+			}
+		}
+	}
+
+	RunContext subcontext(ctx);
+	for (SampleCount offset = 0; offset < nframes;) {
+		// Find earliest offset of a value change at least min_slice away
+		const SampleCount earliest  = offset + min_slice;
+		SampleCount       chunk_end = nframes;
+		if (earliest < nframes && merged) {
+			chunk_end = changes.next(earliest, nframes);
+		} else if (earliest < nframes) {
+			for (uint32_t i = 0; _ports && i < _ports->size(); ++i) {
+				const PortImpl* const port = _ports->at(i);
+				if (port->type() == PortType::CONTROL && port->is_input()) {
+					const SampleCount o = port->next_value_offset(
+						earliest - 1, nframes, begin, end);
+					chunk_end = std::min(o, chunk_end);
+				}
 			}
 		}
 
@@ -255,29 +362,24 @@ BlockImpl::process(RunContext& ctx)
 
 		// Prepare port buffers for reading, converting/mixing if necessary
 		for (uint32_t i = 0; _ports && i < _ports->size(); ++i) {
-			_ports->at(i)->connect_buffers(offset);
-			_ports->at(i)->pre_run(subcontext);
+			_ports->at(i)->connect_buffers(offset, begin, end);
+			_ports->at(i)->pre_run(subcontext, begin, end);
 		}
 
 		// Run the chunk
-		run(subcontext);
+		run_voices(subcontext, begin, end);
 
-		// Emit control port outputs as events
+		// Emit changed control port outputs as events
 		for (uint32_t i = 0; _ports && i < _ports->size(); ++i) {
-			const PortImpl* const port = _ports->at(i);
+			PortImpl* const port = _ports->at(i);
 			if (port->type() == PortType::CONTROL && port->is_output()) {
-				// TODO: Only emit events when value has actually changed?
-				for (uint32_t v = 0; v < _polyphony; ++v) {
-					port->buffer(v)->append_event(offset, port->buffer(v)->value());
-				}
+				port->emit_values(offset, begin, end, epsilon);
 			}
 		}
 
 		offset = chunk_end;
 		subcontext.slice(offset, chunk_end - offset);
 	}
-
-	post_process(ctx);
 }
 
 void
@@ -296,4 +398,16 @@ BlockImpl::set_port_buffer(uint32_t, uint32_t, const BufferRef&, SampleCount)
 	  << " buffer " << buf << " offset " << offset << std::endl;*/
 }
 
+Properties
+BlockImpl::profile_properties() const
+{
+	const URIs&            uris    = this->uris();
+	const Profile::Summary summary = _profile.summary();
+
+	return { { uris.ingen_meanRunLoad, uris.forge.make(summary.load) },
+	         { uris.ingen_maxRunLoad, uris.forge.make(summary.max_load) },
+	         { uris.ingen_meanRunTime, uris.forge.make(summary.mean_time) },
+	         { uris.ingen_maxRunTime, uris.forge.make(summary.max_time) } };
+}
+
 } // namespace ingen::server
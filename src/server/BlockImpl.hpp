@@ -19,7 +19,9 @@
 
 #include "BufferRef.hpp"
 #include "NodeImpl.hpp"
+#include "Profile.hpp"
 #include "State.hpp"
+#include "VoiceMask.hpp"
 #include "types.hpp"
 
 #include <ingen/Properties.hpp>
@@ -32,6 +34,8 @@
 
 #include <boost/intrusive/slist_hook.hpp>
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -47,6 +51,7 @@ enum class PortType;
 
 namespace server {
 
+class Buffer;
 class BufferFactory;
 class Engine;
 class GraphImpl;
@@ -137,6 +142,44 @@ public:
 	/** Run block for a portion of process cycle (called from process()). */
 	virtual void run(RunContext& ctx) = 0;
 
+	/** Return true iff ranges of voices can be run in parallel.
+	 *
+	 * This is the case if every voice only touches its own buffers and state,
+	 * so process_voices() can be called for disjoint ranges of voices from
+	 * different threads between pre_process() and post_process().
+	 */
+	virtual bool voices_independent() const { return false; }
+
+	/** Run voices [begin, end) for an entire process cycle.
+	 *
+	 * This is the part of process() between pre_process() and post_process(),
+	 * which slices the cycle at control changes and calls run_voices().
+	 * Inactive voices are not run, and their outputs are silenced.
+	 */
+	void process_voices(RunContext& ctx, uint32_t begin, uint32_t end);
+
+	/** Return true iff `voice` must be run in this cycle.
+	 *
+	 * This is always true, unless the block is voices_independent() and the
+	 * voice is inactive in the VoiceMask of the parent graph.
+	 */
+	bool voice_active(const RunContext& ctx, uint32_t voice) const;
+
+	/** Keep a released voice active while its output in `buf` is audible.
+	 *
+	 * This is called by mixers for every voice they mix down.
+	 */
+	void listen(const RunContext& ctx, uint32_t voice, const Buffer& buf) const;
+
+	/** Run voices [begin, end) for a portion of process cycle.
+	 *
+	 * The default implementation runs every voice, so blocks that are
+	 * voices_independent() must override this.
+	 */
+	virtual void run_voices(RunContext& ctx, uint32_t begin, uint32_t end) {
+		run(ctx);
+	}
+
 	/** Do whatever needs doing in the process thread after process() is called */
 	virtual void post_process(RunContext& ctx);
 
@@ -168,6 +211,9 @@ public:
 	 */
 	virtual void set_polyphonic(bool p) { _polyphonic = p; }
 
+	/** Return true iff this block is flagged as polyphonic. */
+	bool polyphonic() const { return _polyphonic; }
+
 	bool prepare_poly(BufferFactory& bufs, uint32_t poly) override;
 	bool apply_poly(RunContext& ctx, uint32_t poly) override;
 
@@ -203,15 +249,55 @@ public:
 	Mark get_mark() const { return _mark; }
 	void set_mark(Mark m) { _mark = m; }
 
+	/** Return the average time taken to process this block in profile ticks.
+	 *
+	 * This is an exponentially weighted moving average updated every cycle,
+	 * or zero if the block has not been run yet.  Ticks are not a fixed unit of
+	 * time, so costs are only comparable with each other.
+	 */
+	float cost() const { return _cost.load(std::memory_order_relaxed); }
+
+	/** Update the cost with the time taken by a single cycle (audio thread). */
+	void update_cost(uint64_t ticks) {
+		const auto  t = static_cast<float>(ticks);
+		const float c = _cost.load(std::memory_order_relaxed);
+		_cost.store(c > 0.0f ? c + ((t - c) * cost_weight) : t,
+		            std::memory_order_relaxed);
+	}
+
+	/** Return the cost this block had when its graph was last compiled. */
+	float compiled_cost() const { return _compiled_cost; }
+	void  set_compiled_cost(float c) { _compiled_cost = c; }
+
+	/** Run time statistics, only recorded if profiling is enabled. */
+	Profile&       profile()       { return _profile; }
+	const Profile& profile() const { return _profile; }
+
+	/** Return the last profiling summary as properties to send to clients. */
+	Properties profile_properties() const;
+
 protected:
+	static constexpr float cost_weight = 1.0f / 16.0f; ///< EWMA weight
+
 	PortImpl* nth_port_by_type(uint32_t n, bool input, PortType type);
 
+	/** Run voices [begin, end) for an entire process cycle. */
+	void process_chunks(RunContext& ctx, uint32_t begin, uint32_t end);
+
+	/** Silence the outputs of an inactive voice if it was just deactivated. */
+	void silence_voice(uint32_t voice);
+
 	PluginImpl*              _plugin;
+	Engine*                  _engine{nullptr}; ///< Set when activated
 	raul::managed_ptr<Ports> _ports; ///< Access in audio thread only
 	uint32_t                 _polyphony;
 	std::set<BlockImpl*>     _providers; ///< Blocks connected to this one's input ports
 	std::set<BlockImpl*>     _dependants; ///< Blocks this one's output ports are connected to
 	Mark                     _mark{Mark::UNVISITED}; ///< Mark for graph walks
+	std::atomic<float>       _cost{0.0f}; ///< Average run time in profile ticks
+	float                    _compiled_cost{0.0f}; ///< Cost at last compile
+	Profile                  _profile; ///< Detailed run time statistics
+	std::array<bool, VoiceMask::max_voices> _silent{}; ///< Silenced voices
 	bool                     _polyphonic;
 	bool                     _activated{false};
 	bool                     _enabled{true};
@@ -0,0 +1,166 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BlockLoader.hpp"
+
+#include "BlockFactory.hpp"
+#include "BlockImpl.hpp"
+#include "BufferFactory.hpp"
+#include "Engine.hpp"
+#include "LV2Block.hpp"
+#include "PluginImpl.hpp"
+#include "State.hpp"
+#include "ThreadManager.hpp"
+
+#include <ingen/FilePath.hpp>
+#include <raul/Path.hpp>
+#include <raul/Symbol.hpp>
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace ingen::server {
+
+BlockLoader::BlockLoader(Engine& engine, unsigned n_threads)
+	: _engine(engine)
+{
+	for (unsigned i = 0; i < n_threads; ++i) {
+		_threads.emplace_back(&BlockLoader::run, this);
+	}
+}
+
+BlockLoader::~BlockLoader()
+{
+	{
+		const std::lock_guard<std::mutex> lock{_mutex};
+		_exit_flag = true;
+		_queue.clear();
+	}
+
+	_job_ready.notify_all();
+	for (auto& t : _threads) {
+		t.join();
+	}
+
+	// Delete any blocks that were never taken
+	for (auto& j : _jobs) {
+		delete j.second->block;
+	}
+}
+
+void
+BlockLoader::start(const raul::Path& path,
+                   PluginImpl&       plugin,
+                   bool              polyphonic,
+                   GraphImpl&        parent,
+                   const FilePath&   state_path)
+{
+	ThreadManager::assert_thread(THREAD_PRE_PROCESS);
+
+	{
+		const std::lock_guard<std::mutex> lock{_mutex};
+		if (_jobs.find(path) != _jobs.end()) {
+			return;
+		}
+
+		auto job = std::make_unique<Job>(
+			Job{path, &plugin, polyphonic, &parent, state_path});
+
+		_queue.push_back(job.get());
+		_jobs.emplace(path, std::move(job));
+	}
+
+	_job_ready.notify_one();
+}
+
+std::unique_ptr<BlockImpl>
+BlockLoader::take(const raul::Path& path)
+{
+	ThreadManager::assert_thread(THREAD_PRE_PROCESS);
+
+	std::unique_lock<std::mutex> lock{_mutex};
+
+	const auto j = _jobs.find(path);
+	if (j == _jobs.end()) {
+		return nullptr;
+	}
+
+	Job* const job = j->second.get();
+	_job_done.wait(lock, [job] { return job->done; });
+
+	std::unique_ptr<BlockImpl> block{job->block};
+	_jobs.erase(j);
+	return block;
+}
+
+void
+BlockLoader::wait()
+{
+	std::unique_lock<std::mutex> lock{_mutex};
+	_job_done.wait(lock, [this] { return _queue.empty() && !_n_running; });
+}
+
+void
+BlockLoader::run()
+{
+	ThreadManager::set_flag(THREAD_BLOCK_LOADER);
+
+	BufferFactory& bufs = *_engine.buffer_factory();
+	while (true) {
+		Job* job = nullptr;
+		{
+			std::unique_lock<std::mutex> lock{_mutex};
+			_job_ready.wait(lock, [this] { return _exit_flag || !_queue.empty(); });
+			if (_exit_flag) {
+				return;
+			}
+
+			job = _queue.front();
+			_queue.pop_front();
+			++_n_running;
+		}
+
+		// Load state from disk if given
+		StatePtr state{};
+		if (!job->state_path.empty()) {
+			const std::lock_guard<std::mutex> lock{
+				_engine.block_factory()->lilv_mutex()};
+
+			state = LV2Block::load_state(_engine.world(), job->state_path);
+		}
+
+		// Instantiate block
+		BlockImpl* const block =
+			job->plugin->instantiate(bufs,
+			                         raul::Symbol(job->path.symbol()),
+			                         job->polyphonic,
+			                         job->parent,
+			                         _engine,
+			                         state.get());
+
+		{
+			const std::lock_guard<std::mutex> lock{_mutex};
+			job->block = block;
+			job->done  = true;
+			--_n_running;
+		}
+
+		_job_done.notify_all();
+	}
+}
+
+} // namespace ingen::server
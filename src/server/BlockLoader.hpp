@@ -0,0 +1,114 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_BLOCKLOADER_HPP
+#define INGEN_ENGINE_BLOCKLOADER_HPP
+
+#include <ingen/FilePath.hpp>
+#include <raul/Noncopyable.hpp>
+#include <raul/Path.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ingen::server {
+
+class BlockImpl;
+class Engine;
+class GraphImpl;
+class PluginImpl;
+
+/** Creates blocks in parallel on a pool of threads while graphs are loaded.
+ *
+ * The pre-processor starts creating blocks for upcoming events in a bundle,
+ * then each event takes its block when it is pre-processed, so blocks are
+ * still added to graphs in order.  Only instantiation and state restoration
+ * happen in the background.
+ *
+ * Only part of this work runs in parallel.  Lilv is not thread-safe, so
+ * everything that uses the LV2 world holds the block factory's lilv mutex,
+ * and is serialised across all loader threads.  This includes the plugin's
+ * instantiate function (via lilv_plugin_instantiate), which also holds the
+ * mutex of its plugin library, extension and feature queries, and loading
+ * state and default presets.  Creating ports and buffers from the plugin's
+ * port table, setting options, and applying state to instances run in
+ * parallel.  Plugins that are slow to instantiate therefore gain little
+ * from more threads, see the load-output option of ingen_bench.
+ *
+ * Loader threads are THREAD_BLOCK_LOADER, not THREAD_PRE_PROCESS, so a job
+ * must not touch graphs or activate blocks.
+ *
+ * \ingroup engine
+ */
+class BlockLoader : public raul::Noncopyable
+{
+public:
+	BlockLoader(Engine& engine, unsigned n_threads);
+
+	~BlockLoader();
+
+	/** Start creating a block at `path` in the background.
+	 *
+	 * This does nothing if a block at `path` has already been started.
+	 */
+	void start(const raul::Path& path,
+	           PluginImpl&       plugin,
+	           bool              polyphonic,
+	           GraphImpl&        parent,
+	           const FilePath&   state_path);
+
+	/** Wait for the block started at `path` and take ownership of it.
+	 *
+	 * @return The inactive block, or null if none was started or creating it
+	 * failed.
+	 */
+	std::unique_ptr<BlockImpl> take(const raul::Path& path);
+
+	/** Wait until no blocks are being created. */
+	void wait();
+
+private:
+	struct Job {
+		raul::Path  path;
+		PluginImpl* plugin;
+		bool        polyphonic;
+		GraphImpl*  parent;
+		FilePath    state_path;
+		BlockImpl*  block{nullptr};
+		bool        done{false};
+	};
+
+	void run();
+
+	Engine&                                      _engine;
+	std::mutex                                   _mutex;
+	std::condition_variable                      _job_ready;
+	std::condition_variable                      _job_done;
+	std::deque<Job*>                             _queue;
+	std::map<raul::Path, std::unique_ptr<Job>>   _jobs;
+	unsigned                                     _n_running{0};
+	bool                                         _exit_flag{false};
+	std::vector<std::thread>                     _threads;
+};
+
+} // namespace ingen::server
+
+#endif // INGEN_ENGINE_BLOCKLOADER_HPP
@@ -18,11 +18,18 @@
 
 #include "BlockFactory.hpp"
 #include "PluginImpl.hpp"
+#include "util.hpp"
 
+#include <ingen/Atom.hpp>
 #include <ingen/Interface.hpp>
+#include <ingen/URI.hpp>
 
 #include <cstddef>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string_view>
 #include <utility>
 
 namespace ingen::server {
@@ -40,7 +47,7 @@ void
 Broadcaster::register_client(const std::shared_ptr<Interface>& client)
 {
 	const std::lock_guard<std::mutex> lock{_clients_mutex};
-	_clients.insert(client);
+	_clients.emplace(client, MonitorState{});
 }
 
 /** Remove a client from the list of registered clients.
@@ -68,12 +75,81 @@ Broadcaster::set_broadcast(const std::shared_ptr<Interface>& client,
 	_must_broadcast.store(!_broadcastees.empty());
 }
 
+void
+Broadcaster::monitor(const URI&  subject,
+                     const URI&  key,
+                     uint32_t    size,
+                     LV2_URID    type,
+                     const void* body)
+{
+	const std::lock_guard<std::mutex> lock{_clients_mutex};
+
+	auto s = _monitor_values.find(subject);
+	if (s == _monitor_values.end()) {
+		s = _monitor_values.emplace(subject, std::map<URI, MonitorValue>{})
+		        .first;
+	}
+
+	auto v = s->second.find(key);
+	if (v == s->second.end()) {
+		v = s->second.emplace(key, MonitorValue{}).first;
+	}
+
+	set_atom(v->second.value, size, type, body);
+	v->second.gen = ++_monitor_gen;
+}
+
+void
+Broadcaster::flush_monitor(uint64_t now)
+{
+	const std::lock_guard<std::mutex> lock{_clients_mutex};
+
+	for (auto& c : _clients) {
+		MonitorState& state = c.second;
+		if (state.sent == _monitor_gen || now < state.next_time) {
+			continue;
+		}
+
+		// Send every value that changed since the last flush
+		for (const auto& s : _monitor_values) {
+			for (const auto& v : s.second) {
+				if (v.second.gen > state.sent) {
+					c.first->set_property(s.first, v.first, v.second.value);
+				}
+			}
+		}
+
+		state.sent      = _monitor_gen;
+		state.next_time = now + _monitor_period;
+	}
+}
+
+void
+Broadcaster::forget_monitor(const URI& subject)
+{
+	const std::string_view prefix{subject.c_str(), subject.length()};
+
+	auto s = _monitor_values.lower_bound(subject);
+	while (s != _monitor_values.end()) {
+		const std::string_view uri{s->first.c_str(), s->first.length()};
+		if (uri.substr(0, prefix.length()) != prefix) {
+			break;
+		}
+
+		if (uri.length() == prefix.length() || uri[prefix.length()] == '/') {
+			s = _monitor_values.erase(s);
+		} else {
+			++s;
+		}
+	}
+}
+
 void
 Broadcaster::send_plugins(const BlockFactory::Plugins& plugins)
 {
 	const std::lock_guard<std::mutex> lock{_clients_mutex};
 	for (const auto& c : _clients) {
-		send_plugins_to(c.get(), plugins);
+		send_plugins_to(c.first.get(), plugins);
 	}
 }
 
@@ -19,15 +19,21 @@
 
 #include "BlockFactory.hpp"
 
+#include <ingen/Atom.hpp>
 #include <ingen/Interface.hpp>
 #include <ingen/Message.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/paths.hpp>
+#include <lv2/urid/urid.h>
 #include <raul/Noncopyable.hpp>
 
 #include <atomic>
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <variant>
 
 namespace ingen::server {
 
@@ -36,6 +42,9 @@ namespace ingen::server {
  * This is an Interface that forwards all messages to all registered
  * clients (for updating all clients on state changes in the engine).
  *
+ * Messages are sent to each client in turn, so clients that may be slow to
+ * receive them, like sockets, are registered behind a ClientQueue.
+ *
  * \ingroup engine
  */
 class Broadcaster : public Interface
@@ -91,6 +100,34 @@ public:
 		Broadcaster& broadcaster;
 	};
 
+	/** Set the maximum rate of monitor updates sent to each client.
+	 *
+	 * @param rate Updates per second, or zero for no limit.
+	 */
+	void set_monitor_rate(uint32_t rate)
+	{
+		_monitor_period = rate ? (1000000U / rate) : 0U;
+	}
+
+	/** Queue a monitored value, like a port value or activity, for clients.
+	 *
+	 * Only the latest value for each subject and key is kept, and sent to
+	 * each client by the next flush_monitor() it is due for, so the cost of
+	 * monitoring depends on the number of ports rather than cycles.  Values
+	 * are stored in place, so this only allocates for new subjects and keys.
+	 */
+	void monitor(const URI&  subject,
+	             const URI&  key,
+	             uint32_t    size,
+	             LV2_URID    type,
+	             const void* body);
+
+	/** Send queued monitor values to every client that is due for them.
+	 *
+	 * @param now Current time in microseconds.
+	 */
+	void flush_monitor(uint64_t now);
+
 	void send_plugins(const BlockFactory::Plugins& plugins);
 
 	static void
@@ -98,9 +135,15 @@ public:
 
 	void message(const Message& msg) override {
 		const std::lock_guard<std::mutex> lock{_clients_mutex};
+		if (const auto* const del = std::get_if<Del>(&msg)) {
+			forget_monitor(del->uri);
+		} else if (const auto* const move = std::get_if<Move>(&msg)) {
+			forget_monitor(path_to_uri(move->old_path));
+		}
+
 		for (const auto& c : _clients) {
-			if (c != _ignore_client) {
-				c->message(msg);
+			if (c.first != _ignore_client) {
+				c.first->message(msg);
 			}
 		}
 	}
@@ -110,7 +153,23 @@ public:
 private:
 	friend class Transfer;
 
-	using Clients = std::set<std::shared_ptr<Interface>>;
+	/// Forget monitored values of `subject` and its descendants
+	void forget_monitor(const URI& subject);
+
+	/// Monitor updates sent to a client
+	struct MonitorState {
+		uint64_t sent{0U};      ///< Generation of the latest value sent
+		uint64_t next_time{0U}; ///< Earliest time of the next flush
+	};
+
+	/// The latest monitored value of a subject and key
+	struct MonitorValue {
+		Atom     value;
+		uint64_t gen{0U}; ///< Generation when value was set
+	};
+
+	using Clients       = std::map<std::shared_ptr<Interface>, MonitorState>;
+	using MonitorValues = std::map<URI, std::map<URI, MonitorValue>>;
 
 	std::mutex                           _clients_mutex;
 	Clients                              _clients;
@@ -118,6 +177,9 @@ private:
 	std::atomic<bool>                    _must_broadcast{false};
 	unsigned                             _bundle_depth{0};
 	std::shared_ptr<Interface>           _ignore_client;
+	MonitorValues                        _monitor_values;
+	uint64_t                             _monitor_gen{0U};
+	uint64_t                             _monitor_period{0U}; ///< Microseconds
 };
 
 } // namespace ingen::server
@@ -18,6 +18,7 @@
 
 #include "BufferFactory.hpp"
 #include "Engine.hpp"
+#include "OffsetSet.hpp"
 #include "PortType.hpp"
 #include "RunContext.hpp"
 #include "ingen_config.h"
@@ -326,6 +327,48 @@ Buffer::append_event(int64_t        frames,
 	return true;
 }
 
+bool
+Buffer::insert_event(int64_t        frames,
+                     uint32_t       size,
+                     uint32_t       type,
+                     const uint8_t* data)
+{
+	auto* atom = get<LV2_Atom>();
+	if (atom->type == _factory.uris().atom_Chunk || frames >= _latest_event) {
+		return append_event(frames, size, type, data);
+	}
+
+	const auto ev_size = static_cast<uint32_t>(sizeof(LV2_Atom_Event) +
+	                                           lv2_atom_pad_size(size));
+	if (sizeof(LV2_Atom) + atom->size + ev_size > _capacity) {
+		return false;
+	}
+
+	// Find the first event that is later than the new one
+	auto* seq = reinterpret_cast<LV2_Atom_Sequence*>(atom);
+	auto* ev  = lv2_atom_sequence_begin(&seq->body);
+	while (!lv2_atom_sequence_is_end(&seq->body, seq->atom.size, ev) &&
+	       ev->time.frames <= frames) {
+		ev = lv2_atom_sequence_next(ev);
+	}
+
+	// Move it and everything after it forward to make room
+	auto* const end = reinterpret_cast<uint8_t*>(seq) +
+	                  lv2_atom_total_size(&seq->atom);
+	memmove(reinterpret_cast<uint8_t*>(ev) + ev_size,
+	        ev,
+	        static_cast<size_t>(end - reinterpret_cast<uint8_t*>(ev)));
+
+	ev->time.frames = frames;
+	ev->body.size   = size;
+	ev->body.type   = type;
+	memcpy(ev + 1, data, size);
+
+	atom->size += ev_size;
+
+	return true;
+}
+
 bool
 Buffer::append_event(int64_t frames, const LV2_Atom* body)
 {
@@ -389,6 +432,22 @@ Buffer::next_value_offset(SampleCount offset, SampleCount end) const
 	return end;
 }
 
+void
+Buffer::value_offsets(SampleCount end, OffsetSet& offsets) const
+{
+	// As in next_value_offset(), only sequences have discrete changes
+	if (_type == _factory.uris().atom_Sequence && _value_type) {
+		const auto* seq = get<const LV2_Atom_Sequence>();
+		LV2_ATOM_SEQUENCE_FOREACH (seq, ev) {
+			if (ev->time.frames >  0   &&
+			    ev->time.frames <  end &&
+			    ev->body.type   == _value_type) {
+				offsets.insert(ev->time.frames);
+			}
+		}
+	}
+}
+
 const LV2_Atom*
 Buffer::value() const
 {
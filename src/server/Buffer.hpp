@@ -39,6 +39,7 @@ class Atom;
 
 namespace server {
 
+class OffsetSet;
 class RunContext;
 
 class INGEN_SERVER_API Buffer
@@ -190,6 +191,16 @@ public:
 	/// Sequence buffers only
 	bool append_event(int64_t frames, const LV2_Atom* body);
 
+	/** Insert an event after any events at the same or an earlier time.
+	 *
+	 * This is linear in the size of the sequence, so append_event() should be
+	 * used when events are already in order.  Sequence buffers only.
+	 */
+	bool insert_event(int64_t        frames,
+	                  uint32_t       size,
+	                  uint32_t       type,
+	                  const uint8_t* data);
+
 	/// Sequence buffers only
 	bool append_event_buffer(const Buffer* buf);
 
@@ -205,6 +216,9 @@ public:
 	/// Return offset of the first value change after `offset`
 	SampleCount next_value_offset(SampleCount offset, SampleCount end) const;
 
+	/// Insert the offsets of all value changes in (0, end) into `offsets`
+	void value_offsets(SampleCount end, OffsetSet& offsets) const;
+
 	/// Update value buffer to value as of offset
 	void update_value_buffer(SampleCount offset);
 
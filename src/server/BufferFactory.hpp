@@ -108,10 +108,10 @@ private:
 	std::atomic<Buffer*> _free_sequence{nullptr};
 	std::atomic<Buffer*> _free_object{nullptr};
 
-	std::mutex  _mutex;
-	Engine&     _engine;
-	URIs&       _uris;
-	uint32_t    _seq_size{0U};
+	std::mutex            _mutex;
+	Engine&               _engine;
+	URIs&                 _uris;
+	std::atomic<uint32_t> _seq_size{0U};
 
 	BufferRef _silent_buffer;
 };
@@ -0,0 +1,210 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ClientQueue.hpp"
+
+#include <ingen/Interface.hpp>
+#include <ingen/Log.hpp>
+#include <ingen/Message.hpp>
+#include <ingen/URIs.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <variant>
+
+namespace ingen::server {
+
+static size_t
+next_power_of_two(size_t n)
+{
+	size_t s = 1U;
+	while (s < n) {
+		s <<= 1U;
+	}
+	return s;
+}
+
+ClientQueue::ClientQueue(Log&                       log,
+                         const URIs&                uris,
+                         std::shared_ptr<Interface> client,
+                         size_t                     capacity,
+                         Disconnect                 disconnect,
+                         Notify                     notify)
+	: _log(log)
+	, _uris(uris)
+	, _client(std::move(client))
+	, _size(next_power_of_two(capacity))
+	, _mask(_size - 1U)
+	, _slots(new Slot[_size])
+	, _disconnect(std::move(disconnect))
+	, _notify(std::move(notify))
+{
+	if (!_notify) {
+		_thread = std::thread(&ClientQueue::run, this);
+	}
+}
+
+ClientQueue::~ClientQueue()
+{
+	if (_thread.joinable()) {
+		_exit_flag = true;
+		_sem.post();
+		_thread.join();
+	}
+}
+
+const SetProperty*
+ClientQueue::monitored(const Message& msg) const
+{
+	const auto* const set = std::get_if<SetProperty>(&msg);
+
+	return (set && (set->predicate == _uris.ingen_value ||
+	                set->predicate == _uris.ingen_activity))
+	           ? set
+	           : nullptr;
+}
+
+void
+ClientQueue::message(const Message& msg)
+{
+	bool overflow = false;
+	{
+		const std::lock_guard<std::mutex> lock{_mutex};
+		if (_overflowed) {
+			return; // Client is being disconnected
+		}
+
+		const SetProperty* const set = monitored(msg);
+		if (!set && !std::get_if<BundleBegin>(&msg) &&
+		    !std::get_if<BundleEnd>(&msg)) {
+			// Never move a monitored value past another kind of change
+			_pending.clear();
+		}
+
+		if ((!set || !coalesce(*set)) && !push(msg)) {
+			if (set) {
+				if (_n_dropped++ == 0U) {
+					_log.warn("Client %1% is falling behind, dropping values\n",
+					          _client->uri());
+				}
+				return;
+			}
+
+			// Dropping anything else would leave the client out of sync
+			_overflowed = true;
+			overflow    = true;
+		}
+	}
+
+	if (overflow) {
+		if (_disconnect) {
+			_disconnect();
+		}
+	} else if (_notify) {
+		_notify();
+	} else {
+		_sem.post();
+	}
+}
+
+bool
+ClientQueue::coalesce(const SetProperty& msg)
+{
+	const auto p = _pending.find(Key{msg.subject, msg.predicate, msg.ctx});
+	if (p == _pending.end()) {
+		return false;
+	}
+
+	// Take the earlier message's slot, unless it is already being sent
+	Slot&    slot  = _slots[p->second & _mask];
+	uint32_t ready = READY;
+	if (slot.seq != p->second ||
+	    !slot.state.compare_exchange_strong(ready,
+	                                        BUSY,
+	                                        std::memory_order_acquire,
+	                                        std::memory_order_relaxed)) {
+		_pending.erase(p);
+		return false;
+	}
+
+	std::get<SetProperty>(slot.message).value = msg.value;
+	slot.state.store(READY, std::memory_order_release);
+	++_n_coalesced;
+	return true;
+}
+
+bool
+ClientQueue::push(const Message& msg)
+{
+	Slot& slot = _slots[_tail & _mask];
+	if (slot.state.load(std::memory_order_acquire) != FREE) {
+		return false; // Full
+	}
+
+	slot.seq     = _tail;
+	slot.message = msg;
+	slot.state.store(READY, std::memory_order_release);
+
+	if (const SetProperty* const set = monitored(msg)) {
+		if (_pending.size() >= _size) {
+			_pending.clear(); // Forget about long since sent messages
+		}
+
+		_pending[Key{set->subject, set->predicate, set->ctx}] = _tail;
+	}
+
+	++_tail;
+	return true;
+}
+
+size_t
+ClientQueue::drain()
+{
+	size_t n_sent = 0U;
+	while (true) {
+		// Take the next message, unless it is empty or being replaced
+		Slot&    slot  = _slots[_head & _mask];
+		uint32_t ready = READY;
+		if (!slot.state.compare_exchange_strong(ready,
+		                                        BUSY,
+		                                        std::memory_order_acquire,
+		                                        std::memory_order_relaxed)) {
+			break; // Queueing will notify again when done
+		}
+
+		const Message msg = std::move(slot.message);
+		slot.state.store(FREE, std::memory_order_release);
+		++_head;
+
+		_client->message(msg);
+		++n_sent;
+	}
+
+	return n_sent;
+}
+
+void
+ClientQueue::run()
+{
+	while (_sem.wait() && !_exit_flag) {
+		drain();
+	}
+}
+
+} // namespace ingen::server
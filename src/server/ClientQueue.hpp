@@ -0,0 +1,154 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_CLIENTQUEUE_HPP
+#define INGEN_ENGINE_CLIENTQUEUE_HPP
+
+#include <ingen/Interface.hpp>
+#include <ingen/Message.hpp>
+#include <ingen/Resource.hpp>
+#include <ingen/URI.hpp>
+#include <raul/Semaphore.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+namespace ingen {
+
+class Log;
+class URIs;
+
+namespace server {
+
+/** A bounded queue of messages to a client, which are sent by another thread.
+ *
+ * This is registered with the broadcaster in place of a client that may be
+ * slow to receive messages, such as a socket.  Queueing a message never
+ * blocks on the client.  Messages are sent to the client by draining the
+ * queue, either in a thread owned by the queue, or by whatever calls drain()
+ * after being notified.
+ *
+ * While a client falls behind, a monitored value (a SetProperty of a port
+ * value or activity) replaces an earlier one for the same property that has
+ * not been sent yet.  If the queue is full anyway, monitored values are
+ * dropped, since a later one will follow.  Any other message would leave the
+ * client out of sync, so if one does not fit, the client is disconnected
+ * instead, and nothing more is queued.
+ *
+ * The queue itself is lock-free, so the sender never blocks whoever is
+ * queueing messages, or vice versa.  Queueing is serialised by a mutex, since
+ * messages may come from the broadcaster and as responses at once.
+ *
+ * \ingroup engine
+ */
+class ClientQueue : public Interface
+{
+public:
+	using Notify     = std::function<void()>;
+	using Disconnect = std::function<void()>;
+
+	/** Create a queue of up to `capacity` messages for `client`.
+	 *
+	 * The `disconnect` function is called once if a message that can not be
+	 * dropped does not fit, and should hang up on the client.
+	 *
+	 * If `notify` is empty, messages are sent by a thread owned by the
+	 * queue.  Otherwise, it is called whenever messages are queued, and the
+	 * caller is responsible for calling drain() soon after, from one thread
+	 * at a time.
+	 */
+	ClientQueue(Log&                       log,
+	            const URIs&                uris,
+	            std::shared_ptr<Interface> client,
+	            size_t                     capacity,
+	            Disconnect                 disconnect,
+	            Notify                     notify = {});
+
+	ClientQueue(const ClientQueue&)            = delete;
+	ClientQueue& operator=(const ClientQueue&) = delete;
+	ClientQueue(ClientQueue&&)                 = delete;
+	ClientQueue& operator=(ClientQueue&&)      = delete;
+
+	~ClientQueue() override;
+
+	URI uri() const override { return _client->uri(); }
+
+	void message(const Message& msg) override;
+
+	/** Send all queued messages to the client.
+	 *
+	 * @return The number of messages sent.
+	 */
+	size_t drain();
+
+	/** Return the number of monitored values dropped while full. */
+	uint64_t n_dropped() const { return _n_dropped; }
+
+	/** Return true iff the client was disconnected for falling behind. */
+	bool overflowed() const { return _overflowed; }
+
+	/** Return the number of messages merged into an earlier one. */
+	uint64_t n_coalesced() const { return _n_coalesced; }
+
+private:
+	enum SlotState : uint32_t { FREE, READY, BUSY };
+
+	struct Slot {
+		std::atomic<uint32_t> state{FREE};
+		uint64_t              seq{0U};
+		Message               message;
+	};
+
+	using Key = std::tuple<URI, URI, Resource::Graph>;
+
+	/// Return true iff `msg` is a monitored value that may be merged or dropped
+	const SetProperty* monitored(const Message& msg) const;
+
+	bool coalesce(const SetProperty& msg);
+	bool push(const Message& msg);
+	void run();
+
+	Log&                       _log;
+	const URIs&                _uris;
+	std::shared_ptr<Interface> _client;
+	const size_t               _size;
+	const size_t               _mask;
+	std::unique_ptr<Slot[]>    _slots;
+	Disconnect                 _disconnect;
+	Notify                     _notify;
+	std::mutex                 _mutex;        ///< Serialises queueing
+	std::map<Key, uint64_t>    _pending;      ///< Queued property changes
+	uint64_t                   _tail{0U};     ///< Next slot to queue into
+	uint64_t                   _head{0U};     ///< Next slot to send
+	std::atomic<uint64_t>      _n_dropped{0U};
+	std::atomic<uint64_t>      _n_coalesced{0U};
+	std::atomic<bool>          _overflowed{false};
+	raul::Semaphore            _sem{0U};
+	std::atomic<bool>          _exit_flag{false};
+	std::thread                _thread;
+};
+
+} // namespace server
+} // namespace ingen
+
+#endif // INGEN_ENGINE_CLIENTQUEUE_HPP
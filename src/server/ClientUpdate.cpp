@@ -29,6 +29,8 @@
 #include <ingen/Properties.hpp>
 #include <ingen/Resource.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/URIDProperties.hpp>
+#include <ingen/URIMap.hpp>
 #include <ingen/URIs.hpp>
 #include <raul/Path.hpp>
 
@@ -43,13 +45,18 @@
 
 namespace ingen::server {
 
+void
+ClientUpdate::put(const URI& uri, URIDProperties props, Resource::Graph ctx)
+{
+	puts.push_back({uri, std::move(props), ctx});
+}
+
 void
 ClientUpdate::put(const URI&        uri,
                   const Properties& props,
                   Resource::Graph   ctx)
 {
-	const ClientUpdate::Put put = { uri, props, ctx };
-	puts.push_back(put);
+	puts.push_back({uri, URIDProperties(_map, props), ctx});
 }
 
 void
@@ -57,10 +64,10 @@ ClientUpdate::put_port(const PortImpl* port)
 {
 	const URIs& uris = port->bufs().uris();
 	if (port->is_a(PortType::CONTROL) || port->is_a(PortType::CV)) {
-		Properties props = port->properties();
+		URIDProperties props(_map, port->properties());
 		props.erase(uris.ingen_value);
 		props.emplace(uris.ingen_value, port->value());
-		put(port->uri(), props);
+		put(port->uri(), std::move(props));
 	} else {
 		put(port->uri(), port->properties());
 	}
@@ -127,11 +134,10 @@ ClientUpdate::put_preset(const URIs&        uris,
                          const URI&         preset,
                          const std::string& label)
 {
-	const Properties props{
-		{ uris.rdf_type, uris.pset_Preset.urid_atom() },
-		{ uris.rdfs_label, uris.forge.alloc(label) },
-		{ uris.lv2_appliesTo, uris.forge.make_urid(plugin) }};
-	put(preset, props);
+	put(preset,
+	    URIDProperties{{uris.rdf_type, uris.pset_Preset.urid_atom()},
+	                   {uris.rdfs_label, uris.forge.alloc(label)},
+	                   {uris.lv2_appliesTo, uris.forge.make_urid(plugin)}});
 }
 
 void
@@ -159,7 +165,7 @@ ClientUpdate::send(Interface& dest)
 	// Send puts in increasing depth order so parents are sent first
 	std::stable_sort(puts.begin(), puts.end(), put_higher_than);
 	for (const ClientUpdate::Put& put : puts) {
-		dest.put(put.uri, put.properties, put.ctx);
+		dest.put(put.uri, put.properties.to_properties(_map), put.ctx);
 	}
 
 	// Send connections
@@ -20,6 +20,7 @@
 #include <ingen/Properties.hpp>
 #include <ingen/Resource.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/URIDProperties.hpp>
 #include <raul/Path.hpp>
 
 #include <string>
@@ -28,6 +29,7 @@
 namespace ingen {
 
 class Interface;
+class URIMap;
 class URIs;
 
 namespace server {
@@ -40,9 +42,16 @@ class PluginImpl;
 /** A sequence of puts/connects/deletes to update clients.
  *
  * Events like Get construct this in pre_process() and later send it in
- * post_process() to avoid the need to lock.
+ * post_process() to avoid the need to lock.  Properties are kept keyed by
+ * URID until they are sent.
  */
 struct ClientUpdate {
+	explicit ClientUpdate(URIMap& map) : _map(map) {}
+
+	void put(const URI&      uri,
+	         URIDProperties  props,
+	         Resource::Graph ctx = Resource::Graph::DEFAULT);
+
 	void put(const URI&        uri,
 	         const Properties& props,
 	         Resource::Graph   ctx = Resource::Graph::DEFAULT);
@@ -62,7 +71,7 @@ struct ClientUpdate {
 
 	struct Put {
 		URI             uri;
-		Properties      properties;
+		URIDProperties  properties;
 		Resource::Graph ctx;
 	};
 
@@ -74,6 +83,9 @@ struct ClientUpdate {
 	std::vector<URI>     dels;
 	std::vector<Put>     puts;
 	std::vector<Connect> connects;
+
+private:
+	URIMap& _map;
 };
 
 } // namespace server
@@ -32,13 +32,18 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <cstdio>
 #include <exception>
 #include <functional>
 #include <limits>
 #include <memory>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 namespace ingen::server {
 
@@ -50,12 +55,7 @@ public:
 	    : node(n)
 	{}
 
-	FeedbackException(const BlockImpl* n, const BlockImpl* r)
-	    : node(n), root(r)
-	{}
-
 	const BlockImpl* node = nullptr;
-	const BlockImpl* root = nullptr;
 };
 
 static bool
@@ -68,59 +68,339 @@ has_provider_with_many_dependants(const BlockImpl* n)
 	                   });
 }
 
-CompiledGraph::CompiledGraph(GraphImpl* graph)
-	: _master{std::make_unique<Task>(Task::Mode::SEQUENTIAL)}
+static size_t
+num_unvisited_dependants(const BlockImpl* block)
+{
+	return std::count_if(block->dependants().begin(),
+	                     block->dependants().end(),
+	                     [](const auto* b) {
+		                     return b->get_mark() == BlockImpl::Mark::UNVISITED;
+	                     });
+}
+
+using Depths = std::unordered_map<const BlockImpl*, size_t>;
+
+static size_t
+parallel_depth(const BlockImpl* block, Depths& depths)
+{
+	const auto d = depths.find(block);
+	if (d != depths.end()) {
+		return d->second; // Already calculated in this compile
+	}
+
+	size_t depth = 2;
+	if (!has_provider_with_many_dependants(block)) {
+		size_t min_provider_depth = std::numeric_limits<size_t>::max();
+		for (const auto* p : block->providers()) {
+			min_provider_depth =
+				std::min(min_provider_depth, parallel_depth(p, depths));
+		}
+
+		depth += min_provider_depth;
+	}
+
+	depths.emplace(block, depth);
+	return depth;
+}
+
+/** Throw a FeedbackException iff the graph has a cycle with no delay.
+ *
+ * This is a topological sort (Kahn's algorithm), so it takes linear time.
+ */
+static void
+check_feedback(const GraphImpl& graph)
+{
+	std::unordered_map<const BlockImpl*, size_t> n_providers;
+	std::vector<const BlockImpl*>                ready;
+	size_t                                       n_blocks = 0;
+	for (const auto& b : graph.blocks()) {
+		n_providers.emplace(&b, b.providers().size());
+		if (b.providers().empty()) {
+			ready.push_back(&b);
+		}
+		++n_blocks;
+	}
+
+	size_t n_sorted = 0;
+	while (!ready.empty()) {
+		const BlockImpl* const b = ready.back();
+		ready.pop_back();
+		++n_sorted;
+		for (const auto* d : b->dependants()) {
+			if (--n_providers[d] == 0) {
+				ready.push_back(d);
+			}
+		}
+	}
+
+	if (n_sorted < n_blocks) {
+		for (const auto& p : n_providers) {
+			if (p.second) {
+				throw FeedbackException(p.first);
+			}
+		}
+	}
+}
+
+using SchedulePath  = std::vector<std::pair<const Task*, size_t>>;
+using SchedulePaths = std::unordered_map<const BlockImpl*, SchedulePath>;
+
+/** Find the path from the root of a task tree to every block in it. */
+static void
+find_paths(const Task& task, SchedulePath& path, SchedulePaths& paths)
+{
+	if (task.mode() == Task::Mode::SINGLE) {
+		paths.emplace(task.block(), path);
+		return;
+	}
+
+	for (size_t i = 0; i < task.children().size(); ++i) {
+		path.emplace_back(&task, i);
+		find_paths(*task.children()[i], path, paths);
+		path.pop_back();
+	}
+}
+
+/** Return true iff the block at `tail` is always run before that at `head`. */
+static bool
+runs_before(const SchedulePath& tail, const SchedulePath& head)
+{
+	/* Find where the paths diverge: the tail must be in an earlier child of a
+	   sequential task than the head.  Previous schedules have had voices
+	   split, and VOICES tasks run their blocks in order like SEQUENTIAL. */
+	size_t i = 0;
+	while (i < tail.size() && i < head.size() && tail[i] == head[i]) {
+		++i;
+	}
+
+	if (i == tail.size() || i == head.size()) {
+		return false;
+	}
+
+	const Task::Mode mode = tail[i].first->mode();
+	return (mode == Task::Mode::SEQUENTIAL || mode == Task::Mode::VOICES) &&
+	       tail[i].second < head[i].second;
+}
+
+/** Where to run blocks that are new since the previous schedule. */
+struct Placement {
+	Task::Insertions        before;   ///< Immediately before a scheduled block
+	Task::Insertions        after;    ///< Immediately after a scheduled block
+	std::vector<BlockImpl*> first;    ///< Before everything else
+	std::vector<BlockImpl*> last;     ///< After everything else
+	std::vector<BlockImpl*> parallel; ///< In parallel with everything else
+};
+
+/** Find where to run a new `block` in the previous schedule.
+ *
+ * The block is run next to one of its neighbours, so that the schedule stays
+ * as parallel as it was.  This fails if the block is connected to another new
+ * block, or no neighbour is run after all of its providers and before all of
+ * its dependants.
+ */
+static bool
+place_block(BlockImpl& block, const SchedulePaths& paths, Placement& placement)
+{
+	std::vector<const SchedulePath*> providers;
+	for (const auto* p : block.providers()) {
+		const auto i = paths.find(p);
+		if (i == paths.end()) {
+			return false;
+		}
+		providers.push_back(&i->second);
+	}
+
+	std::vector<const SchedulePath*> dependants;
+	for (const auto* d : block.dependants()) {
+		const auto i = paths.find(d);
+		if (i == paths.end()) {
+			return false;
+		}
+		dependants.push_back(&i->second);
+	}
+
+	if (providers.empty() && dependants.empty()) {
+		placement.parallel.push_back(&block);
+		return true;
+	}
+
+	// Return true iff `path` runs after every provider and before every dependant
+	const auto fits = [&](const SchedulePath* path) {
+		return std::all_of(providers.begin(),
+		                   providers.end(),
+		                   [path](const auto* p) {
+			                   return p == path || runs_before(*p, *path);
+		                   }) &&
+		       std::all_of(dependants.begin(),
+		                   dependants.end(),
+		                   [path](const auto* d) {
+			                   return d == path || runs_before(*path, *d);
+		                   });
+	};
+
+	// Try running the block just before one of its dependants
+	auto dependant = block.dependants().begin();
+	for (const auto* path : dependants) {
+		if (fits(path) && std::none_of(providers.begin(),
+		                               providers.end(),
+		                               [path](const auto* p) {
+			                               return p == path;
+		                               })) {
+			placement.before[*dependant].push_back(&block);
+			return true;
+		}
+		++dependant;
+	}
+
+	// Try running the block just after one of its providers
+	auto provider = block.providers().begin();
+	for (const auto* path : providers) {
+		if (fits(path) && std::none_of(dependants.begin(),
+		                               dependants.end(),
+		                               [path](const auto* d) {
+			                               return d == path;
+		                               })) {
+			placement.after[*provider].push_back(&block);
+			return true;
+		}
+		++provider;
+	}
+
+	// Otherwise, run a block at one end of the graph at that end
+	if (dependants.empty()) {
+		placement.last.push_back(&block);
+		return true;
+	}
+
+	if (providers.empty()) {
+		placement.first.push_back(&block);
+		return true;
+	}
+
+	return false;
+}
+
+CompiledGraph::CompiledGraph(GraphImpl* graph, bool full)
 {
-	compile_graph(graph);
+	if (graph->engine().world().conf().option("dataflow").get<int32_t>()) {
+		check_feedback(*graph);
+		_master = compile_dataflow(graph);
+	} else if (!full && graph->schedule() &&
+	           (_master = compile_incremental(graph))) {
+		graph->set_schedule(_master, true);
+	} else {
+		check_feedback(*graph);
+		_master = compile_graph(graph);
+		graph->set_schedule(_master, false);
+	}
+
+	for (auto& b : graph->blocks()) {
+		b.set_compiled_cost(b.cost());
+	}
+
+	if (graph->engine().world().conf().option("trace").get<int32_t>()) {
+		const ColorContext ctx{stderr, ColorContext::Color::YELLOW};
+		dump(graph->path());
+	}
 }
 
 std::unique_ptr<CompiledGraph>
-CompiledGraph::compile(GraphImpl& graph)
+CompiledGraph::compile(GraphImpl& graph, bool full)
 {
 	try {
-		return std::unique_ptr<CompiledGraph>(new CompiledGraph(&graph));
+		return std::unique_ptr<CompiledGraph>(new CompiledGraph(&graph, full));
 	} catch (const FeedbackException& e) {
-		Log& log = graph.engine().log();
-		if (e.node && e.root) {
-			log.error("Feedback compiling %1% from %2%\n",
-			          e.node->path(), e.root->path());
-		} else {
-			log.error("Feedback compiling %1%\n", e.node->path());
-		}
+		graph.engine().log().error("Feedback compiling %1%\n", e.node->path());
 		return nullptr;
 	}
 }
 
-static size_t
-num_unvisited_dependants(const BlockImpl* block)
+bool
+CompiledGraph::costs_drifted(const GraphImpl& graph)
 {
-	return std::count_if(block->dependants().begin(),
-	                     block->dependants().end(),
-	                     [](const auto* b) {
-		                     return b->get_mark() == BlockImpl::Mark::UNVISITED;
-	                     });
+	/* Relative change in total cost that triggers a recompile.  This is high
+	   enough that jitter from the measurements themselves is ignored. */
+	static constexpr float threshold = 0.5f;
+
+	size_t n_blocks = 0;
+	float  total    = 0.0f;
+	float  delta    = 0.0f;
+	for (const auto& b : graph.blocks()) {
+		total += b.compiled_cost();
+		delta += std::fabs(b.cost() - b.compiled_cost());
+		++n_blocks;
+	}
+
+	return n_blocks > 1 && delta > total * threshold;
 }
 
-static size_t
-parallel_depth(const BlockImpl* block)
+std::unique_ptr<Task>
+CompiledGraph::compile_incremental(GraphImpl* graph)
 {
-	if (has_provider_with_many_dependants(block)) {
-		return 2;
+	ThreadManager::assert_thread(THREAD_PRE_PROCESS);
+
+	// Find where every block in the previous schedule is run
+	const Task&   schedule = *graph->schedule();
+	SchedulePath  path;
+	SchedulePaths paths;
+	find_paths(schedule, path, paths);
+
+	/* Check that the previous schedule can be reused before copying it.  Every
+	   arc between scheduled blocks must still run its tail first, and every
+	   new block must fit between its providers and dependants.  Otherwise, the
+	   caller falls back to a full compile. */
+	std::unordered_set<const BlockImpl*> blocks;
+	Placement                            placement;
+	for (auto& b : graph->blocks()) {
+		blocks.insert(&b);
+
+		const auto t = paths.find(&b);
+		if (t == paths.end()) {
+			if (!place_block(b, paths, placement)) {
+				return nullptr;
+			}
+			continue;
+		}
+
+		for (const auto* d : b.dependants()) {
+			const auto h = paths.find(d);
+			if (h != paths.end() && !runs_before(t->second, h->second)) {
+				return nullptr; // Arc added between concurrent blocks
+			}
+		}
 	}
 
-	size_t min_provider_depth = std::numeric_limits<size_t>::max();
-	for (const auto* p : block->providers()) {
-		min_provider_depth = std::min(min_provider_depth, parallel_depth(p));
+	// Copy the previous schedule without removed blocks, and with new ones
+	Task par(Task::Mode::PARALLEL);
+	par.push_back(
+		std::move(*schedule.copy(blocks, placement.before, placement.after)));
+	for (auto* b : placement.parallel) {
+		par.push_back(Task(Task::Mode::SINGLE, b));
 	}
 
-	return 2 + min_provider_depth;
+	Task seq(Task::Mode::SEQUENTIAL);
+	for (auto* b : placement.first) {
+		seq.push_back(Task(Task::Mode::SINGLE, b));
+	}
+	seq.push_back(std::move(par));
+	for (auto* b : placement.last) {
+		seq.push_back(Task(Task::Mode::SINGLE, b));
+	}
+
+	auto master = Task::simplify(std::make_unique<Task>(std::move(seq)));
+
+	const auto n_threads = static_cast<unsigned>(graph->engine().n_threads());
+	return Task::split_voices(std::move(master), n_threads);
 }
 
-void
+std::unique_ptr<Task>
 CompiledGraph::compile_graph(GraphImpl* graph)
 {
 	ThreadManager::assert_thread(THREAD_PRE_PROCESS);
 
+	auto   master = std::make_unique<Task>(Task::Mode::SEQUENTIAL);
+	Depths depths;
+
 	// Start with sink nodes (no outputs, or connected only to graph outputs)
 	std::set<BlockImpl*> blocks;
 	for (auto& b : graph->blocks()) {
@@ -140,7 +420,7 @@ CompiledGraph::compile_graph(GraphImpl* graph)
 		// Calculate maximum sequential depth to consume this phase
 		size_t depth = std::numeric_limits<size_t>::max();
 		for (const auto* i : blocks) {
-			depth = std::min(depth, parallel_depth(i));
+			depth = std::min(depth, parallel_depth(i, depths));
 		}
 
 		Task par(Task::Mode::PARALLEL);
@@ -150,45 +430,93 @@ CompiledGraph::compile_graph(GraphImpl* graph)
 			compile_block(b, seq, depth, predecessors);
 			par.push_front(std::move(seq));
 		}
-		_master->push_front(std::move(par));
+		master->push_front(std::move(par));
 		blocks = predecessors;
 	}
 
-	_master = Task::simplify(std::move(_master));
+	master = Task::simplify(std::move(master));
 
-	if (graph->engine().world().conf().option("trace").get<int32_t>()) {
-		const ColorContext ctx{stderr, ColorContext::Color::YELLOW};
-		dump(graph->path());
+	// Reorder and pack parallel tasks according to measured block costs
+	const auto n_threads = static_cast<unsigned>(graph->engine().n_threads());
+	if (n_threads > 1) {
+		master->balance(n_threads);
 	}
+
+	// Run the voices of polyphonic blocks in parallel
+	return Task::split_voices(std::move(master), n_threads);
 }
 
-/** Throw a FeedbackException iff `dependant` has `root` as a dependency. */
-static void
-check_feedback(const BlockImpl* root, BlockImpl* provider)
+/** Return the cost of the most expensive path from `block` to the end. */
+static float
+path_cost(const BlockImpl*                             block,
+          std::unordered_map<const BlockImpl*, float>& costs)
 {
-	if (provider == root) {
-		throw FeedbackException(root);
-	}
-
-	for (auto* p : provider->providers()) {
-		const BlockImpl::Mark mark = p->get_mark();
-		switch (mark) {
-		case BlockImpl::Mark::UNVISITED:
-			p->set_mark(BlockImpl::Mark::VISITING);
-			check_feedback(root, p);
-			break;
-		case BlockImpl::Mark::VISITING:
-			throw FeedbackException(p, root);
-		case BlockImpl::Mark::VISITED:
-			break;
+	const auto c = costs.find(block);
+	if (c != costs.end()) {
+		return c->second;
+	}
+
+	float longest = 0.0f;
+	for (const BlockImpl* d : block->dependants()) {
+		longest = std::max(longest, path_cost(d, costs));
+	}
+
+	const float cost = block->cost() + longest;
+	costs.emplace(block, cost);
+	return cost;
+}
+
+std::unique_ptr<Task>
+CompiledGraph::compile_dataflow(GraphImpl* graph)
+{
+	ThreadManager::assert_thread(THREAD_PRE_PROCESS);
+
+	/* Add a task for every block, in order of the longest path from it to
+	   the end of the graph, so that ready blocks on the critical path are
+	   started (or stolen) first. */
+	std::unordered_map<const BlockImpl*, float> path_costs;
+	const auto by_path = [&path_costs](const BlockImpl* a, const BlockImpl* b) {
+		return path_costs.at(a) > path_costs.at(b);
+	};
+
+	std::vector<BlockImpl*> blocks;
+	for (auto& b : graph->blocks()) {
+		blocks.push_back(&b);
+		path_cost(&b, path_costs);
+	}
+
+	std::stable_sort(blocks.begin(), blocks.end(), by_path);
+
+	auto master = std::make_unique<Task>(Task::Mode::DATAFLOW);
+
+	// Run the voices of polyphonic blocks in parallel
+	const auto n_threads = static_cast<unsigned>(graph->engine().n_threads());
+
+	std::unordered_map<const BlockImpl*, Task*> tasks;
+	for (auto* b : blocks) {
+		tasks.emplace(b,
+		              &master->push_back(
+			              (n_threads > 1 && b->voices_independent())
+				              ? Task::voices(b, n_threads)
+				              : Task(Task::Mode::SINGLE, b)));
+	}
+
+	// Link every task to the tasks of its dependants
+	for (auto* b : blocks) {
+		std::vector<BlockImpl*> deps(b->dependants().begin(),
+		                             b->dependants().end());
+
+		std::stable_sort(deps.begin(), deps.end(), by_path);
+		for (auto* d : deps) {
+			tasks[b]->add_dependant(*tasks[d]);
 		}
-		p->set_mark(mark);
 	}
+
+	return master;
 }
 
 void
-CompiledGraph::compile_provider(const BlockImpl*      root,
-                                BlockImpl*            block,
+CompiledGraph::compile_provider(BlockImpl*            block,
                                 Task&                 task,
                                 size_t                max_depth,
                                 std::set<BlockImpl*>& k)
@@ -196,7 +524,6 @@ CompiledGraph::compile_provider(const BlockImpl*      root,
 	if (block->dependants().size() > 1) {
 		/* Provider has other dependants, so this is the tail of a sequential task.
 		   Add provider to future working set and stop traversal. */
-		check_feedback(root, block);
 		if (num_unvisited_dependants(block) == 0) {
 			k.insert(block);
 		}
@@ -234,7 +561,7 @@ CompiledGraph::compile_block(BlockImpl*            n,
 		if (n->providers().size() < 2) {
 			// Single provider, prepend it to this sequential task
 			for (auto* p : n->providers()) {
-				compile_provider(n, p, task, max_depth - 1, k);
+				compile_provider(p, task, max_depth - 1, k);
 			}
 		} else if (has_provider_with_many_dependants(n)) {
 			// Stop recursion and enqueue providers for the next round
@@ -248,7 +575,7 @@ CompiledGraph::compile_block(BlockImpl*            n,
 			// make a new parallel task to execute them
 			Task par(Task::Mode::PARALLEL);
 			for (auto* p : n->providers()) {
-				compile_provider(n, p, par, max_depth - 1, k);
+				compile_provider(p, par, max_depth - 1, k);
 			}
 			task.push_front(std::move(par));
 		}
@@ -37,41 +37,67 @@ class RunContext;
  * This is a flat sequence of nodes ordered such that the process thread can
  * execute the nodes in order and have nodes always executed before any of
  * their dependencies.
+ *
+ * Alternatively, if the "dataflow" option is enabled, this is a single
+ * DATAFLOW task where every block is run as soon as all of its providers have
+ * finished, without any barriers between parallel phases.
+ *
+ * With several threads, the voices of polyphonic blocks, and of chains of
+ * them, are also split into groups which are run in parallel.
  */
 class CompiledGraph : public raul::Noncopyable
 {
 public:
-	static std::unique_ptr<CompiledGraph> compile(GraphImpl& graph);
+	/** Compile `graph`, or return null if it has feedback.
+	 *
+	 * Unless `full` is true, this first tries to update the previous schedule
+	 * of the graph, which is much faster for local edits.  Otherwise, or if
+	 * that fails because the topology changed too much, the whole graph is
+	 * compiled from scratch.
+	 */
+	static std::unique_ptr<CompiledGraph> compile(GraphImpl& graph,
+	                                              bool       full = false);
+
+	/** Return true iff block costs have changed enough to recompile `graph`.
+	 *
+	 * This compares the current measured cost of every block with the cost
+	 * it had when the graph was last compiled, so that the task tree can be
+	 * rebalanced when the load shifts.
+	 */
+	static bool costs_drifted(const GraphImpl& graph);
 
 	void run(RunContext& ctx);
 
 private:
-	explicit CompiledGraph(GraphImpl* graph);
+	CompiledGraph(GraphImpl* graph, bool full);
 
 	using BlockSet = std::set<BlockImpl*>;
 
 	void dump(const std::string& name) const;
 
-	void compile_graph(GraphImpl* graph);
+	static std::unique_ptr<Task> compile_incremental(GraphImpl* graph);
+
+	std::unique_ptr<Task> compile_graph(GraphImpl* graph);
+
+	static std::unique_ptr<Task> compile_dataflow(GraphImpl* graph);
 
 	void compile_block(BlockImpl* n,
 	                   Task&      task,
 	                   size_t     max_depth,
 	                   BlockSet&  k);
 
-	void compile_provider(const BlockImpl* root,
-	                      BlockImpl*       block,
-	                      Task&            task,
-	                      size_t           max_depth,
-	                      BlockSet&        k);
+	void compile_provider(BlockImpl* block,
+	                      Task&      task,
+	                      size_t     max_depth,
+	                      BlockSet&  k);
 
-	std::unique_ptr<Task> _master;
+	std::shared_ptr<Task> _master;
 };
 
 inline std::unique_ptr<CompiledGraph>
-compile(GraphImpl& graph)
+compile(GraphImpl& graph, bool full = false)
 {
-	return CompiledGraph::compile(graph);
+	return CompiledGraph::compile(graph, full);
 }
 
 } // namespace ingen::server
@@ -60,7 +60,8 @@ DuplexPort::DuplexPort(BufferFactory&      bufs,
 
 	if (!parent->parent() ||
 	    _poly != parent->parent_graph()->internal_poly()) {
-		_poly = 1;
+		_poly     = 1;
+		_poly_pre = 1;
 	}
 
 	// Set default control range
@@ -201,23 +202,31 @@ DuplexPort::max_tail_poly(RunContext&) const
 bool
 DuplexPort::prepare_poly(BufferFactory& bufs, uint32_t poly)
 {
-	if (!parent()->parent() ||
-	    poly != parent()->parent_graph()->internal_poly()) {
+	if (!parent()->parent()) {
 		return false;
 	}
 
+	// Only polyphonic if voices map directly to the parent graph's voices
+	if (poly != parent()->parent_graph()->internal_poly()) {
+		poly = 1;
+	}
+
 	return PortImpl::prepare_poly(bufs, poly);
 }
 
 bool
 DuplexPort::apply_poly(RunContext& ctx, uint32_t poly)
 {
-	if (!parent()->parent() ||
-	    poly != parent()->parent_graph()->internal_poly()) {
+	if (!parent()->parent()) {
 		return false;
 	}
 
-	return PortImpl::apply_poly(ctx, poly);
+	// Polyphony was decided by prepare_poly(), which prepared these voices
+	const bool ret = PortImpl::apply_poly(
+		ctx, _prepared_voices ? _prepared_voices->size() : poly);
+
+	resend_values();
+	return ret;
 }
 
 void
@@ -253,9 +262,21 @@ DuplexPort::post_process(RunContext& ctx)
 }
 
 SampleCount
-DuplexPort::next_value_offset(SampleCount offset, SampleCount end) const
+DuplexPort::next_value_offset(SampleCount offset,
+                              SampleCount end,
+                              uint32_t    voice_begin,
+                              uint32_t    voice_end) const
+{
+	return PortImpl::next_value_offset(offset, end, voice_begin, voice_end);
+}
+
+void
+DuplexPort::value_offsets(SampleCount end,
+                          uint32_t    voice_begin,
+                          uint32_t    voice_end,
+                          OffsetSet&  offsets) const
 {
-	return PortImpl::next_value_offset(offset, end);
+	PortImpl::value_offsets(end, voice_begin, voice_end, offsets);
 }
 
 } // namespace ingen::server
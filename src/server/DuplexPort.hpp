@@ -45,6 +45,7 @@ namespace server {
 class BufferFactory;
 class Engine;
 class GraphImpl;
+class OffsetSet;
 
 /** A duplex Port (both an input and output port on a Graph)
  *
@@ -110,8 +111,17 @@ public:
 	void pre_process(RunContext& ctx) override;
 	void post_process(RunContext& ctx) override;
 
-	SampleCount
-	next_value_offset(SampleCount offset, SampleCount end) const override;
+	using InputPort::next_value_offset;
+
+	SampleCount next_value_offset(SampleCount offset,
+	                              SampleCount end,
+	                              uint32_t    voice_begin,
+	                              uint32_t    voice_end) const override;
+
+	void value_offsets(SampleCount end,
+	                   uint32_t    voice_begin,
+	                   uint32_t    voice_end,
+	                   OffsetSet&  offsets) const override;
 };
 
 } // namespace server
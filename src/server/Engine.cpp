@@ -17,6 +17,8 @@
 #include "Engine.hpp"
 
 #include "BlockFactory.hpp"
+#include "BlockLoader.hpp"
+#include "BlockImpl.hpp"
 #include "Broadcaster.hpp"
 #include "BufferFactory.hpp"
 #include "ControlBindings.hpp"
@@ -28,10 +30,12 @@
 #include "LV2Options.hpp"
 #include "NodeImpl.hpp"
 #include "PortImpl.hpp"
+#include "PortValueHandoff.hpp"
 #include "PostProcessor.hpp"
 #include "PreProcessor.hpp"
 #include "RunContext.hpp"
 #include "Task.hpp"
+#include "TaskDeque.hpp"
 #include "ThreadManager.hpp"
 #include "UndoStack.hpp"
 #include "Worker.hpp"
@@ -57,8 +61,10 @@
 #include <ingen/StreamWriter.hpp>
 #include <ingen/Tee.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/URIDProperties.hpp>
 #include <ingen/URIs.hpp>
 #include <ingen/World.hpp>
+#include <lv2/atom/atom.h>
 #include <lv2/buf-size/buf-size.h>
 #include <lv2/state/state.h>
 #include <raul/Maid.hpp>
@@ -72,9 +78,11 @@
 #include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 namespace ingen::server {
 
@@ -93,6 +101,7 @@ Engine::Engine(ingen::World& world)
 	, _block_factory(new BlockFactory(world))
 	, _undo_stack(new UndoStack(world.uris(), world.uri_map()))
 	, _redo_stack(new UndoStack(world.uris(), world.uri_map()))
+	, _port_values(new PortValueHandoff(world.uris()))
 	, _post_processor(new PostProcessor(*this))
 	, _pre_processor(new PreProcessor(*this))
 	, _event_writer(new EventWriter(*this))
@@ -100,23 +109,56 @@ Engine::Engine(ingen::World& world)
 	, _atom_interface(
 		new AtomReader(world.uri_map(), world.uris(), world.log(), *_interface))
 	, _rand_engine(reinterpret_cast<uintptr_t>(this))
+	, _tasks_available(static_cast<uint32_t>(
+		std::max(1, world.conf().option("threads").get<int32_t>())))
+	, _wait_policy(
+		parse_wait_policy(world.conf().option("wait-policy").ptr<char>()))
+	, _spin_count(static_cast<uint32_t>(
+		std::max(0, world.conf().option("spin-count").get<int32_t>())))
+	, _min_slice(static_cast<SampleCount>(
+		std::max(1, world.conf().option("min-slice").get<int32_t>())))
+	, _control_epsilon(
+		std::max(0.0f, world.conf().option("control-epsilon").get<float>()))
 	, _atomic_bundles(world.conf().option("atomic-bundles").get<int32_t>())
+	, _profiling(world.conf().option("profile").get<int32_t>())
 {
 	if (!world.store()) {
 		world.set_store(std::make_shared<ingen::Store>());
 	}
 
+	_broadcaster->set_monitor_rate(static_cast<uint32_t>(
+		std::max(0, world.conf().option("monitor-rate").get<int32_t>())));
+
 	for (int i = 0; i < world.conf().option("threads").get<int32_t>(); ++i) {
 		const bool is_threaded = (i > 0);
 		_notifications.emplace_back(
 		    std::make_unique<raul::RingBuffer>(24U * event_queue_size()));
+		_task_queues.emplace_back(std::make_unique<TaskDeque>(1024U));
+		_context_profiles.emplace_back(std::make_unique<Profile>());
 		_run_contexts.emplace_back(
 		    std::make_unique<RunContext>(*this,
 		                                 _notifications.back().get(),
+		                                 _task_queues.back().get(),
 		                                 static_cast<unsigned>(i),
 		                                 is_threaded));
 	}
 
+	// Start workers only now, since they look at every context when idle
+	for (const auto& ctx : _run_contexts) {
+		ctx->start_thread();
+	}
+
+	const int32_t load_threads = world.conf().option("load-threads").get<int32_t>();
+	if (load_threads > 1) {
+		_block_loader = std::make_unique<BlockLoader>(
+			*this, static_cast<unsigned>(load_threads));
+	}
+
+	if (_profiling) {
+		profile_ticks_per_us(); // Calibrate clock before running
+		_thread_loads.resize(_run_contexts.size(), 0.0f);
+	}
+
 	_world.lv2_features().add_feature(_worker->schedule_feature());
 	_world.lv2_features().add_feature(_options);
 	_world.lv2_features().add_feature(
@@ -237,6 +279,12 @@ Engine::emit_notifications(FrameTime end)
 	for (const auto& ctx : _run_contexts) {
 		ctx->emit_notifications(end);
 	}
+
+	_broadcaster->flush_monitor(current_time());
+
+	if (const auto store = this->store()) {
+		_port_values->apply(*store);
+	}
 }
 
 bool
@@ -250,33 +298,54 @@ Engine::pending_notifications()
 }
 
 bool
-Engine::wait_for_tasks()
+Engine::has_queued_tasks() const
+{
+	return std::any_of(_task_queues.begin(),
+	                   _task_queues.end(),
+	                   [](const auto& queue) { return !queue->empty(); });
+}
+
+bool
+Engine::wait_for_tasks(unsigned id, Backoff& backoff)
 {
-	if (!_quit_flag) {
-		std::unique_lock<std::mutex> lock(_tasks_mutex);
-		_tasks_available.wait(lock);
+	if (_quit_flag) {
+		return false;
+	}
+
+	if (backoff.pause()) {
+		return true; // Spun for a while, try again
 	}
+
+	// Out of patience, park until signalled
+	_tasks_available.prepare_wait(id);
+	if (_quit_flag || has_queued_tasks()) {
+		_tasks_available.cancel_wait(id);
+	} else {
+		_tasks_available.wait(id);
+		_n_wakeups.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	backoff.reset();
 	return !_quit_flag;
 }
 
 void
 Engine::signal_tasks_available()
 {
-	_tasks_available.notify_all();
+	if (_wait_policy == WaitPolicy::PARK) {
+		_tasks_available.notify_all();
+	}
 }
 
 Task*
 Engine::steal_task(unsigned start_thread)
 {
-	for (unsigned i = 0; i < _run_contexts.size(); ++i) {
-		const unsigned id  = (start_thread + i) % _run_contexts.size();
-		const auto&    ctx = _run_contexts[id];
-		Task*          par = ctx->task();
-		if (par) {
-			Task* t = par->steal(*ctx);
-			if (t) {
-				return t;
-			}
+	const auto n_queues = static_cast<unsigned>(_task_queues.size());
+	for (unsigned i = 0; i < n_queues; ++i) {
+		const unsigned id = (start_thread + i) % n_queues;
+		Task* const    t  = _task_queues[id]->steal();
+		if (t) {
+			return t;
 		}
 	}
 	return nullptr;
@@ -324,12 +393,107 @@ Engine::load_properties() const
 {
 	const ingen::URIs& uris = _world.uris();
 
-	return { { uris.ingen_meanRunLoad,
-		       uris.forge.make(floorf(_run_load.mean) / 100.0f) },
-		     { uris.ingen_minRunLoad,
-	           uris.forge.make(_run_load.min / 100.0f) },
-		     { uris.ingen_maxRunLoad,
-		       uris.forge.make(_run_load.max / 100.0f) } };
+	Properties props{
+		{ uris.ingen_meanRunLoad,
+		  uris.forge.make(floorf(_run_load.mean) / 100.0f) },
+		{ uris.ingen_minRunLoad,
+		  uris.forge.make(_run_load.min / 100.0f) },
+		{ uris.ingen_maxRunLoad,
+		  uris.forge.make(_run_load.max / 100.0f) },
+		{ uris.ingen_meanWakeups,
+		  uris.forge.make(_wake_stats.mean) },
+		{ uris.ingen_maxWakeups,
+		  uris.forge.make(static_cast<int32_t>(_wake_stats.max)) } };
+
+	if (_profiling) {
+		// Utilisation of each thread, as a vector indexed by context ID
+		std::vector<uint8_t> vec(sizeof(LV2_Atom_Vector_Body) +
+		                         (_thread_loads.size() * sizeof(float)));
+
+		auto* const body = reinterpret_cast<LV2_Atom_Vector_Body*>(vec.data());
+		body->child_size = sizeof(float);
+		body->child_type = uris.forge.Float;
+		std::copy(_thread_loads.begin(),
+		          _thread_loads.end(),
+		          reinterpret_cast<float*>(body + 1));
+
+		props.emplace(uris.ingen_threadLoad,
+		              Forge::alloc(static_cast<uint32_t>(vec.size()),
+		                           uris.forge.Vector,
+		                           vec.data()));
+	}
+
+	return props;
+}
+
+void
+Engine::add_profiled_block(BlockImpl* block)
+{
+	if (_profiling) {
+		const std::lock_guard<std::mutex> lock{_profiled_mutex};
+		_profiled_blocks.insert(block);
+	}
+}
+
+void
+Engine::remove_profiled_block(BlockImpl* block)
+{
+	if (_profiling) {
+		const std::lock_guard<std::mutex> lock{_profiled_mutex};
+		_profiled_blocks.erase(block);
+	}
+}
+
+void
+Engine::update_profiles()
+{
+	if (!_profiling) {
+		return;
+	}
+
+	const uint64_t now = current_time();
+	if (!_last_profile_time) {
+		_last_profile_time = now;
+		return;
+	}
+
+	if (now - _last_profile_time < 1000000U) {
+		return; // Only update once per second
+	}
+
+	std::unique_lock<Store::Mutex> store_lock{store()->mutex(),
+	                                          std::try_to_lock};
+	if (!store_lock.owns_lock()) {
+		return; // Store is busy, try again next time
+	}
+
+	const auto period_us    = static_cast<double>(now - _last_profile_time);
+	const auto ticks_per_us = profile_ticks_per_us();
+	const auto cycle_us     = static_cast<double>(run_context().duration());
+	_last_profile_time      = now;
+
+	for (size_t i = 0; i < _context_profiles.size(); ++i) {
+		_context_profiles[i]->update(ticks_per_us, period_us, cycle_us);
+		_thread_loads[i] = _context_profiles[i]->summary().load;
+	}
+
+	// Update blocks, then broadcast outside the locks
+	std::vector<std::pair<URI, Properties>> updates;
+	{
+		const std::lock_guard<std::mutex> lock{_profiled_mutex};
+		for (BlockImpl* const block : _profiled_blocks) {
+			if (block->profile().update(ticks_per_us, period_us, cycle_us)) {
+				updates.emplace_back(block->uri(), block->profile_properties());
+			}
+		}
+	}
+	store_lock.unlock();
+
+	for (const auto& u : updates) {
+		_broadcaster->put(u.first, u.second);
+	}
+
+	_broadcaster->put(URI("ingen:/engine"), load_properties());
 }
 
 bool
@@ -338,9 +502,10 @@ Engine::main_iteration()
 	_post_processor->process();
 	_maid->cleanup();
 
-	if (_run_load.changed) {
+	if (_run_load.changed || _wake_stats.changed) {
 		_broadcaster->put(URI("ingen:/engine"), load_properties());
-		_run_load.changed = false;
+		_run_load.changed   = false;
+		_wake_stats.changed = false;
 	}
 
 	return !_quit_flag;
@@ -353,6 +518,7 @@ Engine::set_driver(const std::shared_ptr<Driver>& driver)
 	for (const auto& ctx : _run_contexts) {
 		ctx->set_priority(driver->real_time_priority());
 		ctx->set_rate(driver->sample_rate());
+		ctx->value_offsets().reserve(driver->block_length());
 	}
 
 	_buffer_factory->set_block_length(driver->block_length());
@@ -409,7 +575,7 @@ Engine::activate()
 
 	if (!_root_graph) {
 		// No root graph has been loaded, create an empty one
-		const Properties properties = {
+		const URIDProperties properties = {
 			{uris.rdf_type, uris.ingen_Graph},
 			{uris.ingen_polyphony,
 			 Property(_world.forge().make(1),
@@ -464,6 +630,7 @@ Engine::run(uint32_t sample_count)
 	// Reset load if graph structure has changed
 	if (_reset_load_flag) {
 		_run_load        = Load();
+		_wake_stats      = WakeStats();
 		_reset_load_flag = false;
 	}
 
@@ -481,10 +648,11 @@ Engine::run(uint32_t sample_count)
 			ctx, _root_graph->port_impl(1)->buffer(0).get());
 	}
 
-	// Update load for this cycle
+	// Update load and wakeup statistics for this cycle
 	if (ctx.duration() > 0) {
 		_run_load.update(current_time() - _cycle_start_time, ctx.duration());
 	}
+	_wake_stats.update(_n_wakeups.exchange(0, std::memory_order_relaxed));
 
 	return n_processed_events;
 }
@@ -17,8 +17,11 @@
 #ifndef INGEN_ENGINE_ENGINE_HPP
 #define INGEN_ENGINE_ENGINE_HPP
 
+#include "Backoff.hpp"
 #include "Event.hpp"
+#include "EventCount.hpp"
 #include "Load.hpp"
+#include "Profile.hpp"
 #include "server.h"
 #include "types.hpp"
 
@@ -26,13 +29,15 @@
 #include <ingen/EngineBase.hpp>
 #include <ingen/Properties.hpp>
 
+#include <atomic>
 #include <chrono>
-#include <condition_variable>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <mutex>
 #include <random>
+#include <unordered_set>
 #include <vector>
 
 namespace raul {
@@ -51,6 +56,8 @@ class World;
 namespace server {
 
 class BlockFactory;
+class BlockImpl;
+class BlockLoader;
 class Broadcaster;
 class BufferFactory;
 class ControlBindings;
@@ -58,11 +65,13 @@ class Driver;
 class EventWriter;
 class GraphImpl;
 class LV2Options;
+class PortValueHandoff;
 class PostProcessor;
 class PreProcessor;
 class RunContext;
 class SocketListener;
 class Task;
+class TaskDeque;
 class UndoStack;
 class Worker;
 
@@ -140,10 +149,12 @@ public:
 	const std::shared_ptr<EventWriter>&     event_writer()     const { return _event_writer; }
 	const std::unique_ptr<AtomReader>&      atom_interface()   const { return _atom_interface; }
     const std::unique_ptr<BlockFactory>&    block_factory()    const { return _block_factory; }
+    const std::unique_ptr<BlockLoader>&     block_loader()     const { return _block_loader; }
     const std::unique_ptr<Broadcaster>&     broadcaster()      const { return _broadcaster; }
     const std::unique_ptr<BufferFactory>&   buffer_factory()   const { return _buffer_factory; }
     const std::unique_ptr<ControlBindings>& control_bindings() const { return _control_bindings; }
     const std::shared_ptr<Driver>&          driver()           const { return _driver; }
+    const std::unique_ptr<PortValueHandoff>& port_values()     const { return _port_values; }
     const std::unique_ptr<PostProcessor>&   post_processor()   const { return _post_processor; }
     const std::unique_ptr<raul::Maid>&      maid()             const { return _maid; }
     const std::unique_ptr<UndoStack>&       undo_stack()       const { return _undo_stack; }
@@ -162,10 +173,22 @@ public:
 
 	void  emit_notifications(FrameTime end);
 	bool  pending_notifications();
-	bool  wait_for_tasks();
 	void  signal_tasks_available();
 	Task* steal_task(unsigned start_thread);
 
+	/** Wait for tasks according to the configured wait policy.
+	 *
+	 * This either spins for a moment with `backoff`, or parks the calling
+	 * worker thread `id` until tasks are signalled as available.  It may
+	 * block, so it must never be called from the audio thread.
+	 *
+	 * @return false iff the engine is quitting.
+	 */
+	bool wait_for_tasks(unsigned id, Backoff& backoff);
+
+	/** Return a new backoff for a context waiting on tasks. */
+	Backoff make_backoff() const { return {_wait_policy, _spin_count}; }
+
 	std::shared_ptr<Store> store() const;
 
 	SampleRate  sample_rate() const;
@@ -173,13 +196,62 @@ public:
 	uint32_t    sequence_size() const;
 	uint32_t    event_queue_size() const;
 
+	/** Return the shortest chunk a block's run is split into for control
+	 * changes, where 1 is sample accurate. */
+	SampleCount min_slice() const { return _min_slice; }
+
+	/** Return the smallest change of a control output that is sent as an
+	 * event after the first chunk of a cycle. */
+	float control_epsilon() const { return _control_epsilon; }
+
 	size_t n_threads()      const { return _run_contexts.size(); }
 	bool   atomic_bundles() const { return _atomic_bundles; }
 	bool   activated()      const { return _activated; }
+	bool   profiling()      const { return _profiling; }
+
+	/** Return the run time statistics for the run context with the given ID. */
+	Profile& context_profile(unsigned id) { return *_context_profiles[id]; }
+
+	/** Add a block to those whose statistics are updated while profiling. */
+	void add_profiled_block(BlockImpl* block);
+
+	/** Remove a block added with add_profiled_block(). */
+	void remove_profiled_block(BlockImpl* block);
+
+	/** Collect and broadcast profiling statistics if due (main thread).
+	 *
+	 * This does nothing if the store is locked, so it never blocks the main
+	 * thread, and is retried on the next call.
+	 */
+	void update_profiles();
 
 	Properties load_properties() const;
 
 private:
+	/** Statistics about how often idle threads are woken per cycle. */
+	struct WakeStats {
+		void update(uint32_t n_wakeups) {
+			if (n_wakeups > max) {
+				max     = n_wakeups;
+				changed = true;
+			}
+
+			const float a = mean + ((static_cast<float>(n_wakeups) - mean) /
+			                        static_cast<float>(++n));
+			if (std::fabs(a - mean) >= 0.01f) {
+				changed = true;
+			}
+			mean = a;
+		}
+
+		uint32_t max     = 0;
+		float    mean    = 0.0f;
+		uint64_t n       = 0;
+		bool     changed = false;
+	};
+
+	bool has_queued_tasks() const;
+
 	ingen::World& _world;
 
 	std::shared_ptr<LV2Options>      _options;
@@ -191,8 +263,10 @@ private:
 	std::unique_ptr<Broadcaster>     _broadcaster;
 	std::unique_ptr<ControlBindings> _control_bindings;
 	std::unique_ptr<BlockFactory>    _block_factory;
+	std::unique_ptr<BlockLoader>     _block_loader;
 	std::unique_ptr<UndoStack>       _undo_stack;
 	std::unique_ptr<UndoStack>       _redo_stack;
+	std::unique_ptr<PortValueHandoff> _port_values;
 	std::unique_ptr<PostProcessor>   _post_processor;
 	std::unique_ptr<PreProcessor>    _pre_processor;
 	std::unique_ptr<SocketListener>  _listener;
@@ -202,21 +276,33 @@ private:
 	GraphImpl*                       _root_graph{nullptr};
 
 	std::vector<std::unique_ptr<raul::RingBuffer>> _notifications;
+	std::vector<std::unique_ptr<TaskDeque>>        _task_queues;
 	std::vector<std::unique_ptr<RunContext>>       _run_contexts;
+	std::vector<std::unique_ptr<Profile>>          _context_profiles;
+	std::vector<float>                             _thread_loads;
+	std::mutex                                     _profiled_mutex;
+	std::unordered_set<BlockImpl*>                 _profiled_blocks;
+	uint64_t                                       _last_profile_time{0};
 	uint64_t                                       _cycle_start_time{0};
 	Load                                           _run_load;
+	WakeStats                                      _wake_stats;
 	Clock                                          _clock;
 
 	std::mt19937                          _rand_engine;
 	std::uniform_real_distribution<float> _uniform_dist{0.0f, 1.0f};
 
-	std::condition_variable _tasks_available;
-	std::mutex              _tasks_mutex;
+	EventCount            _tasks_available;
+	WaitPolicy            _wait_policy;
+	uint32_t              _spin_count;
+	SampleCount           _min_slice;
+	float                 _control_epsilon;
+	std::atomic<uint32_t> _n_wakeups{0};
 
-	bool _quit_flag{false};
+	std::atomic<bool> _quit_flag{false};
 	bool _reset_load_flag{false};
 	bool _atomic_bundles;
 	bool _activated{false};
+	bool _profiling;
 };
 
 } // namespace server
@@ -38,6 +38,7 @@ class Path;
 
 namespace ingen::server {
 
+class BlockLoader;
 class Engine;
 class RunContext;
 class PreProcessContext;
@@ -71,6 +72,15 @@ public:
 	/** Claim position in undo stack before pre-processing (non-realtime). */
 	virtual void mark(PreProcessContext&) {}
 
+	/** Start any slow work for this event in the background (non-realtime).
+	 *
+	 * This is called by the pre-processor for upcoming events in a bundle.
+	 *
+	 * @return True iff later events may be prefetched before this one is
+	 * pre-processed.
+	 */
+	virtual bool prefetch(BlockLoader&) { return false; }
+
 	/** Pre-process event before execution (non-realtime). */
 	virtual bool pre_process(PreProcessContext& ctx) = 0;
 
@@ -0,0 +1,104 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_EVENTCOUNT_HPP
+#define INGEN_ENGINE_EVENTCOUNT_HPP
+
+#include <raul/Semaphore.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace ingen::server {
+
+/** An event count for parking idle threads.
+ *
+ * Each waiter has an ID and its own semaphore.  A waiter calls prepare_wait(),
+ * checks its condition once more, then either calls cancel_wait() if there is
+ * work after all, or wait() to sleep until the next notify_all().  This
+ * avoids lost wakeups without holding a lock while checking the condition.
+ *
+ * The notifying side never blocks: notify_all() is a single atomic load when
+ * nobody is parked, and otherwise posts the semaphore of each parked waiter,
+ * so it is safe to call from the audio thread.
+ *
+ * \ingroup engine
+ */
+class EventCount
+{
+public:
+	/** Create an event count for waiters with IDs in [0, n_waiters). */
+	explicit EventCount(uint32_t n_waiters)
+		: _slots(new Slot[n_waiters])
+		, _n_slots(n_waiters)
+	{}
+
+	/** Announce that waiter `id` is about to sleep. */
+	void prepare_wait(uint32_t id) {
+		_n_parked.fetch_add(1, std::memory_order_seq_cst);
+		_slots[id].parked.store(true, std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+
+	/** Cancel a wait announced with prepare_wait(). */
+	void cancel_wait(uint32_t id) {
+		if (!_slots[id].parked.exchange(false, std::memory_order_seq_cst)) {
+			_slots[id].sem.wait(); // Notified concurrently, consume the post
+		}
+		_n_parked.fetch_sub(1, std::memory_order_seq_cst);
+	}
+
+	/** Sleep until the next notify_all() after prepare_wait(). */
+	void wait(uint32_t id) {
+		_slots[id].sem.wait();
+		_n_parked.fetch_sub(1, std::memory_order_seq_cst);
+	}
+
+	/** Wake all waiting threads.
+	 * @return true iff there were waiters to wake.
+	 */
+	bool notify_all() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!_n_parked.load(std::memory_order_seq_cst)) {
+			return false;
+		}
+
+		bool woke = false;
+		for (uint32_t i = 0; i < _n_slots; ++i) {
+			if (_slots[i].parked.exchange(false, std::memory_order_seq_cst)) {
+				_slots[i].sem.post();
+				woke = true;
+			}
+		}
+
+		return woke;
+	}
+
+private:
+	struct Slot {
+		std::atomic<bool> parked{false};
+		raul::Semaphore   sem{0};
+	};
+
+	std::unique_ptr<Slot[]> _slots;
+	uint32_t                _n_slots;
+	std::atomic<uint32_t>   _n_parked{0};
+};
+
+} // namespace ingen::server
+
+#endif // INGEN_ENGINE_EVENTCOUNT_HPP
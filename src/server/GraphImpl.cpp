@@ -23,11 +23,12 @@
 #include "DuplexPort.hpp"
 #include "Engine.hpp"
 #include "GraphPlugin.hpp"
-#include "InputPort.hpp"
 #include "PluginImpl.hpp"
 #include "PortImpl.hpp"
 #include "ThreadManager.hpp"
 
+#include <ingen/Atom.hpp>
+#include <ingen/Configuration.hpp>
 #include <ingen/Forge.hpp>
 #include <ingen/Properties.hpp>
 #include <ingen/URI.hpp>
@@ -38,15 +39,29 @@
 #include <raul/Maid.hpp>
 #include <raul/Symbol.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 namespace ingen::server {
 
+/** Return the number of frames that released voices keep running. */
+static SampleCount
+voice_release(Engine& engine, SampleRate srate)
+{
+	const int32_t ms =
+		engine.world().conf().option("voice-release").get<int32_t>();
+
+	return static_cast<SampleCount>(std::max(0, ms) * uint64_t{srate} / 1000U);
+}
+
 GraphImpl::GraphImpl(Engine&             engine,
                      const raul::Symbol& symbol,
                      uint32_t            poly,
@@ -61,6 +76,7 @@ GraphImpl::GraphImpl(Engine&             engine,
 	, _engine(engine)
 	, _poly_pre(internal_poly)
 	, _poly_process(internal_poly)
+	, _voice_mask(voice_release(engine, srate))
 {
 	assert(internal_poly >= 1);
 	assert(internal_poly <= 128);
@@ -175,45 +191,70 @@ bool
 GraphImpl::prepare_internal_poly(BufferFactory& bufs, uint32_t poly)
 {
 	ThreadManager::assert_thread(THREAD_PRE_PROCESS);
+	assert(!_poly_pending);
 
-	// TODO: Subgraph dynamic polyphony (i.e. changing port polyphony)
+	// Set first so subgraph ports can see the new polyphony of this graph
+	_poly_pre = poly;
 
+	/* Prepare blocks and stage those that may change, since _blocks is
+	   pre-process only.  Other blocks always have a polyphony of 1. */
+	size_t n_staged = 0;
 	for (auto& b : _blocks) {
 		b.prepare_poly(bufs, poly);
+		if (b.polyphonic() || b.graph_type() == GraphType::GRAPH) {
+			++n_staged;
+		}
 	}
 
-	_poly_pre = poly;
+	_poly_blocks = bufs.maid().make_managed<PolyBlocks>(n_staged);
+	size_t i = 0;
+	for (auto& b : _blocks) {
+		if (b.polyphonic() || b.graph_type() == GraphType::GRAPH) {
+			_poly_blocks->at(i++) = &b;
+		}
+	}
+
+	_poly_pending = true;
 	return true;
 }
 
 bool
-GraphImpl::apply_internal_poly(RunContext&    ctx,
-                               BufferFactory& bufs,
+GraphImpl::apply_internal_poly(RunContext& ctx,
+                               BufferFactory&,
                                raul::Maid&,
                                uint32_t poly)
 {
-	// TODO: Subgraph dynamic polyphony (i.e. changing port polyphony)
-
-	for (auto& b : _blocks) {
-		b.apply_poly(ctx, poly);
-	}
-
-	for (auto& b : _blocks) {
-		for (uint32_t j = 0; j < b.num_ports(); ++j) {
-			PortImpl* const port = b.port_impl(j);
-			if (port->is_input() && dynamic_cast<InputPort*>(port)->direct_connect()) {
-				port->setup_buffers(ctx, bufs, port->poly());
-			}
-			port->connect_buffers();
+	// Everything was done by prepare_internal_poly(), so this only swaps
+	if (_poly_blocks) {
+		const PolyBlocksPtr blocks = std::move(_poly_blocks);
+		for (size_t i = 0; i < blocks->size(); ++i) {
+			blocks->at(i)->apply_poly(ctx, poly);
 		}
 	}
 
-	const bool polyphonic = parent_graph() && (poly == parent_graph()->internal_poly_process());
-	for (auto& o : _outputs) {
-		o.setup_buffers(ctx, bufs, polyphonic ? poly : 1);
+	_poly_process = poly;
+	_poly_pending = false;
+	_poly_applied.post();
+	return true;
+}
+
+bool
+GraphImpl::wait_for_internal_poly(const std::chrono::milliseconds timeout)
+{
+	ThreadManager::assert_thread(THREAD_PRE_PROCESS);
+
+	using Clock = std::chrono::steady_clock;
+
+	/* The semaphore may have been posted by changes that nobody waited for,
+	   so check the flag again after every wake up. */
+	const Clock::time_point deadline = Clock::now() + timeout;
+	while (_poly_pending) {
+		const Clock::time_point now = Clock::now();
+		if (now >= deadline || !_poly_applied.timed_wait(deadline - now)) {
+			return !_poly_pending;
+		}
 	}
 
-	_poly_process = poly;
 	return true;
 }
 
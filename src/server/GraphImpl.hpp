@@ -20,16 +20,22 @@
 #include "BlockImpl.hpp"
 #include "DuplexPort.hpp"
 #include "ThreadManager.hpp"
+#include "VoiceMask.hpp"
 #include "server.h"
 #include "types.hpp"
 
 #include <lv2/urid/urid.h>
+#include <raul/Array.hpp>
 #include <raul/Maid.hpp>
+#include <raul/Semaphore.hpp>
 
 #include <boost/intrusive/options.hpp>
 #include <boost/intrusive/slist.hpp>
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <utility>
@@ -46,6 +52,7 @@ class CompiledGraph;
 class Engine;
 class PortImpl;
 class RunContext;
+class Task;
 
 /** A group of blocks in a graph, possibly polyphonic.
  *
@@ -88,13 +95,22 @@ public:
 	/** Prepare for a new (internal) polyphony value.
 	 *
 	 * Pre-process thread, poly is actually applied by apply_internal_poly.
+	 * All voices, instances, and buffers are allocated here, including those
+	 * of polyphonic subgraph ports, and new buffers are given their values,
+	 * so applying only swaps pointers.  Only blocks whose polyphony can
+	 * change are staged.  The change must be applied before another one is
+	 * prepared, see wait_for_internal_poly().
+	 *
 	 * \return true on success.
 	 */
 	bool prepare_internal_poly(BufferFactory& bufs, uint32_t poly);
 
 	/** Apply a new (internal) polyphony value.
 	 *
-	 * Audio thread.
+	 * Audio thread.  This does not allocate, connect buffers, or walk the
+	 * (pre-process) block list.  It only swaps in the voices of the blocks
+	 * staged by prepare_internal_poly().  Buffers are connected to blocks
+	 * when they are next run, as in every cycle.
 	 *
 	 * \param ctx  Process context
 	 *
@@ -184,6 +200,39 @@ public:
 	[[nodiscard]] std::unique_ptr<CompiledGraph>
 	swap_compiled_graph(std::unique_ptr<CompiledGraph> cg);
 
+	/** Return the task tree of the last compiled graph.
+	 *
+	 * This is used as a starting point for incremental compilation, and may
+	 * refer to blocks which have since been deleted.
+	 * Pre-processing thread only.
+	 */
+	const std::shared_ptr<const Task>& schedule() const { return _schedule; }
+
+	/** Return true iff the schedule was compiled incrementally.
+	 *
+	 * Such a schedule is correct, but may be less parallel than it could be.
+	 * Pre-processing thread only.
+	 */
+	bool schedule_is_incremental() const { return _schedule_incremental; }
+
+	/** Set the task tree of the last compiled graph.
+	 * Pre-processing thread only.
+	 */
+	void set_schedule(std::shared_ptr<const Task> schedule, bool incremental) {
+		_schedule             = std::move(schedule);
+		_schedule_incremental = incremental;
+	}
+
+	/** Return true iff a Recompile event for this graph is queued.
+	 * Pre-processing thread only.
+	 */
+	bool recompile_pending() const { return _recompile_pending; }
+
+	/** Set whether a Recompile event for this graph is queued.
+	 * Pre-processing thread only.
+	 */
+	void set_recompile_pending(bool pending) { _recompile_pending = pending; }
+
 	const raul::managed_ptr<Ports>& external_ports() { return _ports; }
 
 	void set_external_ports(raul::managed_ptr<Ports>&& pa) { _ports = std::move(pa); }
@@ -198,10 +247,29 @@ public:
 	uint32_t internal_poly()         const { return _poly_pre; }
 	uint32_t internal_poly_process() const { return _poly_process; }
 
+	/** Return true iff a prepared polyphony change has not been applied yet. */
+	bool internal_poly_pending() const { return _poly_pending; }
+
+	/** Wait until any prepared polyphony change has been applied.
+	 *
+	 * Pre-process thread only.  This is woken by apply_internal_poly() when
+	 * the event that applies the change is executed.
+	 *
+	 * \return false if the change was not applied within `timeout`.
+	 */
+	bool wait_for_internal_poly(std::chrono::milliseconds timeout);
+
+	/** Activity of the internal voices of this graph. */
+	VoiceMask&       voice_mask()       { return _voice_mask; }
+	const VoiceMask& voice_mask() const { return _voice_mask; }
+
 	Engine& engine() { return _engine; }
 
 private:
 	using CompiledGraphPtr = std::unique_ptr<CompiledGraph>;
+	using SchedulePtr      = std::shared_ptr<const Task>;
+	using PolyBlocks       = raul::Array<BlockImpl*>;
+	using PolyBlocksPtr    = raul::managed_ptr<PolyBlocks>;
 
 	Engine&          _engine;
 	uint32_t         _poly_pre;       ///< Pre-process thread only
@@ -210,6 +278,13 @@ private:
 	PortList         _inputs;         ///< Pre-process thread only
 	PortList         _outputs;        ///< Pre-process thread only
 	Blocks           _blocks;         ///< Pre-process thread only
+	PolyBlocksPtr    _poly_blocks;    ///< Staged by prepare_internal_poly
+	std::atomic<bool> _poly_pending{false}; ///< Staged but not yet applied
+	raul::Semaphore  _poly_applied{0}; ///< Posted when staged poly is applied
+	SchedulePtr      _schedule;       ///< Pre-process thread only
+	bool             _schedule_incremental{false}; ///< Pre-process only
+	bool             _recompile_pending{false};    ///< Pre-process only
+	VoiceMask        _voice_mask;     ///< Activity of internal voices
 	bool             _process{false}; ///< True iff graph is enabled
 };
 
@@ -67,9 +67,18 @@ InputPort::apply_poly(RunContext& ctx, const uint32_t poly)
 	(void)ret;
 	assert(_voices->size() >= (ret ? poly : 1));
 
+	resend_values();
 	return true;
 }
 
+void
+InputPort::resend_values()
+{
+	for (const auto& arc : _arcs) {
+		arc.tail()->resend_values();
+	}
+}
+
 bool
 InputPort::get_buffers(BufferFactory&                   bufs,
                        PortImpl::GetFn                  get,
@@ -174,13 +183,15 @@ InputPort::pre_process(RunContext& ctx)
 }
 
 void
-InputPort::pre_run(RunContext& ctx)
+InputPort::pre_run(RunContext& ctx, uint32_t begin, uint32_t end)
 {
+	end = std::min(end, _poly);
+
 	if ((_user_buffer || !_arcs.empty()) && !direct_connect()) {
 		const uint32_t src_poly   = max_tail_poly(ctx);
 		const uint32_t max_n_srcs = (_arcs.size() * src_poly) + 1;
 
-		for (uint32_t v = 0; v < _poly; ++v) {
+		for (uint32_t v = begin; v < end; ++v) {
 			if (!buffer(v)->get<void>()) {
 				continue;
 			}
@@ -196,11 +207,15 @@ InputPort::pre_run(RunContext& ctx)
 
 			for (const auto& arc : _arcs) {
 				if (_poly == 1) {
-					// P -> 1 or 1 -> 1: all tail voices => each head voice
+					// P -> 1 or 1 -> 1: all active tail voices => each head voice
+					const BlockImpl* const tail = arc.tail()->parent_block();
 					for (uint32_t w = 0; w < arc.tail()->poly(); ++w) {
-						assert(n_srcs < max_n_srcs);
-						srcs[n_srcs++] = arc.buffer(ctx, w).get();
-						assert(srcs[n_srcs - 1]);
+						if (tail->voice_active(ctx, w)) {
+							assert(n_srcs < max_n_srcs);
+							srcs[n_srcs++] = arc.buffer(ctx, w).get();
+							assert(srcs[n_srcs - 1]);
+							tail->listen(ctx, w, *srcs[n_srcs - 1]);
+						}
 					}
 				} else {
 					// P -> P or 1 -> P: tail voice => corresponding head voice
@@ -215,14 +230,17 @@ InputPort::pre_run(RunContext& ctx)
 			update_values(ctx.offset(), v);
 		}
 	} else if (is_a(PortType::CONTROL)) {
-		for (uint32_t v = 0; v < _poly; ++v) {
+		for (uint32_t v = begin; v < end; ++v) {
 			update_values(ctx.offset(), v);
 		}
 	}
 }
 
 SampleCount
-InputPort::next_value_offset(SampleCount offset, SampleCount end) const
+InputPort::next_value_offset(SampleCount offset,
+                             SampleCount end,
+                             uint32_t    voice_begin,
+                             uint32_t    voice_end) const
 {
 	SampleCount earliest = end;
 
@@ -231,13 +249,40 @@ InputPort::next_value_offset(SampleCount offset, SampleCount end) const
 	}
 
 	for (const auto& arc : _arcs) {
-		const SampleCount o = arc.tail()->next_value_offset(offset, end);
+		// Only consider the tail voices that are mixed into these voices
+		const PortImpl* const tail = arc.tail();
+		const SampleCount     o =
+			(_poly == 1 || tail->poly() == 1)
+				? tail->next_value_offset(offset, end)
+				: tail->next_value_offset(offset, end, voice_begin, voice_end);
+
 		earliest = std::min(o, earliest);
 	}
 
 	return earliest;
 }
 
+void
+InputPort::value_offsets(SampleCount end,
+                         uint32_t    voice_begin,
+                         uint32_t    voice_end,
+                         OffsetSet&  offsets) const
+{
+	if (_user_buffer) {
+		_user_buffer->value_offsets(end, offsets);
+	}
+
+	for (const auto& arc : _arcs) {
+		// Only consider the tail voices that are mixed into these voices
+		const PortImpl* const tail = arc.tail();
+		if (_poly == 1 || tail->poly() == 1) {
+			tail->value_offsets(end, 0, tail->poly(), offsets);
+		} else {
+			tail->value_offsets(end, voice_begin, voice_end, offsets);
+		}
+	}
+}
+
 void
 InputPort::post_process(RunContext& ctx)
 {
@@ -44,6 +44,7 @@ namespace server {
 
 class BlockImpl;
 class BufferFactory;
+class OffsetSet;
 class RunContext;
 
 /** An input port on a Block or Graph.
@@ -79,6 +80,14 @@ public:
 
 	bool apply_poly(RunContext& ctx, uint32_t poly) override;
 
+	/** Ask every tail to emit its value in the next cycle.
+	 *
+	 * An input has no values of its own to emit.  This is called after this
+	 * port gets new buffers, so that the tails fill them.  Graph ports pass
+	 * the request on to their own tails.
+	 */
+	void resend_values() override;
+
 	/** Add an arc.  Realtime safe.
 	 *
 	 * The buffer of this port will be set directly to the arc's buffer
@@ -110,14 +119,25 @@ public:
 	/** Set up buffer pointers. */
 	void pre_process(RunContext& ctx) override;
 
+	using PortImpl::pre_run;
+
 	/** Prepare buffer for access, mixing if necessary. */
-	void pre_run(RunContext& ctx) override;
+	void pre_run(RunContext& ctx, uint32_t begin, uint32_t end) override;
 
 	/** Prepare buffer for next process cycle. */
 	void post_process(RunContext& ctx) override;
 
-	SampleCount
-	next_value_offset(SampleCount offset, SampleCount end) const override;
+	using PortImpl::next_value_offset;
+
+	SampleCount next_value_offset(SampleCount offset,
+	                              SampleCount end,
+	                              uint32_t    voice_begin,
+	                              uint32_t    voice_end) const override;
+
+	void value_offsets(SampleCount end,
+	                   uint32_t    voice_begin,
+	                   uint32_t    voice_end,
+	                   OffsetSet&  offsets) const override;
 
 	size_t num_arcs() const override { return _num_arcs; }
 	void   increment_num_arcs() { ++_num_arcs; }
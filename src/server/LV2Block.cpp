@@ -16,6 +16,7 @@
 
 #include "LV2Block.hpp"
 
+#include "BlockFactory.hpp"
 #include "Buffer.hpp"
 #include "BufferFactory.hpp"
 #include "Engine.hpp"
@@ -52,13 +53,15 @@
 
 #include <algorithm>
 #include <cassert>
-#include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace ingen::server {
 
@@ -95,10 +98,19 @@ LV2Block::make_instance(URIs&      uris,
                         uint32_t   voice,
                         bool       preparing)
 {
-	const Engine&     engine = parent_graph()->engine();
-	const LilvPlugin* lplug  = _lv2_plugin->lilv_plugin();
-	LilvInstance*     inst   = lilv_plugin_instantiate(
-		lplug, rate, _features->array());
+	const Engine&     engine      = parent_graph()->engine();
+	const LilvPlugin* lplug       = _lv2_plugin->lilv_plugin();
+	LilvInstance*     inst        = nullptr;
+	bool              has_options = false;
+	{
+		const std::lock_guard<std::mutex> lilv_lock{
+			engine.block_factory()->lilv_mutex()};
+		const std::lock_guard<std::mutex> lock{*_library_mutex};
+
+		inst        = lilv_plugin_instantiate(lplug, rate, _features->array());
+		has_options = inst && lilv_plugin_has_extension_data(
+			lplug, uris.opt_interface);
+	}
 
 	if (!inst) {
 		engine.log().error("Failed to instantiate <%1%>\n",
@@ -107,7 +119,7 @@ LV2Block::make_instance(URIs&      uris,
 	}
 
 	const LV2_Options_Interface* options_iface = nullptr;
-	if (lilv_plugin_has_extension_data(lplug, uris.opt_interface)) {
+	if (has_options) {
 		options_iface = static_cast<const LV2_Options_Interface*>(
 			lilv_instance_get_extension_data(inst, LV2_OPTIONS__interface));
 	}
@@ -224,6 +236,85 @@ LV2Block::apply_poly(RunContext& ctx, uint32_t poly)
 	return BlockImpl::apply_poly(ctx, poly);
 }
 
+#ifndef NDEBUG
+/** Return true iff `port` matches per-port queries of its plugin's data.
+ *
+ * Ports are built from the port table of LV2Plugin, which reads the ranges
+ * of all ports at once, so this checks the table against lilv directly.  The
+ * lilv mutex must be held.
+ */
+static bool
+matches_lilv_port(const URIs&                uris,
+                  URIMap&                    map,
+                  const LilvPlugin*          plug,
+                  const LV2Plugin::PortInfo& info,
+                  const PortImpl&            port)
+{
+	const LilvPort* const id = lilv_plugin_get_port_by_index(plug, port.index());
+	if (!id || port.symbol() != lilv_node_as_string(
+		           lilv_port_get_symbol(plug, id))) {
+		return false;
+	}
+
+	if (port.is_input() != lilv_port_is_a(plug, id, uris.lv2_InputPort)) {
+		return false;
+	}
+
+	const auto is_number = [](const LilvNode* node) {
+		return lilv_node_is_float(node) || lilv_node_is_int(node);
+	};
+
+	bool matches = true;
+	if (port.is_input() &&
+	    (port.is_a(PortType::CONTROL) || port.is_a(PortType::CV))) {
+		// Default, minimum, and maximum
+		LilvNode* def = nullptr;
+		LilvNode* min = nullptr;
+		LilvNode* max = nullptr;
+		lilv_port_get_range(plug, id, &def, &min, &max);
+		if (is_number(def)) {
+			matches = matches &&
+			          port.value() == uris.forge.make(lilv_node_as_float(def));
+		}
+		if (is_number(min)) {
+			matches = matches &&
+			          port.minimum() == uris.forge.make(lilv_node_as_float(min));
+		}
+		if (is_number(max)) {
+			matches = matches &&
+			          port.maximum() == uris.forge.make(lilv_node_as_float(max));
+		}
+		lilv_node_free(def);
+		lilv_node_free(min);
+		lilv_node_free(max);
+	} else if (port.is_a(PortType::ATOM)) {
+		// Buffer type, and size which must fit the minimum and any default
+		LilvNode* type = lilv_port_get(plug, id, uris.atom_bufferType);
+		if (type && lilv_node_is_uri(type)) {
+			matches = matches &&
+			          port.buffer_type() == map.map_uri(lilv_node_as_uri(type));
+		}
+		lilv_node_free(type);
+
+		LilvNode* size = lilv_port_get(plug, id, uris.rsz_minimumSize);
+		if (size && lilv_node_is_int(size)) {
+			matches = matches && info.min_buffer_size >=
+			                         static_cast<uint32_t>(lilv_node_as_int(size));
+		}
+		lilv_node_free(size);
+
+		LilvNode* def = lilv_port_get(plug, id, uris.lv2_default);
+		if (def && lilv_node_is_string(def)) {
+			matches = matches && info.min_buffer_size >=
+			                         strlen(lilv_node_as_string(def));
+		}
+		lilv_node_free(def);
+	}
+
+	return matches;
+}
+#endif
+
 /** Instantiate self from LV2 plugin descriptor.
  *
  * Implemented as a separate function (rather than in the constructor) to
@@ -235,197 +326,80 @@ LV2Block::apply_poly(RunContext& ctx, uint32_t poly)
 bool
 LV2Block::instantiate(BufferFactory& bufs, const LilvState* state)
 {
-	const ingen::URIs& uris      = bufs.uris();
-	ingen::World&      world     = bufs.engine().world();
-	const LilvPlugin*  plug      = _lv2_plugin->lilv_plugin();
-	ingen::Forge&      forge     = bufs.forge();
-	const uint32_t     num_ports = lilv_plugin_get_num_ports(plug);
+	const ingen::URIs& uris    = bufs.uris();
+	ingen::World&      world   = bufs.engine().world();
+	BlockFactory&      factory = *bufs.engine().block_factory();
+	const LilvPlugin*  plug    = _lv2_plugin->lilv_plugin();
+
+	// Blocks may be instantiated in parallel, but lilv is not thread-safe, so
+	// only the calls that use the LV2 world hold the lilv mutex
+	const std::vector<LV2Plugin::PortInfo>* infos = nullptr;
+	{
+		const std::lock_guard<std::mutex> lilv_lock{factory.lilv_mutex()};
+
+		_library_mutex = &factory.library_mutex(plug);
+		infos          = &_lv2_plugin->port_infos();
+	}
 
-	LilvNode* lv2_connectionOptional = lilv_new_uri(
-		world.lilv_world(), LV2_CORE__connectionOptional);
+	const auto&    port_infos = *infos;
+	const uint32_t num_ports  = static_cast<uint32_t>(port_infos.size());
 
 	_ports = bufs.maid().make_managed<BlockImpl::Ports>(num_ports, nullptr);
 
-	bool ret = true;
-
-	auto* min_values = new float[num_ports];
-	auto* max_values = new float[num_ports];
-	auto* def_values = new float[num_ports];
-	lilv_plugin_get_port_ranges_float(plug, min_values, max_values, def_values);
+	bool     ret               = true;
 	uint32_t max_sequence_size = 0;
-
-	// Get all the necessary information about ports
 	for (uint32_t j = 0; j < num_ports; ++j) {
-		const LilvPort* id = lilv_plugin_get_port_by_index(plug, j);
-
-		/* LV2 port symbols are guaranteed to be unique, valid C identifiers,
-		   and Lilv guarantees that lilv_port_get_symbol() is valid. */
-		const raul::Symbol port_sym(
-			lilv_node_as_string(lilv_port_get_symbol(plug, id)));
-
-		// Get port type
-		Atom     val;
-		PortType port_type     = PortType::UNKNOWN;
-		LV2_URID buffer_type   = 0;
-		bool     is_morph      = false;
-		bool     is_auto_morph = false;
-		if (lilv_port_is_a(plug, id, uris.lv2_ControlPort)) {
-			if (lilv_port_is_a(plug, id, uris.morph_MorphPort)) {
-				is_morph = true;
-				LilvNodes* types = lilv_port_get_value(
-					plug, id, uris.morph_supportsType);
-				LILV_FOREACH (nodes, i, types) {
-					const LilvNode* type = lilv_nodes_get(types, i);
-					if (lilv_node_equals(type, uris.lv2_CVPort)) {
-						port_type   = PortType::CV;
-						buffer_type = uris.atom_Sound;
-					}
-				}
-				lilv_nodes_free(types);
-			}
-			if (port_type == PortType::UNKNOWN) {
-				port_type   = PortType::CONTROL;
-				buffer_type = uris.atom_Sequence;
-			}
-		} else if (lilv_port_is_a(plug, id, uris.lv2_CVPort)) {
-			port_type   = PortType::CV;
-			buffer_type = uris.atom_Sound;
-		} else if (lilv_port_is_a(plug, id, uris.lv2_AudioPort)) {
-			port_type   = PortType::AUDIO;
-			buffer_type = uris.atom_Sound;
-		} else if (lilv_port_is_a(plug, id, uris.atom_AtomPort)) {
-			port_type = PortType::ATOM;
-		}
-
-		if (lilv_port_is_a(plug, id, uris.morph_AutoMorphPort)) {
-			is_auto_morph = true;
-		}
+		const LV2Plugin::PortInfo& info = port_infos[j];
 
-		// Get buffer type if necessary (atom ports)
-		if (!buffer_type) {
-			LilvNodes* types = lilv_port_get_value(
-				plug, id, uris.atom_bufferType);
-			LILV_FOREACH (nodes, i, types) {
-				const LilvNode* type = lilv_nodes_get(types, i);
-				if (lilv_node_is_uri(type)) {
-					buffer_type = world.uri_map().map_uri(
-						lilv_node_as_uri(type));
-				}
-			}
-			lilv_nodes_free(types);
-		}
-
-		const bool optional = lilv_port_has_property(
-			plug, id, lv2_connectionOptional);
-
-		uint32_t port_buffer_size = bufs.default_size(buffer_type);
-		if (port_buffer_size == 0 && !optional) {
+		uint32_t port_buffer_size = bufs.default_size(info.buffer_type);
+		if (port_buffer_size == 0 && !info.optional) {
 			parent_graph()->engine().log().error(
 				"<%1%> port `%2%' has unknown buffer type\n",
-				_lv2_plugin->uri().c_str(), port_sym.c_str());
+				_lv2_plugin->uri().c_str(), info.symbol.c_str());
 			ret = false;
 			break;
 		}
 
-		if (port_type == PortType::ATOM) {
-			// Get default value, and its length
-			LilvNodes* defaults = lilv_port_get_value(plug, id, uris.lv2_default);
-			LILV_FOREACH (nodes, i, defaults) {
-				const LilvNode* d = lilv_nodes_get(defaults, i);
-				if (lilv_node_is_string(d)) {
-					const char*    str_val     = lilv_node_as_string(d);
-					const uint32_t str_val_len = strlen(str_val);
-					val = forge.alloc(str_val);
-					port_buffer_size = std::max(port_buffer_size, str_val_len);
-				} else if (lilv_node_is_uri(d)) {
-					const char* uri_val = lilv_node_as_uri(d);
-					val = forge.make_urid(world.uri_map().map_uri(uri_val));
-				}
-			}
-			lilv_nodes_free(defaults);
-
-			if (!val.type() && buffer_type == _uris.atom_URID) {
-				val = forge.make_urid(0);
-			}
-
-			// Get minimum size, if set in data
-			LilvNodes* sizes = lilv_port_get_value(plug, id, uris.rsz_minimumSize);
-			LILV_FOREACH (nodes, i, sizes) {
-				const LilvNode* d = lilv_nodes_get(sizes, i);
-				if (lilv_node_is_int(d)) {
-					const uint32_t size_val = lilv_node_as_int(d);
-					port_buffer_size = std::max(port_buffer_size, size_val);
-				}
-			}
-			lilv_nodes_free(sizes);
+		if (info.type == PortType::ATOM) {
+			port_buffer_size  = std::max(port_buffer_size, info.min_buffer_size);
 			max_sequence_size = std::max(port_buffer_size, max_sequence_size);
 			bufs.set_seq_size(max_sequence_size);
 		}
 
-		enum { UNKNOWN, INPUT, OUTPUT } direction = UNKNOWN;
-		if (lilv_port_is_a(plug, id, uris.lv2_InputPort)) {
-			direction = INPUT;
-		} else if (lilv_port_is_a(plug, id, uris.lv2_OutputPort)) {
-			direction = OUTPUT;
-		}
-
-		if ((port_type == PortType::UNKNOWN && !optional) ||
-		    direction == UNKNOWN) {
+		using Direction = LV2Plugin::PortInfo::Direction;
+		if ((info.type == PortType::UNKNOWN && !info.optional) ||
+		    info.direction == Direction::UNKNOWN) {
 			parent_graph()->engine().log().error(
 				"<%1%> port `%2%' has unknown type or direction\n",
-				_lv2_plugin->uri().c_str(), port_sym.c_str());
+				_lv2_plugin->uri().c_str(), info.symbol.c_str());
 			ret = false;
 			break;
 		}
 
-		if (!val.type() && (port_type != PortType::ATOM)) {
-			// Ensure numeric ports have a value
-			if (!std::isnan(def_values[j])) {
-				val = forge.make(def_values[j]);
-			} else if (!std::isnan(min_values[j])) {
-				val = forge.make(min_values[j]);
-			} else if (!std::isnan(max_values[j])) {
-				val = forge.make(max_values[j]);
-			} else {
-				val = forge.make(0.0f);
-			}
-		}
-
-		PortImpl* port = (direction == INPUT)
+		const bool is_input = (info.direction == Direction::INPUT);
+		PortImpl*  port     = is_input
 			? static_cast<PortImpl*>(
-				new InputPort(bufs, this, port_sym, j, _polyphony,
-				              port_type, buffer_type, val))
+				new InputPort(bufs, this, info.symbol, j, _polyphony,
+				              info.type, info.buffer_type, info.value))
 			: static_cast<PortImpl*>(
-				new OutputPort(bufs, this, port_sym, j, _polyphony,
-				               port_type, buffer_type, val));
-
-		port->set_morphable(is_morph, is_auto_morph);
-		if (direction == INPUT && (port_type == PortType::CONTROL
-		                           || port_type == PortType::CV)) {
-			port->set_value(val);
-			if (!std::isnan(min_values[j])) {
-				port->set_minimum(forge.make(min_values[j]));
+				new OutputPort(bufs, this, info.symbol, j, _polyphony,
+				               info.type, info.buffer_type, info.value));
+
+		port->set_morphable(info.is_morph, info.is_auto_morph);
+		if (is_input && (info.type == PortType::CONTROL ||
+		                 info.type == PortType::CV)) {
+			port->set_value(info.value);
+			if (info.minimum.is_valid()) {
+				port->set_minimum(info.minimum);
 			}
-			if (!std::isnan(max_values[j])) {
-				port->set_maximum(forge.make(max_values[j]));
+			if (info.maximum.is_valid()) {
+				port->set_maximum(info.maximum);
 			}
 		}
 
 		// Inherit certain properties from plugin port
-		const LilvNode* preds[] = { uris.lv2_designation,
-		                            uris.lv2_portProperty,
-		                            uris.atom_supports,
-		                            nullptr };
-		for (int p = 0; preds[p]; ++p) {
-			LilvNodes* values = lilv_port_get_value(plug, id, preds[p]);
-			LILV_FOREACH (nodes, v, values) {
-				const LilvNode* value = lilv_nodes_get(values, v);
-				if (lilv_node_is_uri(value)) {
-					port->add_property(URI(lilv_node_as_uri(preds[p])),
-					                   forge.make_urid(URI(lilv_node_as_uri(value))));
-				}
-			}
-			lilv_nodes_free(values);
+		for (const auto& p : info.properties) {
+			port->add_property(p.first, p.second);
 		}
 
 		port->cache_properties();
@@ -433,17 +407,21 @@ LV2Block::instantiate(BufferFactory& bufs, const LilvState* state)
 		_ports->at(j) = port;
 	}
 
-	delete[] min_values;
-	delete[] max_values;
-	delete[] def_values;
-
-	lilv_node_free(lv2_connectionOptional);
-
 	if (!ret) {
 		_ports.reset();
 		return ret;
 	}
 
+#ifndef NDEBUG
+	{
+		const std::lock_guard<std::mutex> lilv_lock{factory.lilv_mutex()};
+		for (uint32_t j = 0; j < num_ports; ++j) {
+			assert(matches_lilv_port(
+				uris, world.uri_map(), plug, port_infos[j], *_ports->at(j)));
+		}
+	}
+#endif
+
 	_features = world.lv2_features().lv2_features(world, this);
 
 	// Actually create plugin instances and port buffers.
@@ -459,23 +437,29 @@ LV2Block::instantiate(BufferFactory& bufs, const LilvState* state)
 
 	// Load initial state if no state is explicitly given
 	StatePtr default_state{};
-	if (!state) {
-		default_state = load_preset(_lv2_plugin->uri());
-		state         = default_state.get();
-	}
+	bool     has_worker = false;
+	{
+		const std::lock_guard<std::mutex> lilv_lock{factory.lilv_mutex()};
+		if (!state) {
+			default_state = load_preset(_lv2_plugin->uri());
+			state         = default_state.get();
+		}
 
-	// Apply state
-	if (state) {
-		apply_state(nullptr, state);
+		has_worker = lilv_plugin_has_feature(plug, uris.work_schedule);
 	}
 
 	// FIXME: Polyphony + worker?
-	if (lilv_plugin_has_feature(plug, uris.work_schedule)) {
+	if (has_worker) {
 		_worker_iface = static_cast<const LV2_Worker_Interface*>(
 			lilv_instance_get_extension_data(instance(0),
 			                                 LV2_WORKER__interface));
 	}
 
+	// Apply state, which may be slow, without blocking other instantiation
+	if (state) {
+		apply_state(nullptr, state);
+	}
+
 	return ret;
 }
 
@@ -563,6 +547,8 @@ LV2Block::activate(BufferFactory& bufs)
 {
 	BlockImpl::activate(bufs);
 
+	// Blocks may be instantiated concurrently, see BlockLoader
+	const std::lock_guard<std::mutex> lock{*_library_mutex};
 	for (uint32_t i = 0; i < _polyphony; ++i) {
 		lilv_instance_activate(instance(i));
 	}
@@ -573,6 +559,7 @@ LV2Block::deactivate()
 {
 	BlockImpl::deactivate();
 
+	const std::lock_guard<std::mutex> lock{*_library_mutex};
 	for (uint32_t i = 0; i < _polyphony; ++i) {
 		lilv_instance_deactivate(instance(i));
 	}
@@ -609,7 +596,21 @@ LV2Block::work(uint32_t size, const void* data)
 void
 LV2Block::run(RunContext& ctx)
 {
-	for (uint32_t i = 0; i < _polyphony; ++i) {
+	run_voices(ctx, 0, _polyphony);
+}
+
+bool
+LV2Block::voices_independent() const
+{
+	/* Each voice is a separate instance, but worker responses are delivered
+	   to the first, so only blocks without a worker can be split. */
+	return _polyphonic && !_worker_iface;
+}
+
+void
+LV2Block::run_voices(RunContext& ctx, uint32_t begin, uint32_t end)
+{
+	for (uint32_t i = begin; i < std::min(end, _polyphony); ++i) {
 		lilv_instance_run(instance(i), ctx.nframes());
 	}
 }
@@ -685,6 +686,7 @@ LV2Block::apply_state(const std::unique_ptr<Worker>& worker,
 		state_features[0] = sched.get();
 	}
 
+	const std::lock_guard<std::mutex> lock{*_library_mutex};
 	for (uint32_t v = 0; v < _polyphony; ++v) {
 		lilv_state_restore(state, instance(v), nullptr, nullptr, 0, state_features);
 	}
@@ -90,6 +90,9 @@ public:
 	void run(RunContext& ctx) override;
 	void post_process(RunContext& ctx) override;
 
+	bool voices_independent() const override;
+	void run_voices(RunContext& ctx, uint32_t begin, uint32_t end) override;
+
 	StatePtr load_preset(const URI& uri) override;
 
 	void apply_state(const std::unique_ptr<Worker>& worker,
@@ -161,6 +164,7 @@ protected:
 	raul::managed_ptr<Instances>               _instances;
 	raul::managed_ptr<Instances>               _prepared_instances;
 	const LV2_Worker_Interface*                _worker_iface{nullptr};
+	std::mutex*                                _library_mutex{nullptr};
 	std::mutex                                 _work_mutex;
 	Responses                                  _responses;
 	std::shared_ptr<LV2Features::FeatureArray> _features;
@@ -18,17 +18,26 @@
 
 #include "Engine.hpp"
 #include "LV2Block.hpp"
+#include "PortType.hpp"
 
+#include <ingen/Atom.hpp>
 #include <ingen/Forge.hpp>
 #include <ingen/Log.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/URIMap.hpp>
 #include <ingen/URIs.hpp>
 #include <ingen/World.hpp>
 #include <lilv/lilv.h>
+#include <lv2/core/lv2.h>
 #include <raul/Symbol.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <string>
+#include <vector>
 
 namespace ingen::server {
 
@@ -67,6 +76,175 @@ LV2Plugin::update_properties()
 	lilv_node_free(micro);
 }
 
+const std::vector<LV2Plugin::PortInfo>&
+LV2Plugin::port_infos()
+{
+	if (!_port_infos_loaded) {
+		load_port_infos();
+		_port_infos_loaded = true;
+	}
+
+	return _port_infos;
+}
+
+void
+LV2Plugin::load_port_infos()
+{
+	const URIs&    uris      = _world.uris();
+	Forge&         forge     = _world.forge();
+	const uint32_t num_ports = lilv_plugin_get_num_ports(_lilv_plugin);
+
+	LilvNode* lv2_connectionOptional = lilv_new_uri(
+		_world.lilv_world(), LV2_CORE__connectionOptional);
+
+	std::vector<float> min_values(num_ports);
+	std::vector<float> max_values(num_ports);
+	std::vector<float> def_values(num_ports);
+	lilv_plugin_get_port_ranges_float(
+		_lilv_plugin, min_values.data(), max_values.data(), def_values.data());
+
+	_port_infos.clear();
+	_port_infos.reserve(num_ports);
+	for (uint32_t j = 0; j < num_ports; ++j) {
+		const LilvPlugin* plug = _lilv_plugin;
+		const LilvPort*   id   = lilv_plugin_get_port_by_index(plug, j);
+
+		/* LV2 port symbols are guaranteed to be unique, valid C identifiers,
+		   and Lilv guarantees that lilv_port_get_symbol() is valid. */
+		PortInfo& info = _port_infos.emplace_back(raul::Symbol(
+			lilv_node_as_string(lilv_port_get_symbol(plug, id))));
+
+		// Get port type
+		if (lilv_port_is_a(plug, id, uris.lv2_ControlPort)) {
+			if (lilv_port_is_a(plug, id, uris.morph_MorphPort)) {
+				info.is_morph = true;
+				LilvNodes* types = lilv_port_get_value(
+					plug, id, uris.morph_supportsType);
+				LILV_FOREACH (nodes, i, types) {
+					const LilvNode* type = lilv_nodes_get(types, i);
+					if (lilv_node_equals(type, uris.lv2_CVPort)) {
+						info.type        = PortType::CV;
+						info.buffer_type = uris.atom_Sound;
+					}
+				}
+				lilv_nodes_free(types);
+			}
+			if (info.type == PortType::UNKNOWN) {
+				info.type        = PortType::CONTROL;
+				info.buffer_type = uris.atom_Sequence;
+			}
+		} else if (lilv_port_is_a(plug, id, uris.lv2_CVPort)) {
+			info.type        = PortType::CV;
+			info.buffer_type = uris.atom_Sound;
+		} else if (lilv_port_is_a(plug, id, uris.lv2_AudioPort)) {
+			info.type        = PortType::AUDIO;
+			info.buffer_type = uris.atom_Sound;
+		} else if (lilv_port_is_a(plug, id, uris.atom_AtomPort)) {
+			info.type = PortType::ATOM;
+		}
+
+		if (lilv_port_is_a(plug, id, uris.morph_AutoMorphPort)) {
+			info.is_auto_morph = true;
+		}
+
+		// Get buffer type if necessary (atom ports)
+		if (!info.buffer_type) {
+			LilvNodes* types = lilv_port_get_value(
+				plug, id, uris.atom_bufferType);
+			LILV_FOREACH (nodes, i, types) {
+				const LilvNode* type = lilv_nodes_get(types, i);
+				if (lilv_node_is_uri(type)) {
+					info.buffer_type = _world.uri_map().map_uri(
+						lilv_node_as_uri(type));
+				}
+			}
+			lilv_nodes_free(types);
+		}
+
+		info.optional = lilv_port_has_property(
+			plug, id, lv2_connectionOptional);
+
+		if (info.type == PortType::ATOM) {
+			// Get default value, and its length
+			LilvNodes* defaults = lilv_port_get_value(plug, id, uris.lv2_default);
+			LILV_FOREACH (nodes, i, defaults) {
+				const LilvNode* d = lilv_nodes_get(defaults, i);
+				if (lilv_node_is_string(d)) {
+					const char*    str_val     = lilv_node_as_string(d);
+					const uint32_t str_val_len = strlen(str_val);
+					info.value = forge.alloc(str_val);
+					info.min_buffer_size =
+						std::max(info.min_buffer_size, str_val_len);
+				} else if (lilv_node_is_uri(d)) {
+					const char* uri_val = lilv_node_as_uri(d);
+					info.value =
+						forge.make_urid(_world.uri_map().map_uri(uri_val));
+				}
+			}
+			lilv_nodes_free(defaults);
+
+			if (!info.value.type() && info.buffer_type == uris.atom_URID) {
+				info.value = forge.make_urid(0);
+			}
+
+			// Get minimum size, if set in data
+			LilvNodes* sizes = lilv_port_get_value(plug, id, uris.rsz_minimumSize);
+			LILV_FOREACH (nodes, i, sizes) {
+				const LilvNode* d = lilv_nodes_get(sizes, i);
+				if (lilv_node_is_int(d)) {
+					const uint32_t size_val = lilv_node_as_int(d);
+					info.min_buffer_size = std::max(info.min_buffer_size, size_val);
+				}
+			}
+			lilv_nodes_free(sizes);
+		} else {
+			// Ensure numeric ports have a value
+			if (!std::isnan(def_values[j])) {
+				info.value = forge.make(def_values[j]);
+			} else if (!std::isnan(min_values[j])) {
+				info.value = forge.make(min_values[j]);
+			} else if (!std::isnan(max_values[j])) {
+				info.value = forge.make(max_values[j]);
+			} else {
+				info.value = forge.make(0.0f);
+			}
+
+			if (!std::isnan(min_values[j])) {
+				info.minimum = forge.make(min_values[j]);
+			}
+			if (!std::isnan(max_values[j])) {
+				info.maximum = forge.make(max_values[j]);
+			}
+		}
+
+		if (lilv_port_is_a(plug, id, uris.lv2_InputPort)) {
+			info.direction = PortInfo::Direction::INPUT;
+		} else if (lilv_port_is_a(plug, id, uris.lv2_OutputPort)) {
+			info.direction = PortInfo::Direction::OUTPUT;
+		}
+
+		// Record certain properties to be inherited from the plugin port
+		const LilvNode* preds[] = { uris.lv2_designation,
+		                            uris.lv2_portProperty,
+		                            uris.atom_supports,
+		                            nullptr };
+		for (int p = 0; preds[p]; ++p) {
+			LilvNodes* values = lilv_port_get_value(plug, id, preds[p]);
+			LILV_FOREACH (nodes, v, values) {
+				const LilvNode* value = lilv_nodes_get(values, v);
+				if (lilv_node_is_uri(value)) {
+					info.properties.emplace_back(
+						URI(lilv_node_as_uri(preds[p])),
+						forge.make_urid(URI(lilv_node_as_uri(value))));
+				}
+			}
+			lilv_nodes_free(values);
+		}
+	}
+
+	lilv_node_free(lv2_connectionOptional);
+}
+
 raul::Symbol
 LV2Plugin::symbol() const
 {
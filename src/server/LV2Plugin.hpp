@@ -18,9 +18,17 @@
 #define INGEN_ENGINE_LV2PLUGIN_HPP
 
 #include "PluginImpl.hpp"
+#include "PortType.hpp"
 
+#include <ingen/Atom.hpp>
 #include <ingen/URI.hpp>
 #include <lilv/lilv.h>
+#include <lv2/urid/urid.h>
+#include <raul/Symbol.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 namespace ingen {
 
@@ -33,6 +41,26 @@ namespace server {
 class LV2Plugin : public PluginImpl
 {
 public:
+	/** Description of a plugin port, shared by every instance. */
+	struct PortInfo {
+		enum class Direction { UNKNOWN, INPUT, OUTPUT };
+
+		explicit PortInfo(raul::Symbol sym) : symbol(std::move(sym)) {}
+
+		raul::Symbol                      symbol;
+		PortType                          type{PortType::UNKNOWN};
+		Direction                         direction{Direction::UNKNOWN};
+		LV2_URID                          buffer_type{0};
+		uint32_t                          min_buffer_size{0}; ///< Atom ports only
+		Atom                              value;              ///< Initial value
+		Atom                              minimum;            ///< Numeric only
+		Atom                              maximum;            ///< Numeric only
+		std::vector<std::pair<URI, Atom>> properties;         ///< Inherited
+		bool                              optional{false};
+		bool                              is_morph{false};
+		bool                              is_auto_morph{false};
+	};
+
 	LV2Plugin(World& world, const LilvPlugin* lplugin);
 
 	BlockImpl* instantiate(BufferFactory&      bufs,
@@ -47,6 +75,13 @@ public:
 	World&            world()       const { return _world; }
 	const LilvPlugin* lilv_plugin() const { return _lilv_plugin; }
 
+	/** Return a description of every port, in index order.
+	 *
+	 * This is loaded from the LV2 world on the first call, so the block
+	 * factory's lilv mutex must be held.
+	 */
+	const std::vector<PortInfo>& port_infos();
+
 	void update_properties() override;
 
 	void load_presets() override;
@@ -57,8 +92,12 @@ public:
 	}
 
 private:
-	World&            _world;
-	const LilvPlugin* _lilv_plugin;
+	void load_port_infos();
+
+	World&                _world;
+	const LilvPlugin*     _lilv_plugin;
+	std::vector<PortInfo> _port_infos;
+	bool                  _port_infos_loaded{false};
 };
 
 } // namespace server
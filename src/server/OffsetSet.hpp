@@ -0,0 +1,88 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_OFFSETSET_HPP
+#define INGEN_ENGINE_OFFSETSET_HPP
+
+#include "types.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace ingen::server {
+
+/** A set of frame offsets within a cycle.
+ *
+ * This is a bitmap with one bit per frame, so inserting is constant time
+ * regardless of how many times an offset is inserted, and finding the next
+ * offset scans at most one word per 64 frames.  Space is allocated up front by
+ * reserve(), so the set can be cleared and filled in the audio thread.
+ *
+ * \ingroup engine
+ */
+class OffsetSet
+{
+public:
+	/** Allocate space for cycles of up to `nframes` (not realtime safe). */
+	void reserve(SampleCount nframes) {
+		_words.assign((nframes + bits - 1U) / bits, 0U);
+	}
+
+	/** Return the longest cycle that this set has space for. */
+	SampleCount capacity() const {
+		return static_cast<SampleCount>(_words.size() * bits);
+	}
+
+	/** Remove all offsets in a cycle of `nframes`. */
+	void clear(SampleCount nframes) {
+		std::fill_n(_words.begin(), (nframes + bits - 1U) / bits, 0U);
+	}
+
+	/** Insert `offset`, which must be less than capacity(). */
+	void insert(SampleCount offset) {
+		_words[offset / bits] |= uint64_t{1U} << (offset % bits);
+	}
+
+	/** Return the first offset in [begin, end), or `end` if there is none. */
+	SampleCount next(SampleCount begin, SampleCount end) const {
+		uint64_t mask = ~uint64_t{0U} << (begin % bits);
+		for (SampleCount w = begin / bits; w * bits < end; ++w) {
+			uint64_t word = _words[w] & mask;
+			if (word) {
+				SampleCount offset = w * bits;
+				for (; !(word & 1U); word >>= 1U) {
+					++offset;
+				}
+
+				return std::min(offset, end);
+			}
+
+			mask = ~uint64_t{0U};
+		}
+
+		return end;
+	}
+
+private:
+	static constexpr SampleCount bits = 64U;
+
+	std::vector<uint64_t> _words;
+};
+
+} // namespace ingen::server
+
+#endif // INGEN_ENGINE_OFFSETSET_HPP
@@ -0,0 +1,240 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PluginCache.hpp"
+
+#include <ingen/FilePath.hpp>
+#include <lilv/lilv.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace ingen::server {
+
+namespace {
+
+/// First line of the file, the number must change with the format
+constexpr const char* const cache_header = "ingen-plugin-cache 1";
+
+const char*
+status_name(PluginCache::Entry::Status status)
+{
+	switch (status) {
+	case PluginCache::Entry::Status::SUPPORTED:
+		return "supported";
+	case PluginCache::Entry::Status::UNSUPPORTED_FEATURE:
+		return "feature";
+	case PluginCache::Entry::Status::UNSUPPORTED_PORT:
+		return "port";
+	}
+
+	return "";
+}
+
+} // namespace
+
+PluginCache::PluginCache(FilePath path)
+	: _path(std::move(path))
+{}
+
+void
+PluginCache::load()
+{
+	_bundles.clear();
+	_dirty = false;
+
+	std::ifstream in{_path};
+	std::string   line;
+	if (!in || !std::getline(in, line) || line != cache_header) {
+		return;
+	}
+
+	Bundle* bundle = nullptr;
+	while (std::getline(in, line)) {
+		std::istringstream ss{line};
+		std::string        kind;
+		ss >> kind;
+		if (kind == "bundle") {
+			int64_t     mtime = 0;
+			std::string uri;
+			if (ss >> mtime >> uri) {
+				bundle        = &_bundles[uri];
+				bundle->mtime = mtime;
+			} else {
+				bundle = nullptr;
+			}
+		} else if (kind == "plugin" && bundle) {
+			std::string status;
+			std::string uri;
+			Entry       entry;
+			if (!(ss >> status >> uri)) {
+				continue;
+			}
+
+			ss >> entry.detail;
+			if (status == "supported") {
+				entry.status = Entry::Status::SUPPORTED;
+			} else if (status == "feature") {
+				entry.status = Entry::Status::UNSUPPORTED_FEATURE;
+			} else if (status == "port") {
+				entry.status = Entry::Status::UNSUPPORTED_PORT;
+			} else {
+				continue;
+			}
+
+			bundle->plugins.emplace(uri, std::move(entry));
+		}
+	}
+}
+
+void
+PluginCache::save()
+{
+	// Drop bundles that no longer exist
+	for (auto b = _bundles.begin(); b != _bundles.end();) {
+		if (!b->second.checked) {
+			b      = _bundles.erase(b);
+			_dirty = true;
+		} else {
+			++b;
+		}
+	}
+
+	if (!_dirty || _path.empty()) {
+		return;
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(_path.parent_path(), ec);
+	if (ec) {
+		return;
+	}
+
+	// Write to a temporary file then replace, so the cache is never partial
+	const FilePath tmp_path{_path.string() + ".tmp"};
+	{
+		std::ofstream out{tmp_path};
+		out << cache_header << '\n';
+		for (const auto& b : _bundles) {
+			if (!b.second.mtime) {
+				continue;
+			}
+
+			out << "bundle " << b.second.mtime << ' ' << b.first << '\n';
+			for (const auto& p : b.second.plugins) {
+				out << "plugin " << status_name(p.second.status) << ' '
+				    << p.first;
+				if (!p.second.detail.empty()) {
+					out << ' ' << p.second.detail;
+				}
+				out << '\n';
+			}
+		}
+
+		if (!out) {
+			std::filesystem::remove(tmp_path, ec);
+			return;
+		}
+	}
+
+	std::filesystem::rename(tmp_path, _path, ec);
+	_dirty = static_cast<bool>(ec);
+}
+
+void
+PluginCache::revalidate()
+{
+	for (auto& b : _bundles) {
+		b.second.checked = false;
+	}
+}
+
+const PluginCache::Entry*
+PluginCache::find(const std::string& bundle_uri, const std::string& plugin_uri)
+{
+	const Bundle& b = bundle(bundle_uri);
+	const auto    p = b.plugins.find(plugin_uri);
+
+	return (b.mtime && p != b.plugins.end()) ? &p->second : nullptr;
+}
+
+void
+PluginCache::insert(const std::string& bundle_uri,
+                    const std::string& plugin_uri,
+                    Entry              entry)
+{
+	bundle(bundle_uri).plugins[plugin_uri] = std::move(entry);
+	_dirty = true;
+}
+
+PluginCache::Bundle&
+PluginCache::bundle(const std::string& uri)
+{
+	Bundle& b = _bundles[uri];
+	if (!b.checked) {
+		const int64_t mtime = bundle_mtime(uri);
+		if (!mtime || mtime != b.mtime) {
+			b.plugins.clear();
+			b.mtime = mtime;
+			_dirty  = true;
+		}
+
+		b.checked = true;
+	}
+
+	return b;
+}
+
+int64_t
+PluginCache::bundle_mtime(const std::string& uri)
+{
+	char* const path = lilv_file_uri_parse(uri.c_str(), nullptr);
+	if (!path) {
+		return 0;
+	}
+
+	const std::filesystem::path dir{path};
+	lilv_free(path);
+
+	// Use the newest of the bundle directory and the files in it
+	std::error_code ec;
+	auto            newest = std::filesystem::last_write_time(dir, ec);
+	if (ec) {
+		return 0;
+	}
+
+	for (std::filesystem::directory_iterator f{dir, ec}, end; !ec && f != end;
+	     f.increment(ec)) {
+		std::error_code file_ec;
+		const auto      time = f->last_write_time(file_ec);
+		if (!file_ec && time > newest) {
+			newest = time;
+		}
+	}
+
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	           newest.time_since_epoch())
+	    .count();
+}
+
+} // namespace ingen::server
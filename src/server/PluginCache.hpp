@@ -0,0 +1,94 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_PLUGINCACHE_HPP
+#define INGEN_ENGINE_PLUGINCACHE_HPP
+
+#include <ingen/FilePath.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace ingen::server {
+
+/** A persistent record of which installed LV2 plugins are supported.
+ *
+ * Checking the required features and port types of every installed plugin
+ * dominates startup on systems with many plugins, so the result for each
+ * plugin is saved with the modification time of its bundle.  The entries for
+ * a bundle are discarded when it is first looked up if it has changed since,
+ * so only plugins in changed bundles are checked again.
+ *
+ * The file is a versioned line-based text file in the user cache directory,
+ * which is small and read once at startup.
+ *
+ * \ingroup engine
+ */
+class PluginCache
+{
+public:
+	/** The result of checking whether a plugin is supported. */
+	struct Entry {
+		enum class Status { SUPPORTED, UNSUPPORTED_FEATURE, UNSUPPORTED_PORT };
+
+		Status      status{Status::SUPPORTED};
+		std::string detail; ///< Required feature URI or port symbol
+	};
+
+	explicit PluginCache(FilePath path);
+
+	/** Load the cache file, or start empty if it is missing or outdated. */
+	void load();
+
+	/** Save the cache file if it has changed.
+	 *
+	 * Bundles that have not been looked up since revalidate() are dropped.
+	 */
+	void save();
+
+	/** Check bundles against the disk again when they are next looked up. */
+	void revalidate();
+
+	/** Return the entry for a plugin, or null if it must be checked. */
+	const Entry* find(const std::string& bundle_uri,
+	                  const std::string& plugin_uri);
+
+	/** Record the result of checking a plugin. */
+	void insert(const std::string& bundle_uri,
+	            const std::string& plugin_uri,
+	            Entry              entry);
+
+private:
+	struct Bundle {
+		int64_t                      mtime{0};
+		bool                         checked{false}; ///< Compared to disk
+		std::map<std::string, Entry> plugins;
+	};
+
+	/** Return a bundle, discarding its entries if it has changed. */
+	Bundle& bundle(const std::string& uri);
+
+	static int64_t bundle_mtime(const std::string& uri);
+
+	FilePath                      _path;
+	std::map<std::string, Bundle> _bundles;
+	bool                          _dirty{false};
+};
+
+} // namespace ingen::server
+
+#endif // INGEN_ENGINE_PLUGINCACHE_HPP
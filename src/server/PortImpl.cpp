@@ -37,7 +37,10 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <cstdio>
+#include <limits>
 #include <memory>
 #include <utility>
 
@@ -67,6 +70,7 @@ PortImpl::PortImpl(BufferFactory&      bufs,
 	, _bufs(bufs)
 	, _index(index)
 	, _poly(poly)
+	, _poly_pre(poly)
 	, _buffer_size(buffer_size)
 	, _type(type)
 	, _buffer_type(buffer_type)
@@ -333,7 +337,9 @@ PortImpl::prepare_poly(BufferFactory& bufs, uint32_t poly)
 		return false;
 	}
 
+	_poly_pre = poly;
 	if (_poly == poly) {
+		_prepared_voices.reset();
 		return true;
 	}
 
@@ -349,11 +355,33 @@ PortImpl::prepare_poly(BufferFactory& bufs, uint32_t poly)
 	get_buffers(bufs, &BufferFactory::get_buffer,
 	            _prepared_voices, _prepared_voices->size(), num_arcs());
 
+	// Set values of the new buffers here, so applying only swaps voices
+	if (is_a(PortType::CONTROL) || is_a(PortType::CV)) {
+		const Sample value = _value.get<float>();
+		for (uint32_t v = 0; v < _prepared_voices->size(); ++v) {
+			Voice&  voice = _prepared_voices->at(v);
+			Buffer& buf   = *voice.buffer;
+			if (is_a(PortType::CONTROL)) {
+				if (buf.value()) {
+					const_cast<LV2_Atom_Float*>(
+						reinterpret_cast<const LV2_Atom_Float*>(buf.value()))
+						->body = value;
+				}
+			} else {
+				buf.set_block(
+					value, 0, buf.is_sequence() ? 0 : buf.capacity() / sizeof(Sample));
+			}
+
+			voice.set_state       = SetState();
+			voice.set_state.value = value;
+		}
+	}
+
 	return true;
 }
 
 bool
-PortImpl::apply_poly(RunContext& ctx, uint32_t poly)
+PortImpl::apply_poly(RunContext&, uint32_t poly)
 {
 	if (_parent->is_main() ||
 	    (_type == PortType::ATOM && !_value.is_valid())) {
@@ -366,21 +394,15 @@ PortImpl::apply_poly(RunContext& ctx, uint32_t poly)
 
 	assert(poly == _prepared_voices->size());
 
-	_poly = poly;
-
-	// Apply a new set of voices from a preceding call to prepare_poly
+	/* Apply the voices from a preceding call to prepare_poly(), which has
+	   already set their values.  The parent block connects the new buffers
+	   in pre_process() before it next runs, as it does every cycle. */
+	_poly   = poly;
 	_voices = std::move(_prepared_voices);
 
-	if (is_a(PortType::CONTROL) || is_a(PortType::CV)) {
-		set_control_value(ctx, ctx.start(), _value.get<float>());
-	}
-
 	assert(_voices->size() >= poly);
-	assert(this->poly() == poly);
 	assert(!_prepared_voices);
 
-	connect_buffers();
-
 	return true;
 }
 
@@ -397,9 +419,9 @@ PortImpl::set_buffer_size(RunContext&, BufferFactory&, size_t size)
 }
 
 void
-PortImpl::connect_buffers(SampleCount offset)
+PortImpl::connect_buffers(SampleCount offset, uint32_t begin, uint32_t end)
 {
-	for (uint32_t v = 0; v < _poly; ++v) {
+	for (uint32_t v = begin; v < std::min(end, _poly); ++v) {
 		PortImpl::parent_block()->set_port_buffer(v, _index, buffer(v), offset);
 	}
 }
@@ -468,8 +490,12 @@ PortImpl::monitor(RunContext& ctx, bool send_now)
 	case PortType::UNKNOWN:
 		break;
 	case PortType::AUDIO:
+		// Inactive voices are silent, so don't bother scanning them
 		key = uris.ingen_activity;
-		val = _peak = std::max(_peak, buffer(0)->peak(ctx));
+		if (parent_block()->voice_active(ctx, 0)) {
+			_peak = std::max(_peak, buffer(0)->peak(ctx));
+		}
+		val = _peak;
 		break;
 	case PortType::CONTROL:
 	case PortType::CV:
@@ -532,16 +558,74 @@ PortImpl::value_buffer(uint32_t voice) const
 }
 
 SampleCount
-PortImpl::next_value_offset(SampleCount offset, SampleCount end) const
+PortImpl::next_value_offset(SampleCount offset,
+                            SampleCount end,
+                            uint32_t    voice_begin,
+                            uint32_t    voice_end) const
 {
 	SampleCount earliest = end;
-	for (uint32_t v = 0; v < _poly; ++v) {
+	for (uint32_t v = voice_begin; v < std::min(voice_end, _poly); ++v) {
 		const SampleCount o = _voices->at(v).buffer->next_value_offset(offset, end);
         earliest = std::min(o, earliest);
 	}
 	return earliest;
 }
 
+void
+PortImpl::value_offsets(SampleCount end,
+                        uint32_t    voice_begin,
+                        uint32_t    voice_end,
+                        OffsetSet&  offsets) const
+{
+	for (uint32_t v = voice_begin; v < std::min(voice_end, _poly); ++v) {
+		_voices->at(v).buffer->value_offsets(end, offsets);
+	}
+}
+
+void
+PortImpl::emit_values(SampleCount offset,
+                      uint32_t    voice_begin,
+                      uint32_t    voice_end,
+                      float       epsilon)
+{
+	const URIs& uris = _bufs.uris();
+	for (uint32_t v = voice_begin; v < std::min(voice_end, _poly); ++v) {
+		Voice&          voice = _voices->at(v);
+		Buffer&         buf   = *voice.buffer;
+		const LV2_Atom* value = buf.value();
+		if (value->type == uris.atom_Float) {
+			const float f       = reinterpret_cast<const LV2_Atom_Float*>(value)->body;
+			const bool  settled = (f == voice.observed);
+			voice.observed      = f;
+			if (f == voice.emitted ||
+			    (!settled && std::fabs(f - voice.emitted) <= epsilon)) {
+				continue; // Not significantly changed since the last event
+			}
+
+			if (offset > 0 && buf.size() == sizeof(LV2_Atom_Sequence) &&
+			    !std::isnan(voice.emitted)) {
+				// First event this cycle, start with the previous value
+				buf.append_event(0,
+				                 sizeof(voice.emitted),
+				                 uris.atom_Float,
+				                 reinterpret_cast<const uint8_t*>(&voice.emitted));
+			}
+
+			voice.emitted = f;
+		}
+
+		buf.append_event(offset, value);
+	}
+}
+
+void
+PortImpl::resend_values()
+{
+	for (uint32_t v = 0; v < _voices->size(); ++v) {
+		_voices->at(v).emitted = std::numeric_limits<float>::quiet_NaN();
+	}
+}
+
 void
 PortImpl::update_values(SampleCount offset, uint32_t voice) const
 {
@@ -557,12 +641,17 @@ PortImpl::pre_process(RunContext& ctx)
 	}
 
 	for (uint32_t v = 0; v < _poly; ++v) {
-		_voices->at(v).buffer->prepare_output_write(ctx);
+		if (_type == PortType::CONTROL) {
+			// Written by emit_values(), which may append nothing
+			_voices->at(v).buffer->prepare_write(ctx);
+		} else {
+			_voices->at(v).buffer->prepare_output_write(ctx);
+		}
 	}
 }
 
 void
-PortImpl::pre_run(RunContext&)
+PortImpl::pre_run(RunContext&, uint32_t, uint32_t)
 {}
 
 void
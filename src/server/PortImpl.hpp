@@ -33,6 +33,7 @@
 #include <atomic>
 #include <cstdint>
 #include <cstdlib>
+#include <limits>
 #include <utility>
 
 namespace raul {
@@ -48,6 +49,7 @@ class Properties;
 namespace server {
 
 class BlockImpl;
+class OffsetSet;
 
 /** A port (input or output) on a Block.
  *
@@ -93,6 +95,12 @@ public:
 	struct Voice {
 		SetState  set_state;
 		BufferRef buffer{nullptr};
+
+		/// Last value emitted as an event, or NaN to emit in the next chunk
+		float emitted{std::numeric_limits<float>::quiet_NaN()};
+
+		/// Value after the last chunk, to detect when it stops changing
+		float observed{std::numeric_limits<float>::quiet_NaN()};
 	};
 
 	using Voices = raul::Array<Voice>;
@@ -135,6 +143,27 @@ public:
 	const Atom& value() const { return _value; }
 	void        set_value(const Atom& v) { _value = v; }
 
+	/** Note that an event set the value, taking effect at `time`.
+	 *
+	 * This is called in the pre-process thread, and used in the main thread
+	 * to discard values from older notifications.
+	 */
+	void set_value_time(FrameTime time) {
+		_value_time.store(time, std::memory_order_relaxed);
+		_value_time_set.store(true, std::memory_order_release);
+	}
+
+	/** Return true if an event has set the value at or after `time`. */
+	bool value_set_since(FrameTime time) const {
+		if (!_value_time_set.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		// Wrap-safe comparison of (set time >= time)
+		const FrameTime set_time = _value_time.load(std::memory_order_relaxed);
+		return static_cast<int32_t>(set_time - time) >= 0;
+	}
+
 	const Atom& minimum() const { return _min; }
 	const Atom& maximum() const { return _max; }
 
@@ -178,9 +207,12 @@ public:
 
 	/** Called once per process cycle */
 	virtual void pre_process(RunContext& ctx);
-	virtual void pre_run(RunContext& ctx);
+	void         pre_run(RunContext& ctx) { pre_run(ctx, 0, _poly); }
 	virtual void post_process(RunContext& ctx);
 
+	/** Prepare voices [begin, end) for reading in the current slice. */
+	virtual void pre_run(RunContext& ctx, uint32_t begin, uint32_t end);
+
 	/** Clear/silence all buffers */
 	virtual void clear_buffers(const RunContext& ctx);
 
@@ -200,7 +232,14 @@ public:
 	                               Properties&     remove,
 	                               Properties&     add) {}
 
-	virtual void connect_buffers(SampleCount offset=0);
+	void connect_buffers(SampleCount offset=0) {
+		connect_buffers(offset, 0, _poly);
+	}
+
+	/** Connect the buffers of voices [begin, end) to the parent block. */
+	virtual void
+	connect_buffers(SampleCount offset, uint32_t begin, uint32_t end);
+
 	virtual void recycle_buffers();
 
 	uint32_t index() const { return _index; }
@@ -221,8 +260,14 @@ public:
 	uint32_t poly() const {
 		return _poly;
 	}
+
+	/** Return the polyphony this port will have once prepared changes apply.
+	 *
+	 * Pre-process thread only.  This differs from poly() while a change
+	 * prepared by prepare_poly() is waiting to be applied.
+	 */
 	uint32_t prepared_poly() const {
-		return (_prepared_voices) ? _prepared_voices->size() : 1;
+		return _poly_pre;
 	}
 
 	void set_buffer_size(RunContext& ctx, BufferFactory& bufs, size_t size);
@@ -253,8 +298,50 @@ public:
 	}
 
 	/** Return offset of the first value change after `offset`. */
+	SampleCount next_value_offset(SampleCount offset, SampleCount end) const {
+		return next_value_offset(offset, end, 0, _poly);
+	}
+
+	/** Return offset of the first value change in some voices.
+	 *
+	 * This only considers the voices in [voice_begin, voice_end), so it can
+	 * be called while other voices are being processed.
+	 */
 	virtual SampleCount next_value_offset(SampleCount offset,
-	                                      SampleCount end) const;
+	                                      SampleCount end,
+	                                      uint32_t    voice_begin,
+	                                      uint32_t    voice_end) const;
+
+	/** Insert the offsets of all value changes in some voices.
+	 *
+	 * This finds every offset that next_value_offset() would return before
+	 * `end`, but scans each buffer only once.
+	 */
+	virtual void value_offsets(SampleCount end,
+	                           uint32_t    voice_begin,
+	                           uint32_t    voice_end,
+	                           OffsetSet&  offsets) const;
+
+	/** Append the current value of some output voices as events.
+	 *
+	 * A voice is only emitted if it has changed by more than `epsilon` since
+	 * the last event, in this cycle or an earlier one.  A smaller change is
+	 * emitted once the value holds for a chunk, so readers always end up
+	 * with the exact value.  The first event in a cycle after the start is
+	 * preceded by the previous value at offset 0, so the sequence alone
+	 * still gives the value over the whole cycle.
+	 */
+	void emit_values(SampleCount offset,
+	                 uint32_t    voice_begin,
+	                 uint32_t    voice_end,
+	                 float       epsilon);
+
+	/** Emit the value of every voice in the next cycle, even if unchanged.
+	 *
+	 * This is called when a port that mixes this one gets new buffers, which
+	 * only have the default value until this one emits.
+	 */
+	virtual void resend_values();
 
 	/** Update value buffer for `voice` to be current as of `offset`. */
 	void update_values(SampleCount offset, uint32_t voice) const;
@@ -297,6 +384,7 @@ protected:
 	BufferFactory&            _bufs;
 	uint32_t                  _index;
 	uint32_t                  _poly;
+	uint32_t                  _poly_pre; ///< Pre-process thread only
 	uint32_t                  _buffer_size;
 	uint32_t                  _frames_since_monitor{0};
 	float                     _monitor_value{0.0f};
@@ -310,6 +398,8 @@ protected:
 	raul::managed_ptr<Voices> _prepared_voices;
 	BufferRef                 _user_buffer;
 	std::atomic_flag          _connected_flag{false};
+	std::atomic<FrameTime>    _value_time{0};
+	std::atomic<bool>         _value_time_set{false};
 	bool                      _monitored{false};
 	bool                      _force_monitor_update{false};
 	bool                      _is_morph{false};
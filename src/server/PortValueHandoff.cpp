@@ -0,0 +1,92 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PortValueHandoff.hpp"
+
+#include "PortImpl.hpp"
+#include "util.hpp"
+
+#include <ingen/Atom.hpp>
+#include <ingen/Store.hpp>
+#include <ingen/URI.hpp>
+#include <ingen/URIs.hpp>
+
+#include <cstdint>
+#include <mutex>
+
+namespace ingen::server {
+
+void
+PortValueHandoff::set(const PortImpl& port,
+                      const FrameTime time,
+                      const URI&      key,
+                      uint32_t        size,
+                      LV2_URID        type,
+                      const void*     body)
+{
+	auto p = _ports.find(port.path());
+	if (p == _ports.end()) {
+		p = _ports.emplace(port.path(), Values{}).first;
+	}
+
+	auto v = p->second.find(key);
+	if (v == p->second.end()) {
+		v = p->second.emplace(key, Value{}).first;
+	}
+
+	set_atom(v->second.atom, size, type, body);
+	v->second.time    = time;
+	v->second.pending = true;
+	_pending          = true;
+}
+
+void
+PortValueHandoff::apply(Store& store)
+{
+	if (!_pending) {
+		return;
+	}
+
+	const std::unique_lock<Store::Mutex> lock{store.mutex(), std::try_to_lock};
+	if (!lock.owns_lock()) {
+		return; // Store is busy, try again next time
+	}
+
+	for (auto p = _ports.begin(); p != _ports.end();) {
+		auto* const port = dynamic_cast<PortImpl*>(store.get(p->first));
+		if (!port) {
+			p = _ports.erase(p); // Port has been deleted
+			continue;
+		}
+
+		for (auto& v : p->second) {
+			if (v.second.pending) {
+				if (v.first != _uris.ingen_value ||
+				    !port->value_set_since(v.second.time)) {
+					port->set_property(v.first, v.second.atom);
+				} // else a newer value has been set by an event since
+
+				v.second.pending = false;
+			}
+		}
+
+		++p;
+	}
+
+	_pending = false;
+}
+
+} // namespace ingen::server
@@ -0,0 +1,91 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_PORTVALUEHANDOFF_HPP
+#define INGEN_ENGINE_PORTVALUEHANDOFF_HPP
+
+#include "types.hpp"
+
+#include <ingen/Atom.hpp>
+#include <ingen/URI.hpp>
+#include <lv2/urid/urid.h>
+#include <raul/Path.hpp>
+
+#include <cstdint>
+#include <map>
+
+namespace ingen {
+
+class Store;
+class URIs;
+
+namespace server {
+
+class PortImpl;
+
+/** Hands values from port notifications over to port properties.
+ *
+ * Port properties are otherwise only accessed by events with the store
+ * locked.  So values from notifications are collected here, with only the
+ * latest kept for each port and key, and applied to ports whenever the store
+ * can be locked without waiting.  Ports are found by path at that point, so
+ * values for ports that have been deleted in the meantime are discarded.
+ * Values are also discarded if an event has since set the port value to take
+ * effect at or after the time of the notification, since the value from the
+ * notification is then stale.
+ *
+ * Entries are reused, so once every monitored port has a value, this
+ * allocates nothing.
+ *
+ * \ingroup engine
+ */
+class PortValueHandoff
+{
+public:
+	explicit PortValueHandoff(const URIs& uris) : _uris(uris) {}
+
+	/** Set a pending property value for a port (main thread).
+	 *
+	 * \param time Time the value was set in the audio thread.
+	 */
+	void set(const PortImpl& port,
+	         FrameTime       time,
+	         const URI&      key,
+	         uint32_t        size,
+	         LV2_URID        type,
+	         const void*     body);
+
+	/** Apply pending values if the store is unlocked (main thread). */
+	void apply(Store& store);
+
+private:
+	struct Value {
+		Atom      atom;
+		FrameTime time{0};
+		bool      pending{false};
+	};
+
+	using Values = std::map<URI, Value>;
+
+	const URIs&                  _uris;
+	std::map<raul::Path, Values> _ports;
+	bool                         _pending{false};
+};
+
+} // namespace server
+} // namespace ingen
+
+#endif // INGEN_ENGINE_PORTVALUEHANDOFF_HPP
@@ -83,6 +83,7 @@ PostProcessor::process()
 	if (!next || next->time() >= end_time) {
 		// Process audio thread notifications until end
 		_engine.emit_notifications(end_time);
+		_engine.update_profiles();
 		return;
 	}
 
@@ -107,6 +108,9 @@ PostProcessor::process()
 
 	// Process remaining audio thread notifications until end
 	_engine.emit_notifications(end_time);
+
+	// Collect profiling statistics from the audio thread
+	_engine.update_profiles();
 }
 
 } // namespace ingen::server
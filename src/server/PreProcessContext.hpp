@@ -63,9 +63,10 @@ public:
 	 * This may return null when an atomic bundle is deferring compilation, in
 	 * which case the graph is flagged as dirty for later compilation.
 	 */
-	[[nodiscard]] std::unique_ptr<CompiledGraph> maybe_compile(GraphImpl& graph)
+	[[nodiscard]] std::unique_ptr<CompiledGraph>
+	maybe_compile(GraphImpl& graph, bool full = false)
 	{
-		return must_compile(graph) ? compile(graph) : nullptr;
+		return must_compile(graph) ? compile(graph, full) : nullptr;
 	}
 
 	/** Return all graphs that require compilation after an atomic bundle. */
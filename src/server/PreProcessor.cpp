@@ -16,14 +16,19 @@
 
 #include "PreProcessor.hpp"
 
+#include "BlockImpl.hpp"
+#include "BlockLoader.hpp"
+#include "CompiledGraph.hpp"
 #include "Engine.hpp"
 #include "Event.hpp"
+#include "GraphImpl.hpp"
 #include "PostProcessor.hpp"
 #include "PreProcessContext.hpp"
 #include "RunContext.hpp"
 #include "ThreadManager.hpp"
 #include "UndoStack.hpp"
 
+#include <events/Recompile.hpp>
 #include <ingen/Atom.hpp>
 #include <ingen/AtomWriter.hpp>
 #include <ingen/Configuration.hpp>
@@ -31,6 +36,7 @@
 #include <raul/Semaphore.hpp>
 
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <memory>
@@ -55,26 +61,57 @@ PreProcessor::~PreProcessor()
 void
 PreProcessor::event(Event* const ev, Event::Mode mode)
 {
-	// TODO: Probably possible to make this lock-free with CAS
 	ThreadManager::assert_not_thread(THREAD_IS_REAL_TIME);
-	const std::lock_guard<std::mutex> lock{_mutex};
 
 	assert(!ev->is_prepared());
 	assert(!ev->next());
 	ev->set_mode(mode);
 
+	// Push onto the incoming stack, which run() reverses into the queue
+	++_n_incoming;
+	Event* top = _incoming.load(std::memory_order_relaxed);
+	do {
+		ev->next(top);
+	} while (!_incoming.compare_exchange_weak(top,
+	                                          ev,
+	                                          std::memory_order_release,
+	                                          std::memory_order_relaxed));
+
+	_sem.post();
+}
+
+void
+PreProcessor::append_incoming()
+{
+	Event* ev = _incoming.exchange(nullptr, std::memory_order_acquire);
+	if (!ev) {
+		return;
+	}
+
+	// Reverse the stack to get events in the order they were submitted
+	Event* const last  = ev;
+	Event*       first = nullptr;
+	size_t       count = 0;
+	while (ev) {
+		Event* const next = ev->next();
+		ev->next(first);
+		first = ev;
+		ev    = next;
+		++count;
+	}
+
 	/* Note that tail is only used here, not in process().  The head must be
 	   checked first here, since if it is null the tail pointer is junk. */
 	const Event* const head = _head.load();
 	if (!head) {
-		_head = ev;
-		_tail = ev;
+		_tail = last;
+		_head = first;
 	} else {
-		_tail.load()->next(ev);
-		_tail = ev;
+		_tail.load()->next(first);
+		_tail = last;
 	}
 
-	_sem.post();
+	_n_incoming -= count;
 }
 
 unsigned
@@ -166,6 +203,41 @@ PreProcessor::process(RunContext& ctx, PostProcessor& dest, size_t limit)
 	return n_processed;
 }
 
+void
+PreProcessor::prefetch(const PreProcessContext& ctx,
+                       BlockLoader&             loader,
+                       Event&                   ev)
+{
+	static constexpr size_t max_prefetch = 256;
+
+	if (!ctx.in_bundle()) {
+		loader.wait();
+		_prefetched   = nullptr;
+		_n_prefetched = 0;
+		return;
+	}
+
+	if (!_n_prefetched) {
+		if (!ev.prefetch(loader)) {
+			loader.wait();
+			return;
+		}
+
+		_prefetched   = &ev;
+		_n_prefetched = 1;
+	}
+
+	// Extend the window of prefetched events as far as possible
+	for (Event* e = _prefetched->next();
+	     e && _n_prefetched < max_prefetch && e->prefetch(loader);
+	     e = e->next()) {
+		_prefetched = e;
+		++_n_prefetched;
+	}
+
+	--_n_prefetched; // For ev, which is about to be pre-processed
+}
+
 void
 PreProcessor::run()
 {
@@ -180,12 +252,25 @@ PreProcessor::run()
 
 	ThreadManager::set_flag(THREAD_PRE_PROCESS);
 
-	Event* back = nullptr;
+	using Clock = std::chrono::steady_clock;
+
+	Event*            back        = nullptr;
+	Clock::time_point last_check = Clock::now();
 	while (!_exit_flag) {
-		if (!_sem.timed_wait(std::chrono::seconds(1))) {
+		const bool have_event = _sem.timed_wait(std::chrono::seconds(1));
+
+		// Periodically rebalance graphs whose block costs have changed
+		const Clock::time_point now = Clock::now();
+		if (now - last_check >= std::chrono::seconds(1)) {
+			last_check = now;
+			check_costs(ctx);
+		}
+
+		if (!have_event) {
 			continue;
 		}
 
+		append_incoming();
 		if (!back) {
 			// Ran off end, find new unprepared back
 			back = _head;
@@ -217,6 +302,11 @@ PreProcessor::run()
 			_block_state = BlockState::PRE_UNBLOCKED;
 		}
 
+		// Create blocks for upcoming events in the background while loading
+		if (const auto& loader = _engine.block_loader()) {
+			prefetch(ctx, *loader, *ev);
+		}
+
 		// Prepare event, allowing it to be processed
 		assert(!ev->is_prepared());
 		if (ev->pre_process(ctx)) {
@@ -247,4 +337,31 @@ PreProcessor::run()
 	}
 }
 
+void
+PreProcessor::check_costs(const PreProcessContext& ctx)
+{
+	if (_engine.n_threads() < 2 || ctx.in_bundle() || !_engine.root_graph()) {
+		return; // Balancing is irrelevant, or compilation is deferred
+	}
+
+	check_costs(*_engine.root_graph());
+}
+
+void
+PreProcessor::check_costs(GraphImpl& graph)
+{
+	for (auto& b : graph.blocks()) {
+		if (b.graph_type() == Node::GraphType::GRAPH) {
+			check_costs(static_cast<GraphImpl&>(b));
+		}
+	}
+
+	if (graph.enabled() && !graph.recompile_pending() &&
+	    (graph.schedule_is_incremental() ||
+	     CompiledGraph::costs_drifted(graph))) {
+		graph.set_recompile_pending(true);
+		event(new events::Recompile(_engine, graph.path()), Event::Mode::NORMAL);
+	}
+}
+
 } // namespace ingen::server
@@ -24,13 +24,15 @@
 #include <atomic>
 #include <chrono>
 #include <cstddef>
-#include <mutex>
 #include <thread>
 
 namespace ingen::server {
 
+class BlockLoader;
 class Engine;
+class GraphImpl;
 class PostProcessor;
+class PreProcessContext;
 class RunContext;
 
 class PreProcessor
@@ -41,10 +43,10 @@ public:
 	~PreProcessor();
 
 	/** Return true iff no events are enqueued. */
-	bool empty() const { return !_head.load(); }
+	bool empty() const { return !_head.load() && !_n_incoming.load(); }
 
 	/** Enqueue an event.
-	 * This is safe to call from any non-realtime thread (it locks).
+	 * This is lock-free and safe to call from any non-realtime thread.
 	 */
 	void event(Event* ev, Event::Mode mode);
 
@@ -58,6 +60,27 @@ public:
 protected:
 	void run();
 
+	/** Move submitted events to the end of the queue in submission order. */
+	void append_incoming();
+
+	/** Start creating blocks for `ev` and upcoming events in the background.
+	 *
+	 * Events in a bundle are prefetched in order until one that can not be,
+	 * which then waits for all background work to finish before it is
+	 * pre-processed.
+	 */
+	void prefetch(const PreProcessContext& ctx, BlockLoader& loader, Event& ev);
+
+	/** Enqueue full recompilation of graphs that may be poorly scheduled.
+	 *
+	 * This is the case when the load has shifted since the graph was
+	 * compiled, or when it was compiled incrementally.
+	 */
+	void check_costs(const PreProcessContext& ctx);
+
+	/** Recursively check `graph` and its subgraphs for cost drift. */
+	void check_costs(GraphImpl& graph);
+
 private:
 	enum class BlockState {
 		UNBLOCKED,     ///< Normal, unblocked execution
@@ -73,12 +96,20 @@ private:
 		}
 	}
 
+	/* Events are submitted by pushing onto the _incoming stack with CAS, so
+	   any number of threads can enqueue without locking.  Only the
+	   pre-process thread takes the whole stack and appends it to the queue
+	   from _head to _tail, which process() consumes. */
+
 	Engine&                 _engine;
-	std::mutex              _mutex;
 	raul::Semaphore         _sem{0};
+	std::atomic<Event*>     _incoming{nullptr}; ///< Most recently submitted
+	std::atomic<size_t>     _n_incoming{0};     ///< Submitted, not appended
 	std::atomic<Event*>     _head{nullptr};
 	std::atomic<Event*>     _tail{nullptr};
 	std::atomic<BlockState> _block_state{BlockState::UNBLOCKED};
+	Event*                  _prefetched{nullptr}; ///< Last prefetched event
+	size_t                  _n_prefetched{0};     ///< Prefetched, not prepared
 	bool                    _exit_flag{false};
 	std::thread             _thread;
 };
@@ -0,0 +1,165 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_PROFILE_HPP
+#define INGEN_ENGINE_PROFILE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#	include <x86intrin.h>
+#endif
+
+namespace ingen::server {
+
+/** Return a cheap monotonic timestamp for profiling.
+ *
+ * This is the CPU timestamp counter where available, which is much cheaper to
+ * read than the system clock, and otherwise a steady clock in nanoseconds.
+ * Only differences between two timestamps are meaningful.
+ */
+inline uint64_t
+profile_ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch())
+			.count());
+#endif
+}
+
+/** Return the number of profile ticks per microsecond.
+ *
+ * This is measured against the system clock the first time it is called,
+ * which takes a few milliseconds, so it should be called early in a
+ * non-realtime thread.
+ */
+inline double
+profile_ticks_per_us()
+{
+	static const double ticks_per_us = [] {
+		using Clock = std::chrono::steady_clock;
+
+		const Clock::time_point t0 = Clock::now();
+		const uint64_t          c0 = profile_ticks();
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		const uint64_t          c1 = profile_ticks();
+		const Clock::time_point t1 = Clock::now();
+
+		const auto us = std::chrono::duration<double, std::micro>(t1 - t0);
+		return static_cast<double>(c1 - c0) / us.count();
+	}();
+
+	return ticks_per_us;
+}
+
+/** Lock-free run time statistics for something executed in the audio thread.
+ *
+ * Times are accumulated by the audio thread with record() and periodically
+ * collected and reset by a non-realtime thread with drain().  The summary of
+ * the last drained period is kept so that it can be read from any thread.
+ *
+ * \ingroup engine
+ */
+class Profile
+{
+public:
+	/** Totals accumulated since the last drain. */
+	struct Totals {
+		uint64_t ticks;     ///< Total run time
+		uint64_t max_ticks; ///< Longest single run
+		uint64_t n_runs;    ///< Number of runs
+	};
+
+	/** Summary of a drained period. */
+	struct Summary {
+		float mean_time; ///< Mean time per run in microseconds
+		float max_time;  ///< Longest single run in microseconds
+		float load;      ///< Total run time as a fraction of the period
+		float max_load;  ///< Longest single run as a fraction of a cycle
+	};
+
+	/** Record a single run (realtime).
+	 *
+	 * Something is only run by one thread at a time, so the maximum can be
+	 * updated without a compare and swap loop.
+	 */
+	void record(uint64_t ticks) {
+		_ticks.fetch_add(ticks, std::memory_order_relaxed);
+		_n_runs.fetch_add(1, std::memory_order_relaxed);
+		if (ticks > _max_ticks.load(std::memory_order_relaxed)) {
+			_max_ticks.store(ticks, std::memory_order_relaxed);
+		}
+	}
+
+	/** Take and reset the accumulated totals (non-realtime). */
+	Totals drain() {
+		return {_ticks.exchange(0, std::memory_order_relaxed),
+		        _max_ticks.exchange(0, std::memory_order_relaxed),
+		        _n_runs.exchange(0, std::memory_order_relaxed)};
+	}
+
+	/** Drain totals and summarise them over a period of `period_us`.
+	 *
+	 * @param ticks_per_us Profile clock rate from profile_ticks_per_us().
+	 * @param period_us Time since the last update in microseconds.
+	 * @param cycle_us Duration of a single process cycle in microseconds.
+	 * @return True iff anything was run during the period.
+	 */
+	bool update(double ticks_per_us, double period_us, double cycle_us) {
+		const Totals totals = drain();
+		const auto   n_runs = static_cast<double>(totals.n_runs);
+		const double total  = static_cast<double>(totals.ticks) / ticks_per_us;
+		const double max    = static_cast<double>(totals.max_ticks) / ticks_per_us;
+
+		_mean_time.store(n_runs > 0 ? static_cast<float>(total / n_runs) : 0.0f,
+		                 std::memory_order_relaxed);
+		_max_time.store(static_cast<float>(max), std::memory_order_relaxed);
+		_load.store(static_cast<float>(total / period_us),
+		            std::memory_order_relaxed);
+		_max_load.store(static_cast<float>(max / cycle_us),
+		                std::memory_order_relaxed);
+
+		return totals.n_runs > 0;
+	}
+
+	/** Return the summary of the last drained period (any thread). */
+	Summary summary() const {
+		return {_mean_time.load(std::memory_order_relaxed),
+		        _max_time.load(std::memory_order_relaxed),
+		        _load.load(std::memory_order_relaxed),
+		        _max_load.load(std::memory_order_relaxed)};
+	}
+
+private:
+	std::atomic<uint64_t> _ticks{0};
+	std::atomic<uint64_t> _max_ticks{0};
+	std::atomic<uint64_t> _n_runs{0};
+	std::atomic<float>    _mean_time{0.0f};
+	std::atomic<float>    _max_time{0.0f};
+	std::atomic<float>    _load{0.0f};
+	std::atomic<float>    _max_load{0.0f};
+};
+
+} // namespace ingen::server
+
+#endif // INGEN_ENGINE_PROFILE_HPP
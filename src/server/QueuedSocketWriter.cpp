@@ -0,0 +1,166 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "QueuedSocketWriter.hpp"
+
+#include <ingen/Log.hpp>
+#include <ingen/SocketWriter.hpp>
+#include <ingen/URI.hpp>
+#include <ingen/URIMap.hpp>
+#include <raul/Socket.hpp>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace ingen::server {
+
+QueuedSocketWriter::QueuedSocketWriter(URIMap&                              map,
+                                       URIs&                                uris,
+                                       Log&                                 log,
+                                       const std::shared_ptr<raul::Socket>& sock,
+                                       size_t max_queued)
+	: SocketWriter(map, uris, URI(sock->uri()), sock)
+	, _log(log)
+	, _max_queued(max_queued)
+{}
+
+bool
+QueuedSocketWriter::flush()
+{
+	const std::lock_guard<std::mutex> lock{_mutex};
+	if (_failed) {
+		return false;
+	}
+
+	const ssize_t sent =
+		try_send(_queue.data() + _head, _queue.size() - _head);
+	if (sent < 0) {
+		return fail();
+	}
+
+	_head += static_cast<size_t>(sent);
+	if (_head == _queue.size()) {
+		_queue.clear();
+		_head = 0;
+	} else if (_head > _queue.size() / 2) {
+		_queue.erase(_queue.begin(),
+		             _queue.begin() + static_cast<ptrdiff_t>(_head));
+		_head = 0;
+	}
+
+	return true;
+}
+
+void
+QueuedSocketWriter::disconnect()
+{
+	const std::lock_guard<std::mutex> lock{_mutex};
+	if (!_failed) {
+		overflow();
+	}
+}
+
+size_t
+QueuedSocketWriter::n_queued()
+{
+	const std::lock_guard<std::mutex> lock{_mutex};
+	return _queue.size() - _head;
+}
+
+bool
+QueuedSocketWriter::failed()
+{
+	const std::lock_guard<std::mutex> lock{_mutex};
+	return _failed;
+}
+
+bool
+QueuedSocketWriter::send_all(const void* buf, size_t len)
+{
+	const std::lock_guard<std::mutex> lock{_mutex};
+	if (_failed) {
+		return false;
+	}
+
+	const auto* ptr = static_cast<const uint8_t*>(buf);
+	if (_head == _queue.size()) {
+		// Nothing is waiting, so try to send immediately
+		const ssize_t sent = try_send(ptr, len);
+		if (sent < 0) {
+			return fail();
+		}
+
+		ptr += sent;
+		len -= static_cast<size_t>(sent);
+	}
+
+	if (len > 0) {
+		if (_queue.size() - _head + len > _max_queued) {
+			return overflow();
+		}
+
+		_queue.insert(_queue.end(), ptr, ptr + len);
+	}
+
+	return true;
+}
+
+ssize_t
+QueuedSocketWriter::try_send(const uint8_t* buf, size_t len)
+{
+	size_t sent = 0;
+	while (sent < len) {
+		const ssize_t ret = send(_socket->fd(),
+		                         buf + sent,
+		                         len - sent,
+		                         MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (ret >= 0) {
+			sent += static_cast<size_t>(ret);
+		} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			break; // Socket is full, wait until it is writable
+		} else if (errno != EINTR) {
+			return -1;
+		}
+	}
+
+	return static_cast<ssize_t>(sent);
+}
+
+bool
+QueuedSocketWriter::overflow()
+{
+	_log.warn("Disconnecting %1% which is not reading\n", _uri);
+	return fail();
+}
+
+bool
+QueuedSocketWriter::fail()
+{
+	_failed = true;
+	_queue.clear();
+	_head = 0;
+	_socket->shutdown();
+	return false;
+}
+
+} // namespace ingen::server
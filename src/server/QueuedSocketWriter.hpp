@@ -0,0 +1,99 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef INGEN_ENGINE_QUEUEDSOCKETWRITER_HPP
+#define INGEN_ENGINE_QUEUEDSOCKETWRITER_HPP
+
+#include <ingen/SocketWriter.hpp>
+#include <ingen/URI.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sys/types.h>
+#include <vector>
+
+namespace raul {
+class Socket;
+} // namespace raul
+
+namespace ingen {
+
+class Log;
+class URIMap;
+class URIs;
+
+namespace server {
+
+/** A SocketWriter that queues whatever the socket does not accept at once.
+ *
+ * Output is sent without blocking, and the rest is queued until flush() is
+ * called when the socket is writable again.  A client that lets more than
+ * `max_queued` bytes pile up is not reading, so it is disconnected.
+ *
+ * \ingroup engine
+ */
+class QueuedSocketWriter : public SocketWriter
+{
+public:
+	QueuedSocketWriter(URIMap&                              map,
+	                   URIs&                                uris,
+	                   Log&                                 log,
+	                   const std::shared_ptr<raul::Socket>& sock,
+	                   size_t                               max_queued);
+
+	/** Send as much queued output as the socket accepts.
+	 *
+	 * @return False if the connection has failed.
+	 */
+	bool flush();
+
+	/** Drop output and hang up, because the client fell too far behind. */
+	void disconnect();
+
+	/** Return the number of bytes waiting for the socket. */
+	size_t n_queued();
+
+	/** Return true iff the connection has failed or been disconnected. */
+	bool failed();
+
+protected:
+	bool send_all(const void* buf, size_t len) override;
+
+private:
+	/// Send without blocking, returning the number of bytes sent or -1
+	ssize_t try_send(const uint8_t* buf, size_t len);
+
+	/// Hang up on a client which is not reading
+	bool overflow();
+
+	/// Drop output and hang up, so the loop removes the connection
+	bool fail();
+
+	Log&                 _log;
+	const size_t         _max_queued; ///< Output limit
+	std::mutex           _mutex;
+	std::vector<uint8_t> _queue;      ///< Output waiting for the socket
+	size_t               _head{0};    ///< Offset of first unsent byte
+	bool                 _failed{false};
+};
+
+} // namespace server
+} // namespace ingen
+
+#endif // INGEN_ENGINE_QUEUEDSOCKETWRITER_HPP
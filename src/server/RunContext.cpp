@@ -16,29 +16,34 @@
 
 #include "RunContext.hpp"
 
+#include "Backoff.hpp"
 #include "Broadcaster.hpp"
 #include "BufferFactory.hpp"
 #include "Engine.hpp"
 #include "PortImpl.hpp"
+#include "PortValueHandoff.hpp"
 #include "Task.hpp"
+#include "TaskDeque.hpp"
 
 #include <ingen/Atom.hpp>
-#include <ingen/Forge.hpp>
 #include <ingen/Log.hpp>
 #include <ingen/URI.hpp>
-#include <ingen/URIMap.hpp>
 #include <ingen/URIs.hpp>
-#include <ingen/World.hpp>
 #include <lv2/urid/urid.h>
 #include <raul/RingBuffer.hpp>
 
 #include <cerrno>
+#include <cstdint>
 #include <cstring>
+#include <memory>
 #include <pthread.h>
 #include <sched.h>
 
 namespace ingen::server {
 
+/// Number of sequence sources a port can merge without scanning
+static constexpr uint32_t max_merged_srcs = 256U;
+
 struct Notification {
 	explicit Notification(PortImpl* p = nullptr,
 	                      FrameTime f = 0,
@@ -57,18 +62,24 @@ struct Notification {
 
 RunContext::RunContext(Engine&           engine,
                        raul::RingBuffer* event_sink,
+                       TaskDeque*        tasks,
                        unsigned          id,
                        bool              threaded)
 	: _engine(engine)
 	, _event_sink(event_sink)
-	, _thread(threaded ? new std::thread(&RunContext::run, this) : nullptr)
+	, _tasks(tasks)
 	, _id(id)
+	, _threaded(threaded)
+	, _sequence_merger(std::make_shared<SequenceMerger>(max_merged_srcs))
 {}
 
 RunContext::RunContext(const RunContext& copy)
 	: _engine(copy._engine)
 	, _event_sink(copy._event_sink)
+	, _tasks(copy._tasks)
 	, _id(copy._id)
+	, _threaded(false)
+	, _sequence_merger(copy._sequence_merger)
 	, _start(copy._start)
 	, _end(copy._end)
 	, _offset(copy._offset)
@@ -105,6 +116,46 @@ RunContext::notify(LV2_URID    key,
 	return false;
 }
 
+/** Return true iff only the latest value of a notification matters.
+ *
+ * This is the case for port values and activity, except for the events of
+ * explicitly monitored sequences, which plugin UIs need all of.
+ */
+static bool
+is_monitor_update(const URIs& uris, const Notification& note)
+{
+	if (note.key == uris.ingen_value) {
+		return true;
+	}
+
+	return note.key == uris.ingen_activity &&
+	       !(note.port->is_monitored() &&
+	         note.port->buffer_type() == uris.atom_Sequence);
+}
+
+/** Return the URI of a notification key, or null if it is unknown.
+ *
+ * Notification keys come from a small fixed set, so they are resolved without
+ * unmapping and allocating a new URI for every notification.
+ */
+static const URI*
+notification_key(const URIs& uris, LV2_URID key)
+{
+	if (key == uris.ingen_value) {
+		return &uris.ingen_value;
+	}
+
+	if (key == uris.ingen_activity) {
+		return &uris.ingen_activity;
+	}
+
+	if (key == uris.midi_binding) {
+		return &uris.midi_binding;
+	}
+
+	return nullptr;
+}
+
 void
 RunContext::emit_notifications(FrameTime end)
 {
@@ -117,21 +168,39 @@ RunContext::emit_notifications(FrameTime end)
 			return;
 		}
 		if (_event_sink->read(sizeof(note), &note) == sizeof(note)) {
-			Atom value = Forge::alloc(note.size, note.type, nullptr);
-			if (_event_sink->read(note.size, value.get_body()) == note.size) {
+			if (_note_body.size() < note.size) {
+				_note_body.resize(note.size);
+			}
+
+			void* const body = _note_body.data();
+			if (_event_sink->read(note.size, body) == note.size) {
 				i += note.size;
-				const char* key = _engine.world().uri_map().unmap_uri(note.key);
-				if (key) {
-					_engine.broadcaster()->set_property(
-						note.port->uri(), URI(key), value);
-					if (note.port->is_input() &&
-					    (note.key == uris.ingen_value ||
-					     note.key == uris.midi_binding)) {
-						// FIXME: not thread safe
-						note.port->set_property(URI(key), value);
-					}
+				const URI* const key = notification_key(uris, note.key);
+				if (!key) {
+					_engine.log().rt_error("Unknown notification key\n");
+					continue;
+				}
+
+				if (is_monitor_update(uris, note)) {
+					_engine.broadcaster()->monitor(
+						note.port->uri(), *key, note.size, note.type, body);
 				} else {
-					_engine.log().rt_error("Error unmapping notification key URI\n");
+					_engine.broadcaster()->set_property(
+						note.port->uri(),
+						*key,
+						Atom(note.size, note.type, body));
+				}
+
+				if (note.port->is_input() &&
+				    (note.key == uris.ingen_value ||
+				     note.key == uris.midi_binding)) {
+					// Applied to the port by the engine when the store is free
+					_engine.port_values()->set(*note.port,
+					                           note.time,
+					                           *key,
+					                           note.size,
+					                           note.type,
+					                           body);
 				}
 			} else {
 				_engine.log().rt_error("Error reading body from notification ring\n");
@@ -142,12 +211,16 @@ RunContext::emit_notifications(FrameTime end)
 	}
 }
 
-void
-RunContext::claim_task(Task* task)
+bool
+RunContext::push_task(Task* task)
 {
-	if ((_task = task)) {
-		_engine.signal_tasks_available();
-	}
+	return _tasks->push(task);
+}
+
+Task*
+RunContext::pop_task()
+{
+	return _tasks->pop();
 }
 
 Task*
@@ -156,6 +229,12 @@ RunContext::steal_task() const
 	return _engine.steal_task(_id + 1);
 }
 
+void
+RunContext::signal_tasks_available()
+{
+	_engine.signal_tasks_available();
+}
+
 void
 RunContext::set_priority(int priority)
 {
@@ -172,6 +251,14 @@ RunContext::set_priority(int priority)
 	}
 }
 
+void
+RunContext::start_thread()
+{
+	if (_threaded && !_thread) {
+		_thread = std::make_unique<std::thread>(&RunContext::run, this);
+	}
+}
+
 void
 RunContext::join()
 {
@@ -186,11 +273,13 @@ RunContext::join()
 void
 RunContext::run()
 {
-	while (_engine.wait_for_tasks()) {
+	Backoff backoff = _engine.make_backoff();
+	do {
 		for (Task* t = nullptr; (t = _engine.steal_task(0));) {
 			t->run(*this);
+			backoff.reset();
 		}
-	}
+	} while (_engine.wait_for_tasks(_id, backoff));
 }
 
 } // namespace ingen::server
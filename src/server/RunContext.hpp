@@ -17,6 +17,8 @@
 #ifndef INGEN_ENGINE_RUNCONTEXT_HPP
 #define INGEN_ENGINE_RUNCONTEXT_HPP
 
+#include "OffsetSet.hpp"
+#include "SequenceMerger.hpp"
 #include "types.hpp"
 
 #include <lv2/urid/urid.h>
@@ -25,12 +27,14 @@
 #include <cstdint>
 #include <memory>
 #include <thread>
+#include <vector>
 
 namespace ingen::server {
 
 class Engine;
 class PortImpl;
 class Task;
+class TaskDeque;
 
 /** Graph execution context.
  *
@@ -51,12 +55,14 @@ public:
 	 *
 	 * @param engine The engine this context is running within.
 	 * @param event_sink Sink for notification events (peaks etc)
+	 * @param tasks Queue of ready tasks owned by this context.
 	 * @param id The ID of this context.
 	 * @param threaded If true, then this context is a worker which will launch
-	 * a thread and execute tasks as they become available.
+	 * a thread and execute tasks as they become available, see start_thread().
 	 */
 	RunContext(Engine&           engine,
 	           raul::RingBuffer* event_sink,
+	           TaskDeque*        tasks,
 	           unsigned          id,
 	           bool              threaded);
 
@@ -117,19 +123,49 @@ public:
 		_nframes = nframes;
 	}
 
-	/** Claim a parallel task, and signal others that work is available. */
-	void claim_task(Task* task);
+	/** Push a ready task to this context's queue.
+	 * @return false on failure (queue is full)
+	 */
+	bool push_task(Task* task);
+
+	/** Pop the most recently pushed task from this context's queue. */
+	Task* pop_task();
 
 	/** Steal a task from some other context if possible. */
 	Task* steal_task() const;
 
+	/** Signal other contexts that tasks are available to steal. */
+	void signal_tasks_available();
+
 	void set_priority(int priority);
 	void set_rate(SampleCount rate) { _rate = rate; }
 
-    void join();
+	/** Return space for the value change offsets of a block in this cycle.
+	 *
+	 * This is empty in sub-contexts, and may be smaller than the current
+	 * cycle if the block length has grown, so check its capacity first.
+	 */
+	OffsetSet& value_offsets() { return _value_offsets; }
+
+	/** Return a merger for the sequence sources of a port.
+	 *
+	 * This is shared with sub-contexts, since it is only used while mixing a
+	 * single port, and may hold fewer sources than a port has, so check its
+	 * capacity first.
+	 */
+	SequenceMerger& sequence_merger() const { return *_sequence_merger; }
+
+	/** Launch the thread of a worker context.
+	 *
+	 * The thread immediately looks for tasks in every context, so this must
+	 * only be called once all contexts of the engine have been created.
+	 */
+	void start_thread();
+
+	void join();
 
 	Engine&     engine()   const { return _engine; }
-	Task*       task()     const { return _task; }
+	TaskDeque*  tasks()    const { return _tasks; }
 	unsigned    id()       const { return _id; }
 	FrameTime   start()    const { return _start; }
 	FrameTime   time()     const { return _start + _offset; }
@@ -143,10 +179,13 @@ protected:
 	void run();
 
 	Engine&                      _engine;        ///< Engine we're running in
-	raul::RingBuffer*            _event_sink;    ///< Updates from notify()
-	Task*                        _task{nullptr}; ///< Currently executing task
-	std::unique_ptr<std::thread> _thread;        ///< Thread (or null for main)
-	unsigned                     _id;            ///< Context ID
+	raul::RingBuffer*            _event_sink; ///< Updates from notify()
+	TaskDeque*                   _tasks;      ///< Ready tasks to run or steal
+	unsigned                     _id;         ///< Context ID
+	bool                         _threaded;   ///< True iff a worker
+	std::vector<uint8_t>         _note_body;  ///< Reused notification body
+	OffsetSet                    _value_offsets; ///< Reused by blocks
+	std::shared_ptr<SequenceMerger> _sequence_merger; ///< Reused by ports
 
 	FrameTime   _start{0};       ///< Start frame of this cycle (timeline)
 	FrameTime   _end{0};         ///< End frame of this cycle (timeline)
@@ -154,6 +193,8 @@ protected:
 	SampleCount _nframes{0};     ///< Number of frames past offset to process
 	SampleCount _rate{0};        ///< Sample rate in Hz
 	bool        _realtime{true}; ///< True iff context is hard realtime
+
+	std::unique_ptr<std::thread> _thread; ///< Thread (or null for main)
 };
 
 } // namespace ingen::server
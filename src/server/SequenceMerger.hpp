@@ -0,0 +1,181 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_SEQUENCEMERGER_HPP
+#define INGEN_ENGINE_SEQUENCEMERGER_HPP
+
+#include <lv2/atom/atom.h>
+#include <lv2/atom/util.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace ingen::server {
+
+/** Merges several atom sequences into a single stream of events in time order.
+ *
+ * This is a binary min-heap with one entry per non-empty source, so each
+ * event is found in O(log n) rather than by scanning every source.  Once only
+ * a few sources remain, they are simply scanned, which is faster in practice.  Events
+ * with equal times are returned in the order their sources were added.
+ *
+ * Storage is allocated up front, so a merger can be cleared and reused in the
+ * audio thread without allocation.  Each RunContext owns one, so it need not
+ * live on the stack.  At most capacity() sources can be added, so mix()
+ * merges more sources in batches.
+ *
+ * \ingroup engine
+ */
+class SequenceMerger
+{
+public:
+	/** Allocate space for `capacity` sources (not realtime safe). */
+	explicit SequenceMerger(uint32_t capacity) : _heap(capacity) {}
+
+	SequenceMerger(const SequenceMerger&) = delete;
+	SequenceMerger& operator=(const SequenceMerger&) = delete;
+	SequenceMerger(SequenceMerger&&) = delete;
+	SequenceMerger& operator=(SequenceMerger&&) = delete;
+
+	~SequenceMerger() = default;
+
+	/** Return the maximum number of non-empty sources. */
+	uint32_t capacity() const { return static_cast<uint32_t>(_heap.size()); }
+
+	/** Remove all sources to start a new merge. */
+	void clear() {
+		_size    = 0U;
+		_n_added = 0U;
+	}
+
+	/** Add a source sequence.
+	 * @return false if the merger is full and the source was not added.
+	 */
+	bool add(const LV2_Atom_Sequence* seq) {
+		const LV2_Atom_Event* const ev = lv2_atom_sequence_begin(&seq->body);
+		if (is_end(seq, ev)) {
+			++_n_added;
+			return true; // Empty, nothing to merge
+		}
+
+		if (_size == capacity()) {
+			return false;
+		}
+
+		_heap[_size] = {ev->time.frames, ev, seq, _n_added++};
+		sift_up(_size++);
+		return true;
+	}
+
+	/** Return the next event in time order, or null if all are exhausted. */
+	const LV2_Atom_Event* next() {
+		if (_size == 0) {
+			return nullptr;
+		}
+
+		// Few sources are faster to scan than to keep ordered
+		const bool     scan = _size <= max_scan_size;
+		const uint32_t i    = scan ? min_index() : 0U;
+
+		Entry&                      top = _heap[i];
+		const LV2_Atom_Event* const ev  = top.ev;
+
+		top.ev = lv2_atom_sequence_next(ev);
+		if (is_end(top.seq, top.ev)) {
+			top = _heap[--_size]; // Source exhausted, replace with last
+		} else {
+			top.time = top.ev->time.frames;
+		}
+
+		if (!scan) {
+			sift_down(0);
+		}
+
+		return ev;
+	}
+
+	bool     empty() const { return _size == 0; }
+	uint32_t size()  const { return _size; }
+
+private:
+	struct Entry {
+		int64_t                  time;  ///< Time of next event, for locality
+		const LV2_Atom_Event*    ev;    ///< Next event from this source
+		const LV2_Atom_Sequence* seq;   ///< Source sequence
+		uint32_t                 order; ///< Order added, to break ties
+	};
+
+	/// Maximum number of sources to scan linearly rather than as a heap
+	static constexpr uint32_t max_scan_size = 8U;
+
+	static bool is_end(const LV2_Atom_Sequence* seq, const LV2_Atom_Event* ev) {
+		return lv2_atom_sequence_is_end(&seq->body, seq->atom.size, ev);
+	}
+
+	static bool before(const Entry& a, const Entry& b) {
+		return a.time < b.time || (a.time == b.time && a.order < b.order);
+	}
+
+	uint32_t min_index() const {
+		uint32_t min = 0U;
+		for (uint32_t i = 1U; i < _size; ++i) {
+			if (before(_heap[i], _heap[min])) {
+				min = i;
+			}
+		}
+		return min;
+	}
+
+	void sift_up(uint32_t i) {
+		const Entry e = _heap[i];
+		while (i > 0) {
+			const uint32_t parent = (i - 1) / 2;
+			if (!before(e, _heap[parent])) {
+				break;
+			}
+			_heap[i] = _heap[parent];
+			i        = parent;
+		}
+		_heap[i] = e;
+	}
+
+	void sift_down(uint32_t i) {
+		const Entry e = _heap[i];
+		while (true) {
+			uint32_t child = (2 * i) + 1;
+			if (child >= _size) {
+				break;
+			}
+			if (child + 1 < _size && before(_heap[child + 1], _heap[child])) {
+				++child;
+			}
+			if (!before(_heap[child], e)) {
+				break;
+			}
+			_heap[i] = _heap[child];
+			i        = child;
+		}
+		_heap[i] = e;
+	}
+
+	std::vector<Entry> _heap; ///< Only the first _size entries are valid
+	uint32_t           _size{0};
+	uint32_t           _n_added{0};
+};
+
+} // namespace ingen::server
+
+#endif // INGEN_ENGINE_SEQUENCEMERGER_HPP
@@ -18,6 +18,11 @@
 
 #include "Engine.hpp"
 #include "SocketServer.hpp"
+#include "ingen_config.h"
+
+#if USE_EPOLL
+#include "SocketLoop.hpp"
+#endif
 
 #include <ingen/Atom.hpp>
 #include <ingen/Configuration.hpp>
@@ -67,25 +72,67 @@ get_link_target(const char* link_path)
 }
 
 static void ingen_listen(Engine*       engine,
+                         SocketLoop*   loop,
                          raul::Socket* unix_sock,
                          raul::Socket* net_sock);
 
+static std::shared_ptr<SocketLoop>
+make_loop(Engine& engine)
+{
+#if USE_EPOLL
+	const int32_t n_threads =
+		engine.world().conf().option("socket-threads").get<int32_t>();
+	if (n_threads > 0) {
+		auto loop = std::make_shared<SocketLoop>(
+			engine, static_cast<unsigned>(n_threads));
+		if (loop->is_running()) {
+			return loop;
+		}
+	}
+#else
+	(void)engine;
+#endif
+
+	return nullptr;
+}
 
 SocketListener::SocketListener(Engine& engine)
 	: unix_sock(raul::Socket::Type::UNIX)
 	, net_sock(raul::Socket::Type::TCP)
-	, thread(new std::thread(ingen_listen, &engine, &unix_sock, &net_sock))
+	, loop(make_loop(engine))
+	, thread(new std::thread(
+		  ingen_listen, &engine, loop.get(), &unix_sock, &net_sock))
 {}
 
 SocketListener::~SocketListener() {
 	unix_sock.shutdown();
 	net_sock.shutdown();
 	thread->join();
+	loop.reset();
 	unlink(unix_sock.uri().substr(strlen(unix_scheme)).c_str());
 }
 
+/** Serve a new connection on the loop if there is one, or a new thread. */
+static void
+serve(Engine& engine, SocketLoop* loop, const std::shared_ptr<raul::Socket>& conn)
+{
+#if USE_EPOLL
+	if (loop) {
+		loop->add(conn);
+		return;
+	}
+#else
+	(void)loop;
+#endif
+
+	new SocketServer(engine.world(), engine, conn);
+}
+
 static void
-ingen_listen(Engine* engine, raul::Socket* unix_sock, raul::Socket* net_sock)
+ingen_listen(Engine*       engine,
+             SocketLoop*   loop,
+             raul::Socket* unix_sock,
+             raul::Socket* net_sock)
 {
 	ingen::World& world = engine->world();
 
@@ -179,14 +226,14 @@ ingen_listen(Engine* engine, raul::Socket* unix_sock, raul::Socket* net_sock)
 		if (pfds[0].revents & POLLIN) {
 			auto conn = unix_sock->accept();
 			if (conn) {
-				new SocketServer(world, *engine, conn);
+				serve(*engine, loop, conn);
 			}
 		}
 
 		if (pfds[1].revents & POLLIN) {
 			auto conn = net_sock->accept();
 			if (conn) {
-				new SocketServer(world, *engine, conn);
+				serve(*engine, loop, conn);
 			}
 		}
 	}
@@ -22,8 +22,14 @@
 namespace ingen::server {
 
 class Engine;
-
-/** Listens on main sockets and spawns socket servers for new connections. */
+class SocketLoop;
+
+/** Listens on main sockets and serves new connections.
+ *
+ * Connections are served by a SocketLoop if the "socket-threads" option is
+ * non-zero and epoll is available, otherwise each gets a SocketServer with
+ * its own reader thread.
+ */
 class SocketListener
 {
 public:
@@ -33,6 +39,7 @@ public:
 private:
 	raul::Socket                 unix_sock;
 	raul::Socket                 net_sock;
+	std::shared_ptr<SocketLoop>  loop;
 	std::unique_ptr<std::thread> thread;
 };
 
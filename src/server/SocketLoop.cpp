@@ -0,0 +1,598 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SocketLoop.hpp"
+
+#include "ClientQueue.hpp"
+#include "Engine.hpp"
+#include "QueuedSocketWriter.hpp"
+#include "SocketServer.hpp"
+#include "TurtleSplitter.hpp"
+
+#include <ingen/AtomForge.hpp>
+#include <ingen/AtomReader.hpp>
+#include <ingen/Interface.hpp>
+#include <ingen/Log.hpp>
+#include <ingen/URI.hpp>
+#include <ingen/URIMap.hpp>
+#include <ingen/WireFormat.hpp>
+#include <ingen/World.hpp>
+#include <lv2/atom/atom.h>
+#include <lv2/urid/urid.h>
+#include <raul/Socket.hpp>
+#include <serd/serd.h>
+#include <sord/sord.h>
+#include <sord/sordmm.hpp>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ingen::server {
+
+namespace {
+
+constexpr size_t max_queued_bytes = 1U << 24U; ///< Output limit per client
+constexpr size_t max_message_size = 1U << 24U; ///< Input limit per message
+
+/** An eventfd that stays open until its last user is gone. */
+struct EventFd {
+	EventFd() : fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {}
+
+	EventFd(const EventFd&)            = delete;
+	EventFd& operator=(const EventFd&) = delete;
+	EventFd(EventFd&&)                 = delete;
+	EventFd& operator=(EventFd&&)      = delete;
+
+	~EventFd()
+	{
+		if (fd != -1) {
+			close(fd);
+		}
+	}
+
+	int fd;
+};
+
+} // namespace
+
+/** The state of a connection served by a SocketLoop. */
+class SocketLoop::Connection
+{
+public:
+	Connection(Engine& engine, const std::shared_ptr<raul::Socket>& sock)
+		: _world(engine.world())
+		, _socket(sock)
+		, _sink(SocketServer::make_sink(_world, engine))
+		, _writer(std::make_shared<QueuedSocketWriter>(_world.uri_map(),
+		                                               _world.uris(),
+		                                               _world.log(),
+		                                               sock,
+		                                               max_queued_bytes))
+		, _notify(std::make_shared<EventFd>())
+		, _queue(std::make_shared<ClientQueue>(
+			  _world.log(),
+			  _world.uris(),
+			  _writer,
+			  SocketServer::queue_size(_world),
+			  [writer = _writer] { writer->disconnect(); },
+			  [notify = _notify] { eventfd_write(notify->fd, 1); }))
+		, _forge(_world.uri_map().urid_map())
+		, _reader(_world.uri_map(), _world.uris(), _world.log(), *_sink)
+	{
+		_sink->set_respondee(_queue);
+
+		// Parse into a private world, like SocketReader
+		_env = _sord_world.prefixes().c_obj();
+		{
+			const std::lock_guard<std::mutex> lock{_world.rdf_mutex()};
+
+			serd_env_foreach(_world.rdf_world()->prefixes().c_obj(),
+			                 reinterpret_cast<SerdPrefixSink>(serd_env_set_prefix),
+			                 _env);
+		}
+
+		// Use <ingen:/> as base URI, so relative URIs are like bundle paths
+		_base_uri = sord_new_uri(_sord_world.c_obj(),
+		                         reinterpret_cast<const uint8_t*>("ingen:/"));
+		serd_env_set_base_uri(_env, sord_node_to_serd_node(_base_uri));
+
+		_parser = serd_reader_new(
+			SERD_TURTLE, this, nullptr,
+			reinterpret_cast<SerdBaseSink>(set_base_uri),
+			reinterpret_cast<SerdPrefixSink>(set_prefix),
+			reinterpret_cast<SerdStatementSink>(write_statement),
+			nullptr);
+	}
+
+	Connection(const Connection&) = delete;
+	Connection& operator=(const Connection&) = delete;
+	Connection(Connection&&) = delete;
+	Connection& operator=(Connection&&) = delete;
+
+	~Connection()
+	{
+		serd_reader_free(_parser);
+		sord_node_free(_sord_world.c_obj(), _base_uri);
+	}
+
+	int fd() const { return _socket->fd(); }
+
+	/// Return the eventfd that is signaled when messages are queued
+	int notify_fd() const { return _notify->fd; }
+
+	/// Return the client that is registered with the engine
+	const std::shared_ptr<ClientQueue>& queue() const { return _queue; }
+
+	/** Handle epoll events for the socket or the notify eventfd.
+	 *
+	 * @return False if the connection has hung up or failed.
+	 */
+	bool handle(int fd, uint32_t events)
+	{
+		const std::lock_guard<std::mutex> lock{_mutex};
+
+		if (fd == _notify->fd) {
+			// Send queued messages (reset the eventfd first to not miss any)
+			eventfd_t count = 0U;
+			eventfd_read(_notify->fd, &count);
+			_queue->drain();
+			return _writer->flush();
+		}
+
+		if ((events & EPOLLOUT) && !_writer->flush()) {
+			return false;
+		}
+
+		if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+			return receive();
+		}
+
+		return true;
+	}
+
+private:
+	/// Read all available input and dispatch any complete messages
+	bool receive()
+	{
+		// Read everything, since edge-triggered epoll reports input only once
+		bool open = true;
+		char buf[4096];
+		while (true) {
+			const ssize_t n = recv(fd(), buf, sizeof(buf), MSG_DONTWAIT);
+			if (n > 0) {
+				_input.insert(_input.end(), buf, buf + n);
+			} else if (n < 0 && errno == EINTR) {
+				continue;
+			} else {
+				open = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+				break;
+			}
+		}
+
+		if (!_negotiated && !negotiate()) {
+			return open;
+		}
+
+		const bool ok = (_format == WireFormat::ATOM) ? read_atoms()
+		                                              : read_turtle();
+
+		return open && ok;
+	}
+
+	/// Read the format request from the peer, if any, once enough has arrived
+	bool negotiate()
+	{
+		if (_input.empty()) {
+			return false;
+		}
+
+		if (_input[0] == wire_atom_magic[0]) {
+			if (_input.size() < wire_atom_magic_len) {
+				return false;
+			}
+
+			if (memcmp(_input.data(), wire_atom_magic, wire_atom_magic_len)) {
+				_world.log().error("Invalid wire format request\n");
+			} else {
+				_format = WireFormat::ATOM;
+				_writer->set_format(WireFormat::ATOM);
+			}
+
+			_input.erase(_input.begin(),
+			             _input.begin() + wire_atom_magic_len);
+		}
+
+		_negotiated = true;
+		return true;
+	}
+
+	/// Dispatch every complete atom message in the input
+	bool read_atoms()
+	{
+		size_t offset = 0;
+		bool   ok     = true;
+		while (_input.size() - offset >= sizeof(LV2_Atom)) {
+			LV2_Atom head{};
+			memcpy(&head, _input.data() + offset, sizeof(head));
+			if (head.size > max_message_size) {
+				_world.log().error("Message too large (%1% bytes)\n", head.size);
+				ok = false;
+				break;
+			}
+
+			const size_t total = sizeof(LV2_Atom) + head.size;
+			if (_input.size() - offset < total) {
+				break; // Wait for the rest of the message
+			}
+
+			// Copy message to aligned buffer
+			_atom_buf.resize(1U + (total / sizeof(uint64_t)));
+			auto* const atom = reinterpret_cast<LV2_Atom*>(_atom_buf.data());
+			memcpy(atom, _input.data() + offset, total);
+			offset += total;
+
+			read_atom(atom);
+		}
+
+		_input.erase(_input.begin(),
+		             _input.begin() + static_cast<ptrdiff_t>(offset));
+		return ok;
+	}
+
+	/// Dispatch an atom message, or record a URID definition
+	void read_atom(LV2_Atom* atom)
+	{
+		LV2_URID_Map& map = _world.uri_map().urid_map();
+
+		if (atom->type == wire_urid_definition) {
+			// Map the URI of a peer URID
+			const auto* const body = reinterpret_cast<const char*>(atom + 1);
+			if (atom->size <= sizeof(LV2_URID) || body[atom->size - 1]) {
+				_world.log().error("Invalid URID definition\n");
+				return;
+			}
+
+			LV2_URID peer_urid = 0;
+			memcpy(&peer_urid, body, sizeof(peer_urid));
+			_urids[peer_urid] = map.map(map.handle, body + sizeof(peer_urid));
+			return;
+		}
+
+		// Translate peer URIDs in message to local URIDs
+		bool       defined = true;
+		const bool valid   = for_each_urid(
+			_forge, atom, [this, &defined](LV2_URID& urid) {
+				const auto u = _urids.find(urid);
+				if (u != _urids.end()) {
+					urid = u->second;
+				} else {
+					defined = false;
+				}
+			});
+
+		if (!valid) {
+			_world.log().error("Invalid atom message\n");
+			return;
+		}
+
+		if (!defined) {
+			_world.log().error("Message with undefined URID\n");
+			return;
+		}
+
+		_reader.write(atom);
+	}
+
+	/// Dispatch every complete Turtle statement in the input
+	bool read_turtle()
+	{
+		size_t offset = 0;
+		size_t end    = 0;
+		while ((end = _splitter.next(_input.data(), _input.size()))) {
+			// Copy statement to a string, dropping end of bundle markers
+			std::string text(_input.data() + offset, end - offset);
+			std::replace(text.begin(), text.end(), '\0', ' ');
+			read_statement(text);
+			offset = end;
+		}
+
+		_input.erase(_input.begin(),
+		             _input.begin() + static_cast<ptrdiff_t>(offset));
+		_splitter.consumed(offset);
+
+		if (_input.size() > max_message_size) {
+			_world.log().error("Message too large (%1% bytes)\n",
+			                   _input.size());
+			return false;
+		}
+
+		return true;
+	}
+
+	/// Parse a Turtle statement and dispatch the message it describes
+	void read_statement(const std::string& text)
+	{
+		_model    = sord_new(_sord_world.c_obj(), SORD_SPO, false);
+		_inserter = sord_inserter_new(_model, _env);
+
+		const SerdStatus st = serd_reader_read_string(
+			_parser, reinterpret_cast<const uint8_t*>(text.c_str()));
+
+		if (st) {
+			_world.log().error("Read error: %1%\n", serd_strerror(st));
+		} else if (_msg_node) {
+			// Build an atom from the model and call _sink methods based on it
+			_forge.read(_sord_world, _model, _msg_node);
+			_reader.write(_forge.atom());
+			_forge.clear();
+		}
+
+		if (_msg_node) {
+			sord_node_free(_sord_world.c_obj(), _msg_node);
+			_msg_node = nullptr;
+		}
+
+		sord_inserter_free(_inserter);
+		sord_free(_model);
+		_inserter = nullptr;
+		_model    = nullptr;
+	}
+
+	static SerdStatus set_base_uri(Connection* self, const SerdNode* uri_node)
+	{
+		return sord_inserter_set_base_uri(self->_inserter, uri_node);
+	}
+
+	static SerdStatus set_prefix(Connection*     self,
+	                             const SerdNode* name,
+	                             const SerdNode* uri_node)
+	{
+		return sord_inserter_set_prefix(self->_inserter, name, uri_node);
+	}
+
+	static SerdStatus write_statement(Connection*        self,
+	                                  SerdStatementFlags flags,
+	                                  const SerdNode*    graph,
+	                                  const SerdNode*    subject,
+	                                  const SerdNode*    predicate,
+	                                  const SerdNode*    object,
+	                                  const SerdNode*    object_datatype,
+	                                  const SerdNode*    object_lang)
+	{
+		if (!self->_msg_node) {
+			self->_msg_node = sord_node_from_serd_node(
+				self->_sord_world.c_obj(), self->_env, subject, nullptr, nullptr);
+		}
+
+		return sord_inserter_write_statement(self->_inserter,
+		                                     flags,
+		                                     graph,
+		                                     subject,
+		                                     predicate,
+		                                     object,
+		                                     object_datatype,
+		                                     object_lang);
+	}
+
+	World&                                 _world;
+	std::shared_ptr<raul::Socket>          _socket;
+	std::shared_ptr<Interface>             _sink;
+	std::shared_ptr<QueuedSocketWriter>    _writer;
+	std::shared_ptr<EventFd>               _notify;
+	std::shared_ptr<ClientQueue>           _queue;
+	AtomForge                              _forge;
+	AtomReader                             _reader;
+	std::mutex                             _mutex;  ///< Serialises handling
+	std::vector<char>                      _input;  ///< Unprocessed input
+	bool                                   _negotiated{false};
+	WireFormat                             _format{WireFormat::TURTLE};
+	std::unordered_map<LV2_URID, LV2_URID> _urids;    ///< Peer => local
+	std::vector<uint64_t>                  _atom_buf; ///< Aligned message
+	TurtleSplitter                         _splitter;
+	Sord::World                            _sord_world;
+	SerdEnv*                               _env{nullptr};
+	SordNode*                              _base_uri{nullptr};
+	SerdReader*                            _parser{nullptr};
+	SordModel*                             _model{nullptr};
+	SordInserter*                          _inserter{nullptr};
+	SordNode*                              _msg_node{nullptr};
+};
+
+SocketLoop::SocketLoop(Engine& engine, unsigned n_threads)
+	: _engine(engine)
+	, _epoll_fd(epoll_create1(EPOLL_CLOEXEC))
+	, _wake_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+	struct epoll_event ev{};
+	ev.events  = EPOLLIN;
+	ev.data.fd = _wake_fd;
+	if (_epoll_fd == -1 || _wake_fd == -1 ||
+	    epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _wake_fd, &ev)) {
+		engine.world().log().error("Failed to create socket loop (%1%)\n",
+		                           strerror(errno));
+		if (_wake_fd != -1) {
+			close(_wake_fd);
+			_wake_fd = -1;
+		}
+		if (_epoll_fd != -1) {
+			close(_epoll_fd);
+			_epoll_fd = -1;
+		}
+		return;
+	}
+
+	for (unsigned i = 0; i < n_threads; ++i) {
+		_threads.emplace_back(&SocketLoop::run, this);
+	}
+}
+
+SocketLoop::~SocketLoop()
+{
+	_exit_flag = true;
+	if (_wake_fd != -1) {
+		eventfd_write(_wake_fd, 1);
+	}
+
+	for (auto& t : _threads) {
+		t.join();
+	}
+
+	for (const auto& c : _connections) {
+		if (c.first == c.second->fd()) {
+			_engine.unregister_client(c.second->queue());
+		}
+	}
+	_connections.clear();
+
+	if (_wake_fd != -1) {
+		close(_wake_fd);
+	}
+	if (_epoll_fd != -1) {
+		close(_epoll_fd);
+	}
+}
+
+void
+SocketLoop::add(const std::shared_ptr<raul::Socket>& sock)
+{
+	const int fd = sock->fd();
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+	auto      conn      = std::make_shared<Connection>(_engine, sock);
+	const int notify_fd = conn->notify_fd();
+	if (notify_fd == -1) {
+		_engine.world().log().error("Failed to create eventfd (%1%)\n",
+		                            strerror(errno));
+		return;
+	}
+
+	_engine.register_client(conn->queue());
+
+	// Watch for input, space to send output, and queued messages
+	struct epoll_event ev{};
+	ev.events  = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+	ev.data.fd = fd;
+
+	struct epoll_event notify_ev{};
+	notify_ev.events  = EPOLLIN | EPOLLET;
+	notify_ev.data.fd = notify_fd;
+	{
+		const std::lock_guard<std::mutex> lock{_mutex};
+		_connections.emplace(fd, conn);
+		_connections.emplace(notify_fd, conn);
+		if (!epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &ev)) {
+			if (!epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, notify_fd, &notify_ev)) {
+				return;
+			}
+
+			epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+		}
+
+		_connections.erase(fd);
+		_connections.erase(notify_fd);
+	}
+
+	_engine.world().log().error("Failed to watch socket (%1%)\n",
+	                            strerror(errno));
+	_engine.unregister_client(conn->queue());
+}
+
+void
+SocketLoop::remove(const std::shared_ptr<Connection>& conn)
+{
+	{
+		const std::lock_guard<std::mutex> lock{_mutex};
+		const auto c = _connections.find(conn->fd());
+		if (c == _connections.end() || c->second != conn) {
+			return; // Already removed by another thread
+		}
+
+		epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, conn->fd(), nullptr);
+		epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, conn->notify_fd(), nullptr);
+		_connections.erase(c);
+		_connections.erase(conn->notify_fd());
+	}
+
+	_engine.unregister_client(conn->queue());
+
+	const uint64_t n_dropped   = conn->queue()->n_dropped();
+	const uint64_t n_coalesced = conn->queue()->n_coalesced();
+	if (n_dropped || n_coalesced) {
+		_engine.world().log().info(
+			"Client %1% had %2% messages dropped and %3% coalesced\n",
+			conn->queue()->uri(),
+			n_dropped,
+			n_coalesced);
+	}
+}
+
+void
+SocketLoop::run()
+{
+	static constexpr int max_events = 16;
+
+	struct epoll_event events[max_events];
+	while (!_exit_flag) {
+		const int n = epoll_wait(_epoll_fd, events, max_events, -1);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			_engine.world().log().error("Socket loop error (%1%)\n",
+			                            strerror(errno));
+			break;
+		}
+
+		for (int i = 0; i < n; ++i) {
+			const int fd = events[i].data.fd;
+			if (fd == _wake_fd) {
+				return; // Exiting, leave event set so other threads see it
+			}
+
+			std::shared_ptr<Connection> conn;
+			{
+				const std::lock_guard<std::mutex> lock{_mutex};
+				const auto c = _connections.find(fd);
+				if (c != _connections.end()) {
+					conn = c->second;
+				}
+			}
+
+			if (conn && !conn->handle(fd, events[i].events)) {
+				remove(conn);
+			}
+		}
+	}
+}
+
+} // namespace ingen::server
@@ -0,0 +1,82 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_SOCKETLOOP_HPP
+#define INGEN_ENGINE_SOCKETLOOP_HPP
+
+#include <raul/Noncopyable.hpp>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace raul {
+class Socket;
+} // namespace raul
+
+namespace ingen::server {
+
+class Engine;
+
+/** Serves socket connections from a small fixed pool of threads.
+ *
+ * Every connection is added to a single edge-triggered epoll set, which all
+ * threads wait on.  Input is read without blocking and dispatched to the
+ * engine whenever complete messages have arrived.  Messages to the client go
+ * through a ClientQueue, which is drained by the loop when notified via an
+ * eventfd in the same set.  Output is sent without blocking as well, and
+ * whatever the socket does not accept is buffered for that connection and
+ * flushed when it becomes writable again, so a slow client never blocks the
+ * broadcaster.  A client that falls too far behind is disconnected.
+ *
+ * \ingroup engine
+ */
+class SocketLoop : public raul::Noncopyable
+{
+public:
+	SocketLoop(Engine& engine, unsigned n_threads);
+
+	~SocketLoop();
+
+	/** Return true iff the loop was set up and is running. */
+	bool is_running() const { return _epoll_fd != -1; }
+
+	/** Start serving a newly accepted connection. */
+	void add(const std::shared_ptr<raul::Socket>& sock);
+
+private:
+	class Connection;
+
+	void run();
+
+	/** Stop serving a connection after it hung up or failed. */
+	void remove(const std::shared_ptr<Connection>& conn);
+
+	Engine&                                    _engine;
+	int                                        _epoll_fd{-1};
+	int                                        _wake_fd{-1};
+	std::mutex                                 _mutex;
+	std::map<int, std::shared_ptr<Connection>> _connections;
+	std::atomic<bool>                          _exit_flag{false};
+	std::vector<std::thread>                   _threads;
+};
+
+} // namespace ingen::server
+
+#endif // INGEN_ENGINE_SOCKETLOOP_HPP
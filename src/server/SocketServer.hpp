@@ -17,22 +17,26 @@
 #ifndef INGEN_SERVER_SOCKET_SERVER_HPP
 #define INGEN_SERVER_SOCKET_SERVER_HPP
 
-#include "EventWriter.hpp"
-
+#include "ClientQueue.hpp"
 #include "Engine.hpp"
+#include "EventWriter.hpp"
 
 #include <ingen/Atom.hpp>
 #include <ingen/ColorContext.hpp>
 #include <ingen/Configuration.hpp>
 #include <ingen/Interface.hpp>
+#include <ingen/Log.hpp>
 #include <ingen/SocketReader.hpp>
 #include <ingen/SocketWriter.hpp>
 #include <ingen/StreamWriter.hpp>
 #include <ingen/Tee.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/WireFormat.hpp>
 #include <ingen/World.hpp>
 #include <raul/Socket.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <memory>
@@ -47,42 +51,79 @@ public:
 	             server::Engine&                      engine,
 	             const std::shared_ptr<raul::Socket>& sock)
 		: _engine(engine)
-		, _sink(world.conf().option("dump").get<int32_t>()
-		        ? std::shared_ptr<Interface>(
-			        new Tee({std::shared_ptr<Interface>(new EventWriter(engine)),
-					         std::shared_ptr<Interface>(new StreamWriter(world.uri_map(),
-					                                          world.uris(),
-					                                          URI("ingen:/engine"),
-					                                          stderr,
-					                                          ColorContext::Color::CYAN))}))
-		        : std::shared_ptr<Interface>(new EventWriter(engine)))
-		, _reader(new SocketReader(world, *_sink, sock))
+		, _sink(make_sink(world, engine))
 		, _writer(new SocketWriter(world.uri_map(),
 		                           world.uris(),
 		                           URI(sock->uri()),
 		                           sock))
+		, _queue(std::make_shared<ClientQueue>(
+			  world.log(),
+			  world.uris(),
+			  _writer,
+			  queue_size(world),
+			  [&world, sock] {
+				  world.log().warn("Disconnecting %1% which is not reading\n",
+				                   sock->uri());
+				  sock->shutdown();
+			  }))
+		, _reader(new SocketReader(world,
+		                           *_sink,
+		                           sock,
+		                           WireFormat::TURTLE,
+		                           [this](WireFormat format) {
+			                           _writer->set_format(format);
+		                           }))
 	{
-		_sink->set_respondee(_writer);
-		engine.register_client(_writer);
+		_sink->set_respondee(_queue);
+		engine.register_client(_queue);
 	}
 
 	~SocketServer() {
-		if (_writer) {
-			_engine.unregister_client(_writer);
+		if (_queue) {
+			_engine.unregister_client(_queue);
+		}
+	}
+
+	/** Return the number of messages to queue for each client. */
+	static size_t queue_size(World& world)
+	{
+		const int32_t size =
+			world.conf().option("client-queue-size").get<int32_t>();
+
+		return static_cast<size_t>(std::max(size, 1));
+	}
+
+	/** Make the interface that messages from a client are written to. */
+	static std::shared_ptr<Interface> make_sink(World&          world,
+	                                            server::Engine& engine)
+	{
+		if (!world.conf().option("dump").get<int32_t>()) {
+			return std::shared_ptr<Interface>(new EventWriter(engine));
 		}
+
+		return std::shared_ptr<Interface>(
+			new Tee({std::shared_ptr<Interface>(new EventWriter(engine)),
+			         std::shared_ptr<Interface>(
+				         new StreamWriter(world.uri_map(),
+				                          world.uris(),
+				                          URI("ingen:/engine"),
+				                          stderr,
+				                          ColorContext::Color::CYAN))}));
 	}
 
 protected:
 	void on_hangup() {
-		_engine.unregister_client(_writer);
+		_engine.unregister_client(_queue);
+		_queue.reset();
 		_writer.reset();
 	}
 
 private:
 	server::Engine&               _engine;
 	std::shared_ptr<Interface>    _sink;
-	std::shared_ptr<SocketReader> _reader;
 	std::shared_ptr<SocketWriter> _writer;
+	std::shared_ptr<ClientQueue>  _queue;
+	std::shared_ptr<SocketReader> _reader;
 };
 
 } // namespace ingen::server
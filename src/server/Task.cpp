@@ -16,96 +16,267 @@
 
 #include "Task.hpp"
 
+#include "Backoff.hpp"
 #include "BlockImpl.hpp"
+#include "Engine.hpp"
+#include "Profile.hpp"
 #include "RunContext.hpp"
 
 #include <raul/Path.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace ingen::server {
 
+/** Record the time taken to process a block for a whole cycle. */
+static void
+record_block_ticks(RunContext& ctx, BlockImpl& block, uint64_t ticks)
+{
+	block.update_cost(ticks);
+	if (ctx.engine().profiling()) {
+		block.profile().record(ticks);
+	}
+}
+
+/** Record time spent processing blocks in the thread of `ctx`. */
+static void
+record_context_ticks(RunContext& ctx, uint64_t ticks)
+{
+	if (ctx.engine().profiling()) {
+		ctx.engine().context_profile(ctx.id()).record(ticks);
+	}
+}
+
 void
 Task::run(RunContext& ctx)
 {
 	switch (_mode) {
-	case Mode::SINGLE:
+	case Mode::SINGLE: {
 		// fprintf(stderr, "%u run %s\n", context.id(), _block->path().c_str());
+		const uint64_t start = profile_ticks();
 		_block->process(ctx);
+
+		const uint64_t ticks = profile_ticks() - start;
+		record_block_ticks(ctx, *_block, ticks);
+		record_context_ticks(ctx, ticks);
 		break;
+	}
 	case Mode::SEQUENTIAL:
 		for (const auto& task : _children) {
 			task->run(ctx);
 		}
 		break;
 	case Mode::PARALLEL:
-		// Initialize (not) done state of sub-tasks
-		for (const auto& task : _children) {
-			task->set_done(false);
+		run_parallel(ctx, _children);
+		break;
+	case Mode::DATAFLOW:
+		run_dataflow(ctx);
+		break;
+	case Mode::VOICES:
+		run_voices(ctx);
+		break;
+	case Mode::VOICE_GROUP:
+		run_voice_group(ctx);
+		break;
+	}
+
+	finish(ctx);
+}
+
+void
+Task::finish(RunContext& ctx)
+{
+	// Release dependants whose last provider this was
+	bool released = false;
+	for (Task* const d : _dependants) {
+		if (d->_n_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			if (ctx.push_task(d)) {
+				released = true;
+			} else {
+				d->run(ctx); // Queue is full, run it here
+			}
 		}
+	}
 
-		// Grab the first sub-task
-		_next     = 0;
-		_done_end = 0;
-		Task* t = steal(ctx);
+	if (released) {
+		ctx.signal_tasks_available();
+	}
 
-		// Allow other threads to steal sub-tasks
-		ctx.claim_task(this);
+	if (_parent) {
+		_parent->_n_pending.fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
 
-		// Run available tasks until this task is finished
-		for (; t; t = get_task(ctx)) {
-			t->run(ctx);
+void
+Task::run_parallel(RunContext& ctx, const Children& tasks)
+{
+	if (tasks.empty()) {
+		return;
+	}
+
+	_n_pending.store(static_cast<unsigned>(tasks.size()),
+	                 std::memory_order_relaxed);
+
+	/* Push all but the first sub-task to our queue.  Children are sorted by
+	   decreasing cost, so other threads steal the expensive ones first while
+	   we pop the cheap ones from the back after running the first. */
+	for (size_t i = 1; i < tasks.size(); ++i) {
+		Task* const child = tasks[i].get();
+		child->_parent    = this;
+		if (!ctx.push_task(child)) {
+			child->run(ctx); // Queue is full, run it here
 		}
-		ctx.claim_task(nullptr);
-		break;
 	}
 
-	set_done(true);
+	// Allow other threads to steal sub-tasks
+	ctx.signal_tasks_available();
+
+	// Run the first sub-task directly
+	tasks.front()->_parent = this;
+	tasks.front()->run(ctx);
+
+	wait_for_children(ctx);
 }
 
-Task*
-Task::steal(RunContext&)
+void
+Task::run_voices(RunContext& ctx)
 {
-	if (_mode == Mode::PARALLEL) {
-		const unsigned i = _next++;
-		if (i < _children.size()) {
-			return _children[i].get();
+	// Only split if every block is enabled with the same number of voices
+	const uint32_t poly  = _children.front()->_block->polyphony();
+	const bool     split = poly > 1 &&
+		std::all_of(_children.begin(),
+		            _children.end(),
+		            [poly](const auto& c) {
+			            return c->_block->enabled() &&
+			                   c->_block->polyphony() == poly;
+		            });
+
+	if (!split) {
+		// Run blocks in order like a sequential task
+		for (const auto& task : _children) {
+			task->run(ctx);
 		}
+		return;
 	}
 
-	return nullptr;
+	for (const auto& task : _children) {
+		task->_block->pre_process(ctx);
+	}
+
+	run_parallel(ctx, _groups);
+
+	for (size_t i = 0; i < _children.size(); ++i) {
+		BlockImpl* const block = _children[i]->_block;
+		block->post_process(ctx);
+
+		// Total time taken by all groups, which is the cost to balance
+		uint64_t ticks = 0;
+		for (const auto& group : _groups) {
+			ticks += group->_ticks[i];
+		}
+
+		record_block_ticks(ctx, *block, ticks);
+	}
 }
 
-Task*
-Task::get_task(RunContext& ctx)
+void
+Task::run_voice_group(RunContext& ctx)
 {
-	// Attempt to "steal" a task from ourselves
-	Task* t = steal(ctx);
-	if (t) {
-		return t;
-	}
+	const Children& blocks   = _parent->_children;
+	const auto      n_groups = static_cast<uint32_t>(_parent->_groups.size());
+	const uint32_t  poly     = blocks.front()->_block->polyphony();
+	const uint32_t  begin    = _group * poly / n_groups;
+	const uint32_t  end      = (_group + 1) * poly / n_groups;
 
-	while (true) {
-		// Push done end index as forward as possible
-		while (_done_end < _children.size() && _children[_done_end]->done()) {
-			++_done_end;
+	uint64_t total = 0;
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		const uint64_t start = profile_ticks();
+		if (begin < end) {
+			blocks[i]->_block->process_voices(ctx, begin, end);
 		}
+		_ticks[i] = profile_ticks() - start;
+		total += _ticks[i];
+	}
+
+	record_context_ticks(ctx, total);
+}
+
+void
+Task::add_groups(unsigned n_groups)
+{
+	for (unsigned g = 0; g < n_groups; ++g) {
+		auto group    = std::make_unique<Task>(Mode::VOICE_GROUP);
+		group->_group = g;
+		group->_ticks.resize(_children.size());
+		_groups.emplace_back(std::move(group));
+	}
+}
+
+void
+Task::run_dataflow(RunContext& ctx)
+{
+	if (_children.empty()) {
+		return;
+	}
 
-		if (_done_end >= _children.size()) {
-			return nullptr; // All child tasks are finished
+	// Reset counters, which are all zero since the last run finished
+	for (const auto& child : _children) {
+		child->_parent = this;
+		child->_n_pending.store(child->_n_providers, std::memory_order_relaxed);
+	}
+
+	_n_pending.store(static_cast<unsigned>(_children.size()),
+	                 std::memory_order_relaxed);
+
+	/* Push every child with no providers except the first, which we run
+	   directly.  Everything else is pushed by finish() when ready. */
+	Task* first = nullptr;
+	for (const auto& child : _children) {
+		if (child->_n_providers == 0) {
+			if (!first) {
+				first = child.get();
+			} else if (!ctx.push_task(child.get())) {
+				child->run(ctx); // Queue is full, run it here
+			}
 		}
+	}
 
-		// All child tasks claimed, but some are unfinished, steal a task
-		if ((t = ctx.steal_task())) {
-			return t;
+	ctx.signal_tasks_available();
+
+	assert(first); // Graph compilation ensures there are no cycles
+	first->run(ctx);
+
+	wait_for_children(ctx);
+}
+
+void
+Task::wait_for_children(RunContext& ctx)
+{
+	// Run available tasks until all sub-tasks are finished
+	Backoff backoff = ctx.engine().make_backoff();
+	while (_n_pending.load(std::memory_order_acquire) > 0) {
+		Task* t = ctx.pop_task();
+		if (!t) {
+			t = ctx.steal_task();
 		}
 
-		/* All child tasks are claimed, and we failed to steal any tasks.  Spin
-		   to prevent blocking, though it would probably be wiser to wait for a
-		   signal in non-main threads, and maybe even in the main thread
-		   depending on your real-time safe philosophy... more experimentation
-		   here is needed. */
+		if (t) {
+			t->run(ctx);
+			backoff.reset();
+		} else if (ctx.id() == 0 || !backoff.pause()) {
+			/* All sub-tasks are claimed, but some are unfinished.  Spin, but
+			   never park, since nothing signals the completion of a sub-task
+			   and it is probably nearly finished anyway.  The audio thread
+			   never yields either. */
+			backoff.spin();
+		}
 	}
 }
 
@@ -139,6 +310,229 @@ Task::simplify(std::unique_ptr<Task>&& task)
 	return ret;
 }
 
+/** Return true iff `task` is a block that can be split into voice groups. */
+static bool
+is_voice_block(const Task& task)
+{
+	return task.mode() == Task::Mode::SINGLE &&
+	       task.block()->voices_independent();
+}
+
+/** Return true iff `next` is only connected to `prev`, and vice versa. */
+static bool
+is_voice_chain(const BlockImpl* prev, const BlockImpl* next)
+{
+	return prev->dependants().size() == 1 && next->providers().size() == 1 &&
+	       *prev->dependants().begin() == next &&
+	       *next->providers().begin() == prev;
+}
+
+std::unique_ptr<Task>
+Task::split_voices(std::unique_ptr<Task>&& task, unsigned n_groups)
+{
+	if (n_groups < 2) {
+		return std::move(task);
+	}
+
+	if (is_voice_block(*task)) {
+		return std::make_unique<Task>(voices(task->_block, n_groups));
+	}
+
+	if (task->_mode != Mode::SEQUENTIAL && task->_mode != Mode::PARALLEL) {
+		return std::move(task);
+	}
+
+	Children children = std::move(task->_children);
+	task->_children.clear();
+
+	for (size_t i = 0; i < children.size();) {
+		if (!is_voice_block(*children[i])) {
+			task->append(split_voices(std::move(children[i++]), n_groups));
+			continue;
+		}
+
+		// Start a chain, and extend it while the next block only follows this
+		auto chain = std::make_unique<Task>(Mode::VOICES);
+		chain->append(std::move(children[i++]));
+		while (task->_mode == Mode::SEQUENTIAL && i < children.size() &&
+		       is_voice_block(*children[i]) &&
+		       is_voice_chain(chain->_children.back()->_block,
+		                      children[i]->_block)) {
+			chain->append(std::move(children[i++]));
+		}
+
+		chain->add_groups(n_groups);
+		task->append(std::move(chain));
+	}
+
+	return std::move(task);
+}
+
+Task
+Task::voices(BlockImpl* block, unsigned n_groups)
+{
+	Task task(Mode::VOICES);
+	task.push_back(Task(Mode::SINGLE, block));
+	task.add_groups(n_groups);
+	return task;
+}
+
+std::unique_ptr<Task>
+Task::copy(const std::unordered_set<const BlockImpl*>& blocks,
+           const Insertions&                           before,
+           const Insertions&                           after) const
+{
+	assert(_mode != Mode::DATAFLOW && _mode != Mode::VOICE_GROUP);
+
+	if (_mode == Mode::SINGLE) {
+		if (!blocks.count(_block)) {
+			return std::make_unique<Task>(Mode::SEQUENTIAL); // Empty
+		}
+
+		const auto b = before.find(_block);
+		const auto a = after.find(_block);
+		if (b == before.end() && a == after.end()) {
+			return std::make_unique<Task>(Mode::SINGLE, _block);
+		}
+
+		// Replace block with a sequence that includes the inserted blocks
+		auto seq = std::make_unique<Task>(Mode::SEQUENTIAL);
+		if (b != before.end()) {
+			for (auto* n : b->second) {
+				seq->push_back(Task(Mode::SINGLE, n));
+			}
+		}
+
+		seq->push_back(Task(Mode::SINGLE, _block));
+
+		if (a != after.end()) {
+			for (auto* n : a->second) {
+				seq->push_back(Task(Mode::SINGLE, n));
+			}
+		}
+
+		return seq;
+	}
+
+	// Voice groups are added again by split_voices() after compiling
+	auto ret = std::make_unique<Task>(
+		_mode == Mode::VOICES ? Mode::SEQUENTIAL : _mode);
+	for (const auto& c : _children) {
+		auto child = c->copy(blocks, before, after);
+		if (!child->empty()) {
+			ret->append(std::move(child));
+		}
+	}
+
+	return ret;
+}
+
+float
+Task::cost() const
+{
+	if (_mode == Mode::SINGLE) {
+		return std::max(_block->cost(), min_cost);
+	}
+
+	float sum = 0.0f;
+	for (const auto& c : _children) {
+		sum += c->cost();
+	}
+	return sum;
+}
+
+float
+Task::span() const
+{
+	if (_mode == Mode::SINGLE) {
+		return std::max(_block->cost(), min_cost);
+	}
+
+	float span = 0.0f;
+	for (const auto& c : _children) {
+		span = (_mode == Mode::PARALLEL) ? std::max(span, c->span())
+		                                 : span + c->span();
+	}
+	return span;
+}
+
+void
+Task::balance(unsigned n_threads)
+{
+	for (const auto& c : _children) {
+		c->balance(n_threads);
+	}
+
+	if (_mode != Mode::PARALLEL || _children.size() < 2) {
+		return;
+	}
+
+	// Sort children by decreasing span, so the critical path starts first
+	struct Costed {
+		float                 span{0.0f};
+		float                 cost{0.0f};
+		std::unique_ptr<Task> task;
+	};
+
+	std::vector<Costed> children;
+	children.reserve(_children.size());
+	for (auto&& c : _children) {
+		const float c_span = c->span();
+		const float c_cost = c->cost();
+		children.push_back({c_span, c_cost, std::move(c)});
+	}
+	_children.clear();
+
+	std::stable_sort(children.begin(),
+	                 children.end(),
+	                 [](const Costed& a, const Costed& b) {
+		                 return a.span > b.span ||
+		                        (a.span == b.span && a.cost > b.cost);
+	                 });
+
+	if (n_threads < 2 || children.size() <= n_threads) {
+		for (auto&& c : children) {
+			_children.emplace_back(std::move(c.task));
+		}
+		return;
+	}
+
+	/* Too many children to run at once, so pack them into one sequential group
+	   per thread, greedily adding each to the group with the least cost.  The
+	   span of a sequential group is its cost, so groups are then ordered by
+	   cost alone. */
+	std::vector<Costed> groups(n_threads);
+	for (auto&& c : children) {
+		auto g = std::min_element(groups.begin(),
+		                          groups.end(),
+		                          [](const Costed& a, const Costed& b) {
+			                          return a.cost < b.cost;
+		                          });
+		if (!g->task) {
+			g->task = std::move(c.task);
+		} else {
+			if (g->task->mode() != Mode::SEQUENTIAL) {
+				// Siblings are independent, so any order within a group is fine
+				auto seq = std::make_unique<Task>(Mode::SEQUENTIAL);
+				seq->append(std::move(g->task));
+				g->task = std::move(seq);
+			}
+			g->task->append(std::move(c.task));
+		}
+		g->cost += c.cost;
+	}
+
+	std::stable_sort(groups.begin(),
+	                 groups.end(),
+	                 [](const Costed& a, const Costed& b) {
+		                 return a.cost > b.cost;
+	                 });
+
+	for (auto&& g : groups) {
+		_children.emplace_back(std::move(g.task));
+	}
+}
+
 void
 Task::dump(const std::function<void(const std::string&)>& sink,
            unsigned                                       indent,
@@ -154,7 +548,10 @@ Task::dump(const std::function<void(const std::string&)>& sink,
 	if (_mode == Mode::SINGLE) {
 		sink(_block->path());
 	} else {
-		sink(((_mode == Mode::SEQUENTIAL) ? "(seq " : "(par "));
+		sink((_mode == Mode::SEQUENTIAL) ? "(seq "
+		     : (_mode == Mode::PARALLEL) ? "(par "
+		     : (_mode == Mode::VOICES)   ? "(voices "
+		                                 : "(dataflow ");
 		for (size_t i = 0; i < _children.size(); ++i) {
 			_children[i]->dump(sink, indent + 5, i == 0);
 		}
@@ -19,11 +19,15 @@
 
 #include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 namespace ingen::server {
 
@@ -33,10 +37,15 @@ class RunContext;
 class Task
 {
 public:
+	using Children = std::deque<std::unique_ptr<Task>>;
+
 	enum class Mode {
 		SINGLE,     ///< Single block to run
 		SEQUENTIAL, ///< Elements must be run sequentially in order
-		PARALLEL    ///< Elements may be run in any order in parallel
+		PARALLEL,   ///< Elements may be run in any order in parallel
+		DATAFLOW,   ///< Elements are run as soon as their providers finish
+		VOICES,     ///< Chain of blocks run in parallel groups of voices
+		VOICE_GROUP ///< One group of voices of the parent VOICES task
 	};
 
 	Task(Mode mode, BlockImpl* block)
@@ -55,19 +64,27 @@ public:
 		: _children(std::move(task._children))
 		, _block(task._block)
 		, _mode(task._mode)
-		, _done_end(task._done_end)
-		, _next(task._next.load())
-		, _done(task._done.load())
+		, _dependants(std::move(task._dependants))
+		, _groups(std::move(task._groups))
+		, _ticks(std::move(task._ticks))
+		, _parent(task._parent)
+		, _group(task._group)
+		, _n_providers(task._n_providers)
+		, _n_pending(task._n_pending.load())
 	{}
 
 	Task& operator=(Task&& task) noexcept
 	{
-		_children = std::move(task._children);
-		_block    = task._block;
-		_mode     = task._mode;
-		_done_end = task._done_end;
-		_next     = task._next.load();
-		_done     = task._done.load();
+		_children    = std::move(task._children);
+		_block       = task._block;
+		_mode        = task._mode;
+		_dependants  = std::move(task._dependants);
+		_groups      = std::move(task._groups);
+		_ticks       = std::move(task._ticks);
+		_parent      = task._parent;
+		_group       = task._group;
+		_n_providers = task._n_providers;
+		_n_pending   = task._n_pending.load();
 		return *this;
 	}
 
@@ -85,35 +102,120 @@ public:
 	/** Simplify task expression. */
 	static std::unique_ptr<Task> simplify(std::unique_ptr<Task>&& task);
 
-	/** Steal a child task from this task (succeeds for PARALLEL only). */
-	Task* steal(RunContext& ctx);
+	/** Split polyphonic blocks into tasks that run groups of voices.
+	 *
+	 * This replaces every block that is BlockImpl::voices_independent() with
+	 * a VOICES task that runs its voices in `n_groups` parallel groups.
+	 * Consecutive blocks in a sequential task which are only connected to
+	 * each other are merged into a single VOICES task, so each group runs its
+	 * voices through the whole chain without waiting for the others.  The
+	 * mix in the input ports of the following blocks is the join.
+	 */
+	static std::unique_ptr<Task> split_voices(std::unique_ptr<Task>&& task,
+	                                          unsigned                n_groups);
+
+	/** Return a VOICES task for `block` alone with `n_groups` groups. */
+	static Task voices(BlockImpl* block, unsigned n_groups);
+
+	/** Blocks to run next to other blocks, used when copying a task tree. */
+	using Insertions =
+		std::unordered_map<const BlockImpl*, std::vector<BlockImpl*>>;
+
+	/** Return a copy of this task tree with only the given blocks.
+	 *
+	 * Blocks not in `blocks` are not dereferenced, so this is safe to call
+	 * on a tree that refers to blocks which have since been deleted.  This
+	 * only works for trees of SINGLE, SEQUENTIAL, PARALLEL, and VOICES tasks,
+	 * where VOICES tasks are copied as SEQUENTIAL tasks.
+	 *
+	 * @param blocks The blocks to keep.
+	 * @param before Blocks to run immediately before a kept block.
+	 * @param after Blocks to run immediately after a kept block.
+	 */
+	std::unique_ptr<Task>
+	copy(const std::unordered_set<const BlockImpl*>& blocks,
+	     const Insertions&                           before,
+	     const Insertions&                           after) const;
+
+	/** Return the estimated time to run this task in profile ticks. */
+	float cost() const;
+
+	/** Return the estimated time of the longest path through this task.
+	 *
+	 * This is the time the task would take with unlimited threads: the sum
+	 * of its children for sequential tasks, and the maximum for parallel.
+	 */
+	float span() const;
+
+	/** Balance parallel tasks based on the measured cost of blocks.
+	 *
+	 * This recursively orders the children of parallel tasks so that those
+	 * with the longest path are run first, and packs them into at most `n_threads`
+	 * sequential groups of roughly equal cost so that cheap blocks are not
+	 * scheduled (and stolen) individually.
+	 */
+	void balance(unsigned n_threads);
 
 	/** Prepend a child to this task. */
 	void push_front(Task&& task) {
 		_children.emplace_front(std::make_unique<Task>(std::move(task)));
 	}
 
-	Mode       mode()  const { return _mode; }
-	BlockImpl* block() const { return _block; }
-	bool       done()  const { return _done; }
+	/** Append a child to this task and return a reference to it. */
+	Task& push_back(Task&& task) {
+		_children.emplace_back(std::make_unique<Task>(std::move(task)));
+		return *_children.back();
+	}
+
+	/** Add a sibling in a DATAFLOW task which must run after this one. */
+	void add_dependant(Task& dependant) {
+		_dependants.push_back(&dependant);
+		++dependant._n_providers;
+	}
 
-	void set_done(bool done) { _done = done; }
+	Mode            mode()     const { return _mode; }
+	BlockImpl*      block()    const { return _block; }
+	const Children& children() const { return _children; }
 
 private:
-	using Children = std::deque<std::unique_ptr<Task>>;
+	/** Minimum cost of a single block, so unmeasured blocks are not free. */
+	static constexpr float min_cost = 1.0f;
+
+	/** Run tasks in parallel, pushing all but one for other threads to steal. */
+	void run_parallel(RunContext& ctx, const Children& tasks);
+
+	/** Run a VOICES task, splitting voices into groups if possible. */
+	void run_voices(RunContext& ctx);
+
+	/** Run the voices of this VOICE_GROUP task through the parent's blocks. */
+	void run_voice_group(RunContext& ctx);
+
+	/** Add the groups of this VOICES task. */
+	void add_groups(unsigned n_groups);
+
+	/** Run a DATAFLOW task, starting with the children with no providers. */
+	void run_dataflow(RunContext& ctx);
+
+	/** Run queued tasks until all children of this task are finished. */
+	void wait_for_children(RunContext& ctx);
 
-	Task* get_task(RunContext& ctx);
+	/** Release any ready dependants and notify the parent (if any). */
+	void finish(RunContext& ctx);
 
 	void append(std::unique_ptr<Task>&& t) {
 		_children.emplace_back(std::move(t));
 	}
 
-	Children              _children;    ///< Vector of child tasks
-	BlockImpl*            _block;       ///< Used for SINGLE only
-	Mode                  _mode;        ///< Execution mode
-	unsigned              _done_end{0}; ///< Index of rightmost done sub-task
-	std::atomic<unsigned> _next{0};     ///< Index of next sub-task
-	std::atomic<bool>     _done{false}; ///< Completion phase
+	Children              _children;         ///< Vector of child tasks
+	BlockImpl*            _block;            ///< Used for SINGLE only
+	Mode                  _mode;             ///< Execution mode
+	std::vector<Task*>    _dependants;       ///< Siblings waiting on this task
+	Children              _groups;           ///< Voice groups (VOICES only)
+	std::vector<uint64_t> _ticks;            ///< Run time of each block
+	Task*                 _parent{nullptr};  ///< Enclosing parallel task
+	unsigned              _group{0};         ///< Index (VOICE_GROUP only)
+	unsigned              _n_providers{0};   ///< Siblings this task waits on
+	std::atomic<unsigned> _n_pending{0};     ///< Unfinished children/providers
 };
 
 } // namespace ingen::server
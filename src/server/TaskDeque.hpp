@@ -0,0 +1,154 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_TASKDEQUE_HPP
+#define INGEN_ENGINE_TASKDEQUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ingen::server {
+
+class Task;
+
+/** A lock-free work-stealing deque of ready tasks.
+ *
+ * This is a fixed-capacity Chase-Lev deque.  The owning run context pushes
+ * and pops tasks at the bottom (LIFO, which keeps recently touched buffers in
+ * cache), while other run contexts steal from the top (FIFO, which takes the
+ * oldest and typically largest pieces of work).
+ *
+ * The capacity is fixed at construction time so that no allocation ever
+ * happens in the audio thread.  If the deque is full, push() fails and the
+ * caller is expected to run the task itself.
+ *
+ * \ingroup engine
+ */
+class TaskDeque
+{
+public:
+	/** Create a new deque with at least `capacity` slots. */
+	explicit TaskDeque(size_t capacity)
+		: _size(next_power_of_two(capacity))
+		, _mask(_size - 1)
+		, _buf(new std::atomic<Task*>[_size])
+	{
+		for (size_t i = 0; i < _size; ++i) {
+			_buf[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	TaskDeque(const TaskDeque&) = delete;
+	TaskDeque& operator=(const TaskDeque&) = delete;
+	TaskDeque(TaskDeque&&) = delete;
+	TaskDeque& operator=(TaskDeque&&) = delete;
+
+	~TaskDeque() = default;
+
+	/** Push a task to the bottom (owner only).
+	 * @return false if the deque is full.
+	 */
+	bool push(Task* task) {
+		const int64_t b = _bottom.load(std::memory_order_relaxed);
+		const int64_t t = _top.load(std::memory_order_acquire);
+		if (b - t >= static_cast<int64_t>(_size)) {
+			return false;
+		}
+
+		_buf[static_cast<size_t>(b) & _mask].store(task, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		_bottom.store(b + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/** Pop the most recently pushed task from the bottom (owner only). */
+	Task* pop() {
+		const int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+		_bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = _top.load(std::memory_order_relaxed);
+
+		if (t > b) {
+			// Empty
+			_bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Task* task = _buf[static_cast<size_t>(b) & _mask].load(std::memory_order_relaxed);
+		if (t == b) {
+			// Last element, race against thieves for it
+			if (!_top.compare_exchange_strong(t,
+			                                  t + 1,
+			                                  std::memory_order_seq_cst,
+			                                  std::memory_order_relaxed)) {
+				task = nullptr;
+			}
+			_bottom.store(b + 1, std::memory_order_relaxed);
+		}
+
+		return task;
+	}
+
+	/** Steal the oldest task from the top (any thread). */
+	Task* steal() {
+		int64_t t = _top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64_t b = _bottom.load(std::memory_order_acquire);
+		if (t >= b) {
+			return nullptr;
+		}
+
+		Task* task = _buf[static_cast<size_t>(t) & _mask].load(std::memory_order_relaxed);
+		if (!_top.compare_exchange_strong(t,
+		                                  t + 1,
+		                                  std::memory_order_seq_cst,
+		                                  std::memory_order_relaxed)) {
+			return nullptr; // Lost race with owner or another thief
+		}
+
+		return task;
+	}
+
+	/** Return true iff the deque appears empty (racy, for hints only). */
+	bool empty() const {
+		return _top.load(std::memory_order_relaxed) >=
+		       _bottom.load(std::memory_order_relaxed);
+	}
+
+	size_t capacity() const { return _size; }
+
+private:
+	static size_t next_power_of_two(size_t n) {
+		size_t s = 1;
+		while (s < n) {
+			s <<= 1U;
+		}
+		return s;
+	}
+
+	const size_t                          _size;
+	const size_t                          _mask;
+	std::unique_ptr<std::atomic<Task*>[]> _buf;
+
+	alignas(64) std::atomic<int64_t> _top{0};
+	alignas(64) std::atomic<int64_t> _bottom{0};
+};
+
+} // namespace ingen::server
+
+#endif // INGEN_ENGINE_TASKDEQUE_HPP
@@ -28,6 +28,7 @@ enum ThreadFlag {
 	THREAD_PRE_PROCESS  = 1 << 1,
 	THREAD_PROCESS      = 1 << 2,
 	THREAD_MESSAGE      = 1 << 3,
+	THREAD_BLOCK_LOADER = 1 << 4,
 };
 
 class INGEN_SERVER_API ThreadManager
@@ -0,0 +1,129 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef INGEN_ENGINE_TURTLESPLITTER_HPP
+#define INGEN_ENGINE_TURTLESPLITTER_HPP
+
+#include <cstddef>
+
+namespace ingen::server {
+
+/** Finds the ends of top-level statements in a stream of Turtle text.
+ *
+ * This only tracks enough syntax to tell a statement's final '.' from one in
+ * an IRI, string, comment, number, or name, so complete messages can be
+ * passed to the parser as they arrive.
+ *
+ * \ingroup engine
+ */
+class TurtleSplitter
+{
+public:
+	/** Scan `buf` for the end of the next statement.
+	 *
+	 * Scanning continues from where the previous call stopped.
+	 *
+	 * @return The offset just past the end of the statement, or zero if the
+	 * statement is not complete yet.
+	 */
+	size_t next(const char* buf, size_t len)
+	{
+		for (; _pos < len; ++_pos) {
+			const char c = buf[_pos];
+			switch (_state) {
+			case State::TEXT:
+				if (c == '<') {
+					_state = State::IRI;
+				} else if (c == '#') {
+					_state = State::COMMENT;
+				} else if (c == '"' || c == '\'') {
+					if (_pos + 2 >= len) {
+						return 0; // Need more to tell if this is a long string
+					}
+
+					_quote = c;
+					_long  = buf[_pos + 1] == c && buf[_pos + 2] == c;
+					_pos += _long ? 2 : 0;
+					_state = State::STRING;
+				} else if (c == '[' || c == '(') {
+					++_depth;
+				} else if ((c == ']' || c == ')') && _depth > 0) {
+					--_depth;
+				} else if (c == '.' && _depth == 0) {
+					if (_pos + 1 >= len) {
+						return 0; // Need more to tell if this ends a statement
+					}
+
+					const char n = buf[_pos + 1];
+					if (!n || n == ' ' || n == '\t' || n == '\n' || n == '\r' ||
+					    n == '#') {
+						return ++_pos;
+					}
+				}
+				break;
+
+			case State::IRI:
+				if (c == '>') {
+					_state = State::TEXT;
+				}
+				break;
+
+			case State::STRING:
+				if (_escape) {
+					_escape = false;
+				} else if (c == '\\') {
+					_escape = true;
+				} else if (c == _quote) {
+					if (!_long) {
+						_state = State::TEXT;
+					} else if (_pos + 2 >= len) {
+						return 0; // Need more to tell if this ends the string
+					} else if (buf[_pos + 1] == c && buf[_pos + 2] == c) {
+						_pos += 2;
+						_state = State::TEXT;
+					}
+				}
+				break;
+
+			case State::COMMENT:
+				if (c == '\n' || c == '\r') {
+					_state = State::TEXT;
+				}
+				break;
+			}
+		}
+
+		return 0;
+	}
+
+	/** Account for `len` bytes being removed from the start of the input. */
+	void consumed(size_t len) { _pos -= len; }
+
+private:
+	enum class State { TEXT, IRI, STRING, COMMENT };
+
+	size_t   _pos{0};
+	unsigned _depth{0};
+	State    _state{State::TEXT};
+	char     _quote{0};
+	bool     _long{false};
+	bool     _escape{false};
+};
+
+} // namespace ingen::server
+
+#endif // INGEN_ENGINE_TURTLESPLITTER_HPP
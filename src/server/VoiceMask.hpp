@@ -0,0 +1,108 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_VOICEMASK_HPP
+#define INGEN_ENGINE_VOICEMASK_HPP
+
+#include "types.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace ingen::server {
+
+/** Activity of the voices of a polyphonic graph.
+ *
+ * A voice allocator like NoteNode claims the mask every cycle, and keeps the
+ * voices it has assigned to notes active.  Mixers keep released voices active
+ * for as long as they are still audible.  Voices that have been neither for
+ * the release time are inactive, and are skipped by blocks that can run
+ * voices independently.  If no allocator has claimed the mask recently, or
+ * the release time is zero, every voice is active.
+ *
+ * Times are stored in atomics so that they can be updated and read by blocks
+ * running in parallel, which only risks seeing a change a cycle late.
+ *
+ * \ingroup engine
+ */
+class VoiceMask
+{
+public:
+	static constexpr uint32_t max_voices = 128;    ///< Maximum polyphony
+	static constexpr float    silence    = 1.0e-5f; ///< Audible peak level
+
+	explicit VoiceMask(SampleCount release) : _release(release) {}
+
+	/** Claim the mask for an allocator which ran until `time`. */
+	void claim(FrameTime time) {
+		advance(_claimed, time);
+		_has_claim.store(true, std::memory_order_relaxed);
+	}
+
+	/** Keep `voice` active until at least `time` plus the release time. */
+	void touch(uint32_t voice, FrameTime time) {
+		if (voice < max_voices) {
+			advance(_times[voice], time);
+		}
+	}
+
+	/** Return true iff `voice` was not kept active up to `time`. */
+	bool released(uint32_t voice, FrameTime time) const {
+		return voice < max_voices && since(_times[voice], time) > 0;
+	}
+
+	/** Return true iff `voice` must be run in a cycle starting at `start`.
+	 *
+	 * Voices may only be skipped while an allocator holds a live claim, so
+	 * every voice is active if the mask was never claimed or the claim
+	 * expired.
+	 */
+	bool active(uint32_t voice, FrameTime start) const {
+		return !_release || voice >= max_voices ||
+		       !_has_claim.load(std::memory_order_relaxed) ||
+		       expired(_claimed, start) || !expired(_times[voice], start);
+	}
+
+private:
+	using Time  = std::atomic<FrameTime>;
+	using Times = std::array<Time, max_voices>;
+
+	/// Return the frames from `t` until `time`, which wraps around
+	static int32_t since(const Time& t, FrameTime time) {
+		return static_cast<int32_t>(time - t.load(std::memory_order_relaxed));
+	}
+
+	bool expired(const Time& t, FrameTime start) const {
+		return since(t, start) >= static_cast<int32_t>(_release);
+	}
+
+	static void advance(Time& t, FrameTime time) {
+		FrameTime old = t.load(std::memory_order_relaxed);
+		while (static_cast<int32_t>(time - old) > 0 &&
+		       !t.compare_exchange_weak(old, time, std::memory_order_relaxed)) {
+		}
+	}
+
+	const SampleCount _release;          ///< Frames voices run after release
+	Time              _claimed{0};       ///< End of the last allocator cycle
+	std::atomic<bool> _has_claim{false}; ///< True once claimed by an allocator
+	Times             _times{};          ///< Time each voice was last used
+};
+
+} // namespace ingen::server
+
+#endif // INGEN_ENGINE_VOICEMASK_HPP
@@ -29,6 +29,7 @@
 #include <events/Get.hpp>
 #include <events/Mark.hpp>
 #include <events/Move.hpp>
+#include <events/Recompile.hpp>
 #include <events/SetPortValue.hpp>
 #include <events/Undo.hpp>
 
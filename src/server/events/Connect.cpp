@@ -147,8 +147,8 @@ Connect::pre_process(PreProcessContext& ctx)
 
 	if (!_head->is_driver_port()) {
 		BufferFactory& bufs = *_engine.buffer_factory();
-		_voices = bufs.maid().make_managed<PortImpl::Voices>(_head->poly());
-		_head->pre_get_buffers(bufs, _voices, _head->poly());
+		_voices = bufs.maid().make_managed<PortImpl::Voices>(_head->prepared_poly());
+		_head->pre_get_buffers(bufs, _voices, _head->prepared_poly());
 	}
 
 	tail_output->inherit_neighbour(_head, _tail_remove, _tail_add);
@@ -166,6 +166,7 @@ Connect::execute(RunContext& ctx)
 			_head->set_voices(ctx, std::move(_voices));
 		}
 		_head->connect_buffers();
+		_head->resend_values();
 		if (_compiled_graph) {
 			_compiled_graph = _graph->swap_compiled_graph(std::move(_compiled_graph));
 		}
@@ -197,9 +197,18 @@ Copy::filesystem_to_engine(PreProcessContext&)
 		dst_symbol = raul::Symbol(dst_path.symbol());
 	}
 
+	// Load in a bundle so that blocks can be created in parallel
+	const std::shared_ptr<Interface>& iface = _engine.world().interface();
+	if (_engine.block_loader()) {
+		iface->bundle_begin();
+	}
+
 	_engine.world().parser()->parse_file(
-		_engine.world(), *_engine.world().interface(), src_path,
-		dst_parent, dst_symbol);
+		_engine.world(), *iface, src_path, dst_parent, dst_symbol);
+
+	if (_engine.block_loader()) {
+		iface->bundle_end();
+	}
 
 	return Event::pre_process_done(Status::SUCCESS);
 }
@@ -18,6 +18,7 @@
 
 #include "BlockFactory.hpp"
 #include "BlockImpl.hpp"
+#include "BlockLoader.hpp"
 #include "Broadcaster.hpp"
 #include "CompiledGraph.hpp"
 #include "Engine.hpp"
@@ -37,6 +38,8 @@
 #include <ingen/Status.hpp>
 #include <ingen/Store.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/URIDProperties.hpp>
+#include <ingen/URIMap.hpp>
 #include <ingen/URIs.hpp>
 #include <ingen/World.hpp>
 #include <ingen/paths.hpp>
@@ -45,6 +48,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 
@@ -55,10 +59,11 @@ CreateBlock::CreateBlock(Engine&                           engine,
                          int32_t                           id,
                          SampleCount                       timestamp,
                          raul::Path                        path,
-                         Properties&                       properties)
+                         URIDProperties&                   properties)
     : Event(engine, client, id, timestamp)
     , _path(std::move(path))
     , _properties(properties)
+    , _update(engine.world().uri_map())
 {}
 
 CreateBlock::~CreateBlock() = default;
@@ -66,8 +71,13 @@ CreateBlock::~CreateBlock() = default;
 bool
 CreateBlock::pre_process(PreProcessContext& ctx)
 {
-	const ingen::URIs&           uris  = _engine.world().uris();
-	const std::shared_ptr<Store> store = _engine.store();
+	const ingen::URIs&           uris   = _engine.world().uris();
+	const std::shared_ptr<Store> store  = _engine.store();
+	const auto&                  loader = _engine.block_loader();
+
+	// Take block if it was created in the background, see PreProcessor
+	std::unique_ptr<BlockImpl> prepared{loader ? loader->take(_path)
+	                                           : nullptr};
 
 	// Check sanity of target path
 	if (_path.is_root()) {
@@ -83,13 +93,12 @@ CreateBlock::pre_process(PreProcessContext& ctx)
 	}
 
 	// Map old ingen:prototype to new lv2:prototype
-	const auto range = _properties.equal_range(uris.ingen_prototype);
-	for (auto i = range.first; i != range.second;) {
+	for (auto i = _properties.find(uris.ingen_prototype);
+	     i != _properties.end();
+	     i = _properties.find(uris.ingen_prototype)) {
 		const auto value = i->second;
-		auto       next  = i;
-		next = _properties.erase(i);
+		_properties.erase(i);
 		_properties.emplace(uris.lv2_prototype, value);
-		i = next;
 	}
 
 	// Get prototype
@@ -135,27 +144,39 @@ CreateBlock::pre_process(PreProcessContext& ctx)
 			return Event::pre_process_done(Status::PROTOTYPE_NOT_FOUND, prototype);
 		}
 
-		// Load state from directory if given in properties
-		StatePtr state{};
-		auto s = _properties.find(uris.state_state);
-		if (s != _properties.end() && s->second.type() == uris.forge.Path) {
-			state = LV2Block::load_state(
-				_engine.world(), FilePath(s->second.ptr<char>()));
-		}
-
-		// Instantiate plugin
-		if (!(_block = plugin->instantiate(*_engine.buffer_factory(),
-		                                   raul::Symbol(_path.symbol()),
-		                                   polyphonic,
-		                                   _graph,
-		                                   _engine,
-		                                   state.get()))) {
-			return Event::pre_process_done(Status::CREATION_FAILED, _path);
+		if (prepared && prepared->parent_graph() == _graph &&
+		    prepared->plugin_impl() == plugin) {
+			// Use block that was instantiated in the background
+			_block = prepared.release();
+		} else {
+			// Load state from directory if given in properties
+			StatePtr state{};
+			auto s = _properties.find(uris.state_state);
+			if (s != _properties.end() && s->second.type() == uris.forge.Path) {
+				const std::lock_guard<std::mutex> lock{
+					_engine.block_factory()->lilv_mutex()};
+
+				state = LV2Block::load_state(
+					_engine.world(), FilePath(s->second.ptr<char>()));
+			}
+
+			// Instantiate plugin
+			if (!(_block = plugin->instantiate(*_engine.buffer_factory(),
+			                                   raul::Symbol(_path.symbol()),
+			                                   polyphonic,
+			                                   _graph,
+			                                   _engine,
+			                                   state.get()))) {
+				return Event::pre_process_done(Status::CREATION_FAILED, _path);
+			}
 		}
 	}
 
 	// Activate block
-	_block->properties().insert(_properties.begin(), _properties.end());
+	const URIMap& map = _engine.world().uri_map();
+	for (const auto& p : _properties) {
+		_block->properties().emplace(URI(map.unmap_uri(p.first)), p.second);
+	}
 	_block->activate(*_engine.buffer_factory());
 
 	// Add block to the store and the graph's pre-processor only block list
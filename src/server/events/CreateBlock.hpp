@@ -29,7 +29,7 @@
 namespace ingen {
 
 class Interface;
-class Properties;
+class URIDProperties;
 
 namespace server {
 
@@ -52,7 +52,7 @@ public:
 	            int32_t                           id,
 	            SampleCount                       timestamp,
 	            raul::Path                        path,
-	            Properties&                       properties);
+	            URIDProperties&                   properties);
 
 	~CreateBlock() override;
 
@@ -63,7 +63,7 @@ public:
 
 private:
 	raul::Path                       _path;
-	Properties&                      _properties;
+	URIDProperties&                  _properties;
 	ClientUpdate                     _update;
 	GraphImpl*                       _graph{nullptr};
 	BlockImpl*                       _block{nullptr};
@@ -33,6 +33,8 @@
 #include <ingen/Status.hpp>
 #include <ingen/Store.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/URIDProperties.hpp>
+#include <ingen/URIMap.hpp>
 #include <ingen/URIs.hpp>
 #include <ingen/World.hpp>
 #include <ingen/paths.hpp>
@@ -53,10 +55,11 @@ CreateGraph::CreateGraph(Engine&                           engine,
                          int32_t                           id,
                          SampleCount                       timestamp,
                          raul::Path                        path,
-                         Properties                        properties)
+                         URIDProperties                    properties)
     : Event(engine, client, id, timestamp)
     , _path(std::move(path))
     , _properties(std::move(properties))
+    , _update(engine.world().uri_map())
 {}
 
 CreateGraph::~CreateGraph() = default;
@@ -67,7 +70,7 @@ CreateGraph::build_child_events()
 	const ingen::URIs& uris = _engine.world().uris();
 
 	// Properties common to both ports
-	Properties control_properties;
+	URIDProperties control_properties;
 	control_properties.put(uris.atom_bufferType, uris.atom_Sequence);
 	control_properties.put(uris.atom_supports, uris.patch_Message);
 	control_properties.put(uris.lv2_designation, uris.lv2_control);
@@ -76,7 +79,7 @@ CreateGraph::build_child_events()
 	control_properties.put(uris.rsz_minimumSize, uris.forge.make(4096));
 
 	// Add control port (message receive)
-	Properties in_properties(control_properties);
+	URIDProperties in_properties(control_properties);
 	in_properties.put(uris.lv2_index, uris.forge.make(0));
 	in_properties.put(uris.lv2_name, uris.forge.alloc("Control"));
 	in_properties.put(uris.rdf_type, uris.lv2_InputPort);
@@ -96,7 +99,7 @@ CreateGraph::build_child_events()
 	    in_properties));
 
 	// Add notify port (message respond)
-	Properties out_properties(control_properties);
+	URIDProperties out_properties(control_properties);
 	out_properties.put(uris.lv2_index, uris.forge.make(1));
 	out_properties.put(uris.lv2_name, uris.forge.alloc("Notify"));
 	out_properties.put(uris.rdf_type, uris.lv2_OutputPort);
@@ -185,7 +188,8 @@ CreateGraph::pre_process(PreProcessContext& ctx)
 		                              Resource::Graph::EXTERNAL));
 	}
 
-	_graph->set_properties(_properties);
+	_graph->set_properties(
+	    _properties.to_properties(_engine.world().uri_map()));
 
 	if (_parent) {
 		// Add graph to parent
@@ -21,7 +21,7 @@
 #include "Event.hpp"
 #include "types.hpp"
 
-#include <ingen/Properties.hpp>
+#include <ingen/URIDProperties.hpp>
 #include <raul/Path.hpp>
 
 #include <cstdint>
@@ -52,7 +52,7 @@ public:
 	            int32_t                           id,
 	            SampleCount                       timestamp,
 	            raul::Path                        path,
-	            Properties                        properties);
+	            URIDProperties                    properties);
 
 	~CreateGraph() override;
 
@@ -67,7 +67,7 @@ private:
 	void build_child_events();
 
 	const raul::Path                  _path;
-	Properties                        _properties;
+	URIDProperties                    _properties;
 	ClientUpdate                      _update;
 	GraphImpl*                        _graph{nullptr};
 	GraphImpl*                        _parent{nullptr};
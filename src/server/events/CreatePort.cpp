@@ -33,6 +33,7 @@
 #include <ingen/Status.hpp>
 #include <ingen/Store.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/URIDProperties.hpp>
 #include <ingen/URIMap.hpp>
 #include <ingen/URIs.hpp>
 #include <ingen/World.hpp>
@@ -55,7 +56,7 @@ CreatePort::CreatePort(Engine&                           engine,
                        int32_t                           id,
                        SampleCount                       timestamp,
                        raul::Path                        path,
-                       const Properties&                 properties)
+                       const URIDProperties&             properties)
     : Event(engine, client, id, timestamp)
     , _path(std::move(path))
     , _properties(properties)
@@ -162,7 +163,12 @@ CreatePort::pre_process(PreProcessContext&)
 	                             value, _flow == Flow::OUTPUT);
 	assert((_flow == Flow::OUTPUT && _graph_port->is_output()) ||
 	       (_flow == Flow::INPUT && _graph_port->is_input()));
-	_graph_port->properties().insert(_properties.begin(), _properties.end());
+
+	const URIMap& map = _engine.world().uri_map();
+	for (const auto& p : _properties) {
+		_graph_port->properties().emplace(URI(map.unmap_uri(p.first)),
+		                                  p.second);
+	}
 
 	_engine.store()->add(_graph_port);
 	if (_flow == Flow::OUTPUT) {
@@ -23,6 +23,7 @@
 #include "types.hpp"
 
 #include <ingen/Properties.hpp>
+#include <ingen/URIDProperties.hpp>
 #include <lv2/urid/urid.h>
 #include <raul/Maid.hpp>
 #include <raul/Path.hpp>
@@ -56,7 +57,7 @@ public:
 	           int32_t                           id,
 	           SampleCount                       timestamp,
 	           raul::Path                        path,
-	           const Properties&                 properties);
+	           const URIDProperties&             properties);
 
 	bool pre_process(PreProcessContext& ctx) override;
 	void execute(RunContext& ctx) override;
@@ -76,7 +77,7 @@ private:
 	DuplexPort*                         _graph_port{nullptr};
 	raul::managed_ptr<BlockImpl::Ports> _ports_array; ///< New external port array for Graph
 	EnginePort*                         _engine_port{nullptr}; ///< Driver port if on the root
-	Properties                          _properties;
+	URIDProperties                      _properties;
 	Properties                          _update;
 	std::optional<Flow>                 _flow;
 };
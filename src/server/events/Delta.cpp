@@ -18,6 +18,7 @@
 
 #include "BlockFactory.hpp"
 #include "BlockImpl.hpp"
+#include "BlockLoader.hpp"
 #include "Broadcaster.hpp"
 #include "CompiledGraph.hpp"
 #include "ControlBindings.hpp"
@@ -30,6 +31,7 @@
 #include "PluginImpl.hpp"
 #include "PortImpl.hpp"
 #include "PortType.hpp"
+#include "PreProcessContext.hpp"
 #include "SetPortValue.hpp"
 
 #include <ingen/Atom.hpp>
@@ -44,12 +46,15 @@
 #include <ingen/Status.hpp>
 #include <ingen/Store.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/URIDProperties.hpp>
+#include <ingen/URIMap.hpp>
 #include <ingen/URIs.hpp>
 #include <ingen/World.hpp>
 #include <ingen/paths.hpp>
 #include <lilv/lilv.h>
 #include <raul/Path.hpp>
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -66,7 +71,8 @@ Delta::Delta(Engine&                           engine,
              const ingen::Put&                 msg)
 	: Event(engine, client, msg.seq, timestamp)
 	, _subject(msg.uri)
-	, _properties(msg.properties)
+	, _properties(engine.world().uri_map(), msg.properties)
+	, _update(engine.world().uri_map())
 	, _context(msg.ctx)
 	, _type(Type::PUT)
 {
@@ -80,8 +86,9 @@ Delta::Delta(Engine&                           engine,
 	: Event(engine, client, msg.seq, timestamp)
 	, _create_event(nullptr)
 	, _subject(msg.uri)
-	, _properties(msg.add)
-	, _remove(msg.remove)
+	, _properties(engine.world().uri_map(), msg.add)
+	, _remove(engine.world().uri_map(), msg.remove)
+	, _update(engine.world().uri_map())
 	, _context(msg.ctx)
 	, _type(Type::PATCH)
 {
@@ -94,7 +101,9 @@ Delta::Delta(Engine&                           engine,
              const ingen::SetProperty&         msg)
 	: Event(engine, client, msg.seq, timestamp)
 	, _subject(msg.subject)
-	, _properties{{msg.predicate, msg.value}}
+	, _properties{{engine.world().uri_map().map_uri(msg.predicate.c_str()),
+	               msg.value}}
+	, _update(engine.world().uri_map())
 	, _context(msg.ctx)
 	, _type(Type::SET)
 {
@@ -110,10 +119,21 @@ Delta::init()
 		}
 	}
 
-	// Set atomic execution if polyphony is to be changed
+	// Set atomic execution if a block is to be made (non-)polyphonic
 	const ingen::URIs& uris = _engine.world().uris();
-	if (_properties.count(uris.ingen_polyphonic) ||
-	    _properties.count(uris.ingen_polyphony)) {
+	if (_properties.count(uris.ingen_polyphonic)) {
+		_block = true;
+	}
+}
+
+void
+Delta::mark(PreProcessContext& ctx)
+{
+	/* Internal polyphony changes are staged, so they don't need to block
+	   pre-processing.  A bundle may change the same graph several times
+	   before any change is applied though, so use atomic execution there. */
+	const ingen::URIs& uris = _engine.world().uris();
+	if (ctx.in_bundle() && _properties.count(uris.ingen_polyphony)) {
 		_block = true;
 	}
 }
@@ -147,6 +167,13 @@ s_add_set_event(const char* port_symbol,
 	static_cast<Delta*>(user_data)->add_set_event(port_symbol, value, size, type);
 }
 
+/** Time to wait for a previous polyphony change to be applied.
+ *
+ * Changes only have to wait when they arrive faster than the audio thread
+ * applies them, so this is only reached if the audio thread is not running.
+ */
+static constexpr std::chrono::milliseconds poly_timeout{1000};
+
 static LilvNode*
 get_file_node(LilvWorld* lworld, const URIs& uris, const Atom& value)
 {
@@ -164,6 +191,75 @@ get_file_node(LilvWorld* lworld, const URIs& uris, const Atom& value)
 	return nullptr;
 }
 
+bool
+Delta::prefetch(BlockLoader& loader)
+{
+	if (_type != Type::PUT || !uri_is_path(_subject)) {
+		return false;
+	}
+
+	const ingen::URIs&                  uris  = _engine.world().uris();
+	const std::shared_ptr<Store>        store = _engine.store();
+	const std::lock_guard<Store::Mutex> lock{store->mutex()};
+
+	const raul::Path path{uri_to_path(_subject)};
+	if (store->get(path)) {
+		return false;
+	}
+
+	bool is_graph  = false;
+	bool is_block  = false;
+	bool is_port   = false;
+	bool is_output = false;
+	ingen::Resource::type(uris, _properties, is_graph, is_block, is_port, is_output);
+	if (is_graph) {
+		return false; // Later blocks may be in this graph
+	}
+
+	if (!is_block) {
+		return true;
+	}
+
+	auto* const parent = dynamic_cast<GraphImpl*>(store->get(path.parent()));
+	if (!parent) {
+		return false;
+	}
+
+	// Find plugin prototype, blocks duplicated from others can not be prefetched
+	auto p = _properties.find(uris.lv2_prototype);
+	if (p == _properties.end()) {
+		p = _properties.find(uris.ingen_prototype);
+	}
+
+	if (p == _properties.end() || !uris.forge.is_uri(p->second)) {
+		return true;
+	}
+
+	const URI prototype(uris.forge.str(p->second, false));
+	if (uri_is_path(prototype)) {
+		return false;
+	}
+
+	PluginImpl* const plugin = _engine.block_factory()->plugin(prototype);
+	if (!plugin) {
+		return true;
+	}
+
+	const auto poly       = _properties.find(uris.ingen_polyphonic);
+	const bool polyphonic = (poly != _properties.end() &&
+	                         poly->second.type() == uris.forge.Bool &&
+	                         poly->second.get<int32_t>());
+
+	FilePath   state_path;
+	const auto s = _properties.find(uris.state_state);
+	if (s != _properties.end() && s->second.type() == uris.forge.Path) {
+		state_path = FilePath(s->second.ptr<char>());
+	}
+
+	loader.start(path, *plugin, polyphonic, *parent, state_path);
+	return true;
+}
+
 bool
 Delta::pre_process(PreProcessContext& ctx)
 {
@@ -203,7 +299,9 @@ Delta::pre_process(PreProcessContext& ctx)
 			return Event::pre_process_done(Status::BAD_OBJECT_TYPE, prot);
 		}
 
-		if ((_preset = block->save_preset(_subject, _properties))) {
+		const Properties props =
+			_properties.to_properties(_engine.world().uri_map());
+		if ((_preset = block->save_preset(_subject, props))) {
 			return Event::pre_process_done(Status::SUCCESS);
 		}
 
@@ -256,10 +354,13 @@ Delta::pre_process(PreProcessContext& ctx)
 
 	auto* obj = dynamic_cast<NodeImpl*>(_object);
 
+	// Resources are keyed by URI, so keys are unmapped to apply properties
+	const URIMap& map = _engine.world().uri_map();
+
 	// Remove any properties removed in delta
 	for (const auto& r : _remove) {
-		const URI&  key   = r.first;
-		const Atom& value = r.second;
+		const LV2_URID key   = r.first;
+		const Atom&    value = r.second;
 		if (key == uris.midi_binding && value == uris.patch_wildcard) {
 			auto* port = dynamic_cast<PortImpl*>(_object);
 			if (port) {
@@ -268,7 +369,7 @@ Delta::pre_process(PreProcessContext& ctx)
 		}
 		if (_object) {
 			_removed.emplace(key, value);
-			_object->remove_property(key, value);
+			_object->remove_property(URI(map.unmap_uri(key)), value);
 		} else if (is_engine && key == uris.ingen_loadedBundle) {
  			LilvWorld* lworld = _engine.world().lilv_world();
 			LilvNode*  bundle = get_file_node(lworld, uris, value);
@@ -293,16 +394,17 @@ Delta::pre_process(PreProcessContext& ctx)
 		for (auto p = _properties.begin();
 		     p != _properties.end();
 		     p = _properties.upper_bound(p->first)) {
-			for (auto q = _object->properties().find(p->first);
-			     q != _object->properties().end() && q->first == p->first;) {
+			const URI key(map.unmap_uri(p->first));
+			for (auto q = _object->properties().find(key);
+			     q != _object->properties().end() && q->first == key;) {
 				auto next = q;
 				++next;
 
-				if (!_properties.contains(q->first, q->second)) {
-					const auto r = std::make_pair(q->first, q->second);
+				if (!_properties.contains(p->first, q->second)) {
+					const Property value = q->second;
 					_object->properties().erase(q);
-					_object->on_property_removed(r.first, r.second);
-					_removed.insert(r);
+					_object->on_property_removed(key, value);
+					_removed.emplace(p->first, value);
 				}
 
 				q = next;
@@ -311,13 +413,14 @@ Delta::pre_process(PreProcessContext& ctx)
 	}
 
 	for (const auto& p : _properties) {
-		const URI&      key   = p.first;
+		const LV2_URID  key   = p.first;
 		const Property& value = p.second;
 		SpecialType     op    = SpecialType::NONE;
 		if (obj) {
+			const URI key_uri(map.unmap_uri(key));
 			if (value != uris.patch_wildcard) {
 				Resource& resource = *obj;
-				if (resource.add_property(key, value, value.context())) {
+				if (resource.add_property(key_uri, value, value.context())) {
 					_added.emplace(key, value);
 				}
 			}
@@ -351,7 +454,7 @@ Delta::pre_process(PreProcessContext& ctx)
 					}
 				} else if (key == uris.lv2_index) {
 					op = SpecialType::PORT_INDEX;
-					port->set_property(key, value);
+					port->set_property(key_uri, value);
 				}
 			} else if ((block = dynamic_cast<BlockImpl*>(_object))) {
 				if (key == uris.midi_binding && value == uris.patch_wildcard) {
@@ -406,9 +509,8 @@ Delta::pre_process(PreProcessContext& ctx)
 						if (value.get<int32_t>() < 1 || value.get<int32_t>() > 128) {
 							_status = Status::INVALID_POLY;
 						} else {
-							op = SpecialType::POLYPHONY;
-							_graph->prepare_internal_poly(
-								*_engine.buffer_factory(), value.get<int32_t>());
+							op    = SpecialType::POLYPHONY;
+							_poly = value.get<int32_t>();
 						}
 					} else {
 						_status = Status::BAD_VALUE_TYPE;
@@ -422,9 +524,11 @@ Delta::pre_process(PreProcessContext& ctx)
 					_status = Status::BAD_OBJECT_TYPE;
 				} else if (value.type() != uris.forge.Bool) {
 					_status = Status::BAD_VALUE_TYPE;
+				} else if (!parent->wait_for_internal_poly(poly_timeout)) {
+					_status = Status::FAILURE;
 				} else {
 					op = SpecialType::POLYPHONIC;
-					obj->set_property(key, value, value.context());
+					obj->set_property(key_uri, value, value.context());
 					if (block) {
 						block->set_polyphonic(value.get<int32_t>());
 					}
@@ -463,6 +567,15 @@ Delta::pre_process(PreProcessContext& ctx)
 		_types.push_back(op);
 	}
 
+	if (_poly && _status == Status::NOT_PREPARED) {
+		// Allocate everything for the new polyphony now, execute just swaps
+		if (_graph->wait_for_internal_poly(poly_timeout)) {
+			_graph->prepare_internal_poly(*_engine.buffer_factory(), _poly);
+		} else {
+			_status = Status::FAILURE;
+		}
+	}
+
 	for (auto& s : _set_events) {
 		s->pre_process(ctx);
 	}
@@ -501,8 +614,8 @@ Delta::execute(RunContext& ctx)
 
 	auto t = _types.begin();
 	for (const auto& p : _properties) {
-		const URI&  key   = p.first;
-		const Atom& value = p.second;
+		const LV2_URID key   = p.first;
+		const Atom&    value = p.second;
 		switch (*t++) {
 		case SpecialType::ENABLE_BROADCAST:
 			if (port) {
@@ -607,6 +720,8 @@ Delta::post_process()
 	}
 
 	if (respond() == Status::SUCCESS) {
+		const URIMap& map = _engine.world().uri_map();
+
 		_update.send(*_engine.broadcaster());
 
 		switch (_type) {
@@ -619,7 +734,7 @@ Delta::post_process()
 			}
 			_engine.broadcaster()->set_property(
 				_subject,
-				_properties.begin()->first,
+				URI(map.unmap_uri(_properties.begin()->first)),
 				_properties.begin()->second);
 			if (_mode == Mode::NORMAL) {
 				_engine.broadcaster()->clear_ignore_client();
@@ -628,16 +743,20 @@ Delta::post_process()
 		case Type::PUT:
 			if (_type == Type::PUT && _subject.scheme() == "file") {
 				// Preset save
-				ClientUpdate response;
+				ClientUpdate response{_engine.world().uri_map()};
 				response.put(_preset->uri(), _preset->properties());
 				response.send(*_engine.broadcaster());
 			} else {
 				// Graph object put
-				_engine.broadcaster()->put(_subject, _properties, _context);
+				_engine.broadcaster()->put(
+					_subject, _properties.to_properties(map), _context);
 			}
 			break;
 		case Type::PATCH:
-			_engine.broadcaster()->delta(_subject, _remove, _properties, _context);
+			_engine.broadcaster()->delta(_subject,
+			                             _remove.to_properties(map),
+			                             _properties.to_properties(map),
+			                             _context);
 			break;
 		}
 	}
@@ -646,20 +765,25 @@ Delta::post_process()
 void
 Delta::undo(Interface& target)
 {
+	const URIMap& map = _engine.world().uri_map();
+
 	if (_create_event) {
 		_create_event->undo(target);
 	} else if (_type == Type::PATCH) {
-		target.delta(_subject, _added, _removed, _context);
+		target.delta(_subject,
+		             _added.to_properties(map),
+		             _removed.to_properties(map),
+		             _context);
 	} else if (_type == Type::SET || _type == Type::PUT) {
 		if (_removed.size() == 1) {
 			target.set_property(_subject,
-			                    _removed.begin()->first,
+			                    URI(map.unmap_uri(_removed.begin()->first)),
 			                    _removed.begin()->second,
 			                    _context);
 		} else if (_removed.empty()) {
-			target.delta(_subject, _added, {}, _context);
+			target.delta(_subject, _added.to_properties(map), {}, _context);
 		} else {
-			target.put(_subject, _removed, _context);
+			target.put(_subject, _removed.to_properties(map), _context);
 		}
 	}
 }
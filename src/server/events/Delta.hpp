@@ -25,9 +25,9 @@
 #include "State.hpp"
 #include "types.hpp"
 
-#include <ingen/Properties.hpp>
 #include <ingen/Resource.hpp>
 #include <ingen/URI.hpp>
+#include <ingen/URIDProperties.hpp>
 
 #include <cstdint>
 #include <memory>
@@ -76,6 +76,8 @@ public:
 	                   uint32_t    size,
 	                   uint32_t    type);
 
+	void mark(PreProcessContext& ctx) override;
+	bool prefetch(BlockLoader& loader) override;
 	bool pre_process(PreProcessContext& ctx) override;
 	void execute(RunContext& ctx) override;
 	void post_process() override;
@@ -107,8 +109,8 @@ private:
 	std::vector<SpecialType>         _types;
 	std::vector<SpecialType>         _remove_types;
 	URI                              _subject;
-	Properties                       _properties;
-	Properties                       _remove;
+	URIDProperties                   _properties;
+	URIDProperties                   _remove;
 	ClientUpdate                     _update;
 	ingen::Resource*                 _object{nullptr};
 	GraphImpl*                       _graph{nullptr};
@@ -118,14 +120,15 @@ private:
 	Resource::Graph                  _context;
 	Type                             _type;
 
-	Properties _added;
-	Properties _removed;
+	URIDProperties _added;
+	URIDProperties _removed;
 
 	std::vector<ControlBindings::Binding*> _removed_bindings;
 
 	std::optional<Resource> _preset;
 
-	bool _block{false};
+	uint32_t _poly{0}; ///< New internal polyphony of _graph, or zero
+	bool     _block{false};
 };
 
 } // namespace events
@@ -95,8 +95,8 @@ Disconnect::Impl::Impl(Engine&     e,
 	if (_head->num_arcs() == 0) {
 		if (!_head->is_driver_port()) {
 			BufferFactory& bufs = *_engine.buffer_factory();
-			_voices = bufs.maid().make_managed<PortImpl::Voices>(_head->poly());
-			_head->pre_get_buffers(bufs, _voices, _head->poly());
+			_voices = bufs.maid().make_managed<PortImpl::Voices>(_head->prepared_poly());
+			_head->pre_get_buffers(bufs, _voices, _head->prepared_poly());
 
 			if (_head->is_a(PortType::CONTROL) ||
 			    _head->is_a(PortType::CV)) {
@@ -196,6 +196,7 @@ Disconnect::Impl::execute(RunContext& ctx, bool set_head_buffers)
 			_head->setup_buffers(ctx, *_engine.buffer_factory(), _head->poly());
 		}
 		_head->connect_buffers();
+		_head->resend_values();
 	} else {
 		_head->recycle_buffers();
 	}
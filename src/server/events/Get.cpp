@@ -47,6 +47,7 @@ Get::Get(Engine&                           engine,
          const ingen::Get&                 msg)
 	: Event(engine, client, msg.seq, timestamp)
 	, _msg(msg)
+	, _response(engine.world().uri_map())
 {}
 
 bool
@@ -78,6 +79,12 @@ Get::pre_process(PreProcessContext&)
 			} else {
 				return Event::pre_process_done(Status::BAD_OBJECT_TYPE, uri);
 			}
+
+			const BlockImpl* const profiled = graph ? graph : block;
+			if (profiled && _engine.profiling()) {
+				_response.put(profiled->uri(), profiled->profile_properties());
+			}
+
 			return Event::pre_process_done(Status::SUCCESS);
 		}
 		return Event::pre_process_done(Status::NOT_FOUND, uri);
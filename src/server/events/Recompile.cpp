@@ -0,0 +1,70 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Recompile.hpp"
+
+#include "CompiledGraph.hpp"
+#include "Engine.hpp"
+#include "GraphImpl.hpp"
+#include "PreProcessContext.hpp"
+
+#include <ingen/Status.hpp>
+#include <ingen/Store.hpp>
+#include <raul/Path.hpp>
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace ingen::server::events {
+
+Recompile::Recompile(Engine& engine, raul::Path graph_path)
+	: Event(engine)
+	, _graph_path(std::move(graph_path))
+{}
+
+Recompile::~Recompile() = default;
+
+bool
+Recompile::pre_process(PreProcessContext& ctx)
+{
+	const std::lock_guard<Store::Mutex> lock{_engine.store()->mutex()};
+
+	// The graph may have been deleted since this event was queued
+	_graph = dynamic_cast<GraphImpl*>(_engine.store()->get(_graph_path));
+	if (!_graph) {
+		return Event::pre_process_done(Status::NOT_FOUND, _graph_path);
+	}
+
+	_graph->set_recompile_pending(false);
+	_compiled_graph = ctx.maybe_compile(*_graph, true);
+
+	return Event::pre_process_done(Status::SUCCESS);
+}
+
+void
+Recompile::execute(RunContext&)
+{
+	if (_compiled_graph) {
+		_compiled_graph = _graph->swap_compiled_graph(std::move(_compiled_graph));
+	}
+}
+
+void
+Recompile::post_process()
+{}
+
+} // namespace ingen::server::events
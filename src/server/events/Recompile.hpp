@@ -0,0 +1,65 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_EVENTS_RECOMPILE_HPP
+#define INGEN_EVENTS_RECOMPILE_HPP
+
+#include "CompiledGraph.hpp"
+#include "Event.hpp"
+
+#include <raul/Path.hpp>
+
+#include <memory>
+
+namespace ingen::server {
+
+class Engine;
+class GraphImpl;
+class PreProcessContext;
+class RunContext;
+
+namespace events {
+
+/** Fully recompile a graph to improve its schedule.
+ *
+ * This is an internal event which is not triggered by any client, but by the
+ * pre-processor when the measured costs of blocks have drifted significantly
+ * from those used to compile the graph, or the graph was last compiled
+ * incrementally.
+ *
+ * \ingroup engine
+ */
+class Recompile : public Event
+{
+public:
+	Recompile(Engine& engine, raul::Path graph_path);
+
+	~Recompile() override;
+
+	bool pre_process(PreProcessContext& ctx) override;
+	void execute(RunContext& ctx) override;
+	void post_process() override;
+
+private:
+	raul::Path                     _graph_path;
+	GraphImpl*                     _graph{nullptr};
+	std::unique_ptr<CompiledGraph> _compiled_graph;
+};
+
+} // namespace events
+} // namespace ingen::server
+
+#endif // INGEN_EVENTS_RECOMPILE_HPP
@@ -64,6 +64,7 @@ SetPortValue::pre_process(PreProcessContext&)
 		// Set value metadata (does not affect buffers)
 		_port->set_value(_value);
 		_port->set_property(_engine.world().uris().ingen_value, _value);
+		_port->set_value_time(_time);
 	}
 
 	_binding = _engine.control_bindings()->port_binding(_port);
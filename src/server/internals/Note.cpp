@@ -19,11 +19,13 @@
 #include "BlockImpl.hpp"
 #include "Buffer.hpp"
 #include "BufferFactory.hpp"
+#include "GraphImpl.hpp"
 #include "InputPort.hpp"
 #include "InternalPlugin.hpp"
 #include "OutputPort.hpp"
 #include "PortType.hpp"
 #include "RunContext.hpp"
+#include "VoiceMask.hpp"
 
 #include <ingen/Atom.hpp>
 #include <ingen/Forge.hpp>
@@ -229,6 +231,17 @@ NoteNode::run(RunContext& ctx)
 			}
 		}
 	}
+
+	// Keep voices that are assigned to notes active
+	if (_polyphonic) {
+		VoiceMask& mask = parent_graph()->voice_mask();
+		mask.claim(ctx.end());
+		for (uint32_t i = 0; i < _polyphony; ++i) {
+			if ((*_voices)[i].state != Voice::State::FREE) {
+				mask.touch(i, ctx.end());
+			}
+		}
+	}
 }
 
 static inline float
@@ -374,6 +387,16 @@ NoteNode::free_voice(RunContext& ctx, uint32_t voice, FrameTime time)
 		// No new note for voice, deactivate (set gate low)
 		_gate_port->set_voice_value(ctx, voice, time, 0.0f);
 		(*_voices)[voice].state = Voice::State::FREE;
+		release_voice(voice, time);
+	}
+}
+
+void
+NoteNode::release_voice(uint32_t voice, FrameTime time)
+{
+	// Run the voice for at least the release time after the gate falls
+	if (_polyphonic) {
+		parent_graph()->voice_mask().touch(voice, time);
 	}
 }
 
@@ -386,7 +409,10 @@ NoteNode::all_notes_off(RunContext& ctx, FrameTime time)
 
 	for (uint32_t i = 0; i < _polyphony; ++i) {
 		_gate_port->set_voice_value(ctx, i, time, 0.0f);
-		(*_voices)[i].state = Voice::State::FREE;
+		if ((*_voices)[i].state != Voice::State::FREE) {
+			(*_voices)[i].state = Voice::State::FREE;
+			release_voice(i, time);
+		}
 	}
 }
 
@@ -46,7 +46,9 @@ namespace internals {
 
 /** MIDI note input block.
  *
- * For pitched instruments like keyboard, etc.
+ * For pitched instruments like keyboard, etc.  When polyphonic, this is the
+ * voice allocator of its graph, and keeps the VoiceMask of the graph updated
+ * so that other blocks can skip voices that are not playing.
  *
  * \ingroup engine
  */
@@ -100,6 +102,7 @@ private:
 	using Voices = raul::Array<Voice>;
 
 	void free_voice(RunContext& ctx, uint32_t voice, FrameTime time);
+	void release_voice(uint32_t voice, FrameTime time);
 
 	raul::managed_ptr<Voices> _voices;
 	raul::managed_ptr<Voices> _prepared_voices;
@@ -18,21 +18,74 @@
 
 #include "Buffer.hpp"
 #include "RunContext.hpp"
+#include "SequenceMerger.hpp"
+#include "mix_kernels.hpp"
 #include "types.hpp"
 
 #include <lv2/atom/atom.h>
 #include <lv2/atom/util.h>
 
+#include <cstdint>
+
 namespace ingen::server {
 
-static inline bool
-is_end(const Buffer* buf, const LV2_Atom_Event* ev)
+/// Kernel for mixing audio, selected for this CPU when the engine is loaded
+static const MixAudioKernel mix_audio_kernel = best_mix_audio_kernel().kernel;
+
+static void
+mix_audio(const RunContext&   ctx,
+          Buffer*             dst,
+          const Buffer*const* srcs,
+          uint32_t            num_srcs)
 {
-	const auto* atom = buf->get<const LV2_Atom>();
-	return lv2_atom_sequence_is_end(
-		static_cast<const LV2_Atom_Sequence_Body*>(LV2_ATOM_BODY_CONST(atom)),
-		atom->size,
-		ev);
+	static constexpr uint32_t max_srcs = 32; ///< Sources mixed per pass
+
+	Sample* const  out = dst->samples();
+	const uint32_t end = ctx.nframes();
+
+	// Gather audio sources and sum control sources into a constant
+	const Sample* audio[max_srcs];
+	uint32_t      n_audio = 0;
+	Sample        offset  = 0.0f;
+	for (uint32_t i = 0; i < num_srcs; ++i) {
+		if (srcs[i]->is_control()) { // control => audio
+			offset += srcs[i]->samples()[0];
+		} else if (srcs[i]->is_audio()) { // audio => audio
+			if (n_audio == max_srcs) {
+				// Mix a full batch, then continue accumulating onto the output
+				mix_audio_kernel(out, audio, n_audio, 0.0f, end);
+				audio[0] = out;
+				n_audio  = 1;
+			}
+			audio[n_audio++] = srcs[i]->samples();
+		}
+	}
+
+	// Mix all audio and control sources in a single pass
+	mix_audio_kernel(out, audio, n_audio, offset, end);
+
+	// Add sequence sources
+	for (uint32_t i = 0; i < num_srcs; ++i) {
+		if (srcs[i]->is_sequence()) { // sequence => audio
+			dst->render_sequence(ctx, srcs[i], true);
+		}
+	}
+}
+
+static void
+append_event(Buffer* dst, const LV2_Atom_Event* ev)
+{
+	dst->append_event(
+		ev->time.frames, ev->body.size, ev->body.type,
+		static_cast<const uint8_t*>(LV2_ATOM_BODY_CONST(&ev->body)));
+}
+
+static void
+insert_event(Buffer* dst, const LV2_Atom_Event* ev)
+{
+	dst->insert_event(
+		ev->time.frames, ev->body.size, ev->body.type,
+		static_cast<const uint8_t*>(LV2_ATOM_BODY_CONST(&ev->body)));
 }
 
 void
@@ -41,7 +94,9 @@ mix(const RunContext&   ctx,
     const Buffer*const* srcs,
     uint32_t            num_srcs)
 {
-	if (num_srcs == 1) {
+	if (num_srcs == 0) {
+		dst->clear(); // All sources are inactive voices
+	} else if (num_srcs == 1) {
 		dst->copy(ctx, srcs[0]);
 	} else if (dst->is_control()) {
 		Sample* const out = dst->samples();
@@ -50,61 +105,27 @@ mix(const RunContext&   ctx,
 			out[0] += srcs[i]->value_at(0);
 		}
 	} else if (dst->is_audio()) {
-		// Copy the first source
-		dst->copy(ctx, srcs[0]);
-
-		// Mix in the rest
-		Sample* __restrict const out = dst->samples();
-		const SampleCount        end = ctx.nframes();
-		for (uint32_t i = 1; i < num_srcs; ++i) {
-			const Sample* __restrict const in = srcs[i]->samples();
-			if (srcs[i]->is_control()) { // control => audio
-				for (SampleCount j = 0; j < end; ++j) {
-					out[j] += in[0];
-				}
-			} else if (srcs[i]->is_audio()) { // audio => audio
-				for (SampleCount j = 0; j < end; ++j) {
-					out[j] += in[j];
-				}
-			} else if (srcs[i]->is_sequence()) { // sequence => audio
-				dst->render_sequence(ctx, srcs[i], true);
-			}
-		}
+		mix_audio(ctx, dst, srcs, num_srcs);
 	} else if (dst->is_sequence()) {
-		const LV2_Atom_Event* iters[num_srcs];
-		for (uint32_t i = 0; i < num_srcs; ++i) {
-			iters[i] = nullptr;
-			if (srcs[i]->is_sequence()) {
-				const auto* seq = srcs[i]->get<const LV2_Atom_Sequence>();
-				iters[i] = lv2_atom_sequence_begin(&seq->body);
-				if (is_end(srcs[i], iters[i])) {
-					iters[i] = nullptr;
+		// Merge as many sources as the merger holds at a time, inserting the
+		// events of later batches after those at the same time from earlier
+		SequenceMerger& merger = ctx.sequence_merger();
+		bool            first  = true;
+		for (uint32_t i = 0; i < num_srcs; first = false) {
+			merger.clear();
+			for (; i < num_srcs; ++i) {
+				if (srcs[i]->is_sequence() &&
+				    !merger.add(srcs[i]->get<const LV2_Atom_Sequence>())) {
+					break; // Full, merge this source in the next batch
 				}
 			}
-		}
-
-		while (true) {
-			const LV2_Atom_Event* first   = nullptr;
-			uint32_t              first_i = 0;
-			for (uint32_t i = 0; i < num_srcs; ++i) {
-				const LV2_Atom_Event* const ev = iters[i];
-				if (!first || (ev && ev->time.frames < first->time.frames)) {
-					first   = ev;
-					first_i = i;
-				}
-			}
-
-			if (first) {
-				dst->append_event(
-					first->time.frames, first->body.size, first->body.type,
-					static_cast<const uint8_t*>(LV2_ATOM_BODY_CONST(&first->body)));
 
-				iters[first_i] = lv2_atom_sequence_next(first);
-				if (is_end(srcs[first_i], iters[first_i])) {
-					iters[first_i] = nullptr;
+			while (const LV2_Atom_Event* const ev = merger.next()) {
+				if (first) {
+					append_event(dst, ev);
+				} else {
+					insert_event(dst, ev);
 				}
-			} else {
-				break;
 			}
 		}
 	}
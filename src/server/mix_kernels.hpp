@@ -0,0 +1,249 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_MIX_KERNELS_HPP
+#define INGEN_ENGINE_MIX_KERNELS_HPP
+
+#include "types.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    define INGEN_MIX_X86 1
+#    include <immintrin.h>
+#elif defined(__ARM_NEON)
+#    define INGEN_MIX_NEON 1
+#    include <arm_neon.h>
+#endif
+
+namespace ingen::server {
+
+/** A function that sets `dst` to the sum of audio buffers plus a constant.
+ *
+ * The first source is read before `dst` is written, so `dst` may also be
+ * the first source to accumulate onto it.
+ *
+ * @param dst Destination buffer of at least `n_frames` samples.
+ * @param srcs Source buffers of at least `n_frames` samples.
+ * @param n_srcs Number of source buffers, which may be zero.
+ * @param offset Constant added to every sample (from control sources).
+ * @param n_frames Number of frames to mix.
+ */
+using MixAudioKernel = void (*)(Sample*              dst,
+                                const Sample* const* srcs,
+                                uint32_t             n_srcs,
+                                Sample               offset,
+                                uint32_t             n_frames);
+
+/** A mix kernel with a name for diagnostics and benchmarking. */
+struct MixAudioKernelInfo {
+	const char*    name;
+	MixAudioKernel kernel;
+};
+
+namespace mix_kernels {
+
+/** Portable kernel, also used for the remainder of vectorised kernels. */
+inline void
+scalar_from(Sample*              dst,
+            const Sample* const* srcs,
+            uint32_t             n_srcs,
+            Sample               offset,
+            uint32_t             begin,
+            uint32_t             end)
+{
+	for (uint32_t j = begin; j < end; ++j) {
+		Sample acc = offset;
+		for (uint32_t i = 0; i < n_srcs; ++i) {
+			acc += srcs[i][j];
+		}
+		dst[j] = acc;
+	}
+}
+
+inline void
+scalar(Sample*              dst,
+       const Sample* const* srcs,
+       uint32_t             n_srcs,
+       Sample               offset,
+       uint32_t             n_frames)
+{
+	if (n_srcs == 0) {
+		for (uint32_t j = 0; j < n_frames; ++j) {
+			dst[j] = offset;
+		}
+		return;
+	}
+
+	// Row at a time, which the compiler can vectorise for the baseline ISA.
+	// The first source is read in the same pass that first writes `dst`.
+	const Sample* const first = srcs[0];
+	for (uint32_t j = 0; j < n_frames; ++j) {
+		dst[j] = first[j] + offset;
+	}
+
+	for (uint32_t i = 1; i < n_srcs; ++i) {
+		const Sample* const src = srcs[i];
+		for (uint32_t j = 0; j < n_frames; ++j) {
+			dst[j] += src[j];
+		}
+	}
+}
+
+#ifdef INGEN_MIX_X86
+
+__attribute__((target("sse2"))) inline void
+sse2(Sample*              dst,
+     const Sample* const* srcs,
+     uint32_t             n_srcs,
+     Sample               offset,
+     uint32_t             n_frames)
+{
+	const __m128 off = _mm_set1_ps(offset);
+
+	uint32_t j = 0;
+	for (; j + 8 <= n_frames; j += 8) {
+		__m128 acc0 = off;
+		__m128 acc1 = off;
+		for (uint32_t i = 0; i < n_srcs; ++i) {
+			acc0 = _mm_add_ps(acc0, _mm_loadu_ps(srcs[i] + j));
+			acc1 = _mm_add_ps(acc1, _mm_loadu_ps(srcs[i] + j + 4));
+		}
+		_mm_storeu_ps(dst + j, acc0);
+		_mm_storeu_ps(dst + j + 4, acc1);
+	}
+
+	scalar_from(dst, srcs, n_srcs, offset, j, n_frames);
+}
+
+__attribute__((target("avx2"))) inline void
+avx2(Sample*              dst,
+     const Sample* const* srcs,
+     uint32_t             n_srcs,
+     Sample               offset,
+     uint32_t             n_frames)
+{
+	const __m256 off = _mm256_set1_ps(offset);
+
+	uint32_t j = 0;
+	for (; j + 16 <= n_frames; j += 16) {
+		__m256 acc0 = off;
+		__m256 acc1 = off;
+		for (uint32_t i = 0; i < n_srcs; ++i) {
+			acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(srcs[i] + j));
+			acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(srcs[i] + j + 8));
+		}
+		_mm256_storeu_ps(dst + j, acc0);
+		_mm256_storeu_ps(dst + j + 8, acc1);
+	}
+
+	scalar_from(dst, srcs, n_srcs, offset, j, n_frames);
+}
+
+__attribute__((target("avx512f"))) inline void
+avx512(Sample*              dst,
+       const Sample* const* srcs,
+       uint32_t             n_srcs,
+       Sample               offset,
+       uint32_t             n_frames)
+{
+	const __m512 off = _mm512_set1_ps(offset);
+
+	uint32_t j = 0;
+	for (; j + 32 <= n_frames; j += 32) {
+		__m512 acc0 = off;
+		__m512 acc1 = off;
+		for (uint32_t i = 0; i < n_srcs; ++i) {
+			acc0 = _mm512_add_ps(acc0, _mm512_loadu_ps(srcs[i] + j));
+			acc1 = _mm512_add_ps(acc1, _mm512_loadu_ps(srcs[i] + j + 16));
+		}
+		_mm512_storeu_ps(dst + j, acc0);
+		_mm512_storeu_ps(dst + j + 16, acc1);
+	}
+
+	scalar_from(dst, srcs, n_srcs, offset, j, n_frames);
+}
+
+#elif defined(INGEN_MIX_NEON)
+
+inline void
+neon(Sample*              dst,
+     const Sample* const* srcs,
+     uint32_t             n_srcs,
+     Sample               offset,
+     uint32_t             n_frames)
+{
+	const float32x4_t off = vdupq_n_f32(offset);
+
+	uint32_t j = 0;
+	for (; j + 8 <= n_frames; j += 8) {
+		float32x4_t acc0 = off;
+		float32x4_t acc1 = off;
+		for (uint32_t i = 0; i < n_srcs; ++i) {
+			acc0 = vaddq_f32(acc0, vld1q_f32(srcs[i] + j));
+			acc1 = vaddq_f32(acc1, vld1q_f32(srcs[i] + j + 4));
+		}
+		vst1q_f32(dst + j, acc0);
+		vst1q_f32(dst + j + 4, acc1);
+	}
+
+	scalar_from(dst, srcs, n_srcs, offset, j, n_frames);
+}
+
+#endif
+
+} // namespace mix_kernels
+
+/** Return all mix kernels supported by this CPU, slowest first. */
+inline std::vector<MixAudioKernelInfo>
+supported_mix_audio_kernels()
+{
+	std::vector<MixAudioKernelInfo> kernels{{"scalar", mix_kernels::scalar}};
+
+#ifdef INGEN_MIX_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2")) {
+		kernels.push_back({"sse2", mix_kernels::sse2});
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		kernels.push_back({"avx2", mix_kernels::avx2});
+	}
+	if (__builtin_cpu_supports("avx512f")) {
+		kernels.push_back({"avx512", mix_kernels::avx512});
+	}
+#elif defined(INGEN_MIX_NEON)
+	kernels.push_back({"neon", mix_kernels::neon});
+#endif
+
+	return kernels;
+}
+
+/** Return the fastest mix kernel supported by this CPU.
+ *
+ * The kernel is selected the first time this is called, which should be
+ * before running in a realtime thread.
+ */
+inline const MixAudioKernelInfo&
+best_mix_audio_kernel()
+{
+	static const MixAudioKernelInfo kernel = supported_mix_audio_kernels().back();
+	return kernel;
+}
+
+} // namespace ingen::server
+
+#endif // INGEN_ENGINE_MIX_KERNELS_HPP
@@ -17,7 +17,12 @@
 #ifndef INGEN_ENGINE_UTIL_HPP
 #define INGEN_ENGINE_UTIL_HPP
 
+#include <ingen/Atom.hpp>
 #include <ingen/Log.hpp>
+#include <lv2/urid/urid.h>
+
+#include <cstdint>
+#include <cstring>
 
 #ifdef __SSE__
 #include <xmmintrin.h>
@@ -42,6 +47,18 @@ set_denormal_flags(ingen::Log& log)
 #endif
 }
 
+/** Set an atom to a value, reusing its storage if the size and type match.
+ */
+inline void
+set_atom(Atom& atom, uint32_t size, LV2_URID type, const void* body)
+{
+	if (atom.size() == size && atom.type() == type) {
+		memcpy(atom.get_body(), body, size);
+	} else {
+		atom = Atom(size, type, body);
+	}
+}
+
 } // namespace ingen::server
 
 #endif // INGEN_ENGINE_UTIL_HPP
@@ -0,0 +1,871 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/* Tests that run graphs of test blocks through a real engine.
+ *
+ * The engine is created and run by the test itself, one cycle at a time, so
+ * buffers and blocks can be inspected between cycles.
+ */
+
+#include "BlockFactory.hpp"
+#include "Buffer.hpp"
+#include "BufferFactory.hpp"
+#include "Engine.hpp"
+#include "InputPort.hpp"
+#include "InternalBlock.hpp"
+#include "OutputPort.hpp"
+#include "PluginImpl.hpp"
+#include "PortImpl.hpp"
+#include "PortType.hpp"
+#include "RunContext.hpp"
+#include "mix.hpp"
+#include "types.hpp"
+
+#include <ingen/Atom.hpp>
+#include <ingen/Configuration.hpp>
+#include <ingen/Forge.hpp>
+#include <ingen/Interface.hpp>
+#include <ingen/Node.hpp>
+#include <ingen/Properties.hpp>
+#include <ingen/Store.hpp>
+#include <ingen/URI.hpp>
+#include <ingen/URIs.hpp>
+#include <ingen/World.hpp>
+#include <ingen/paths.hpp>
+#include <lilv/lilv.h>
+#include <lv2/atom/atom.h>
+#include <lv2/atom/util.h>
+#include <raul/Array.hpp>
+#include <raul/Maid.hpp>
+#include <raul/Path.hpp>
+#include <raul/Symbol.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ingen::test {
+namespace {
+
+using server::BlockImpl;
+using server::Buffer;
+using server::BufferFactory;
+using server::BufferRef;
+using server::GraphImpl;
+using server::InputPort;
+using server::InternalBlock;
+using server::OutputPort;
+using server::PluginImpl;
+using server::PortImpl;
+using server::RunContext;
+
+#define NS_TEST "http://drobilla.net/ns/ingen-test#"
+
+constexpr uint32_t block_length = 256U;
+
+int n_failures = 0;
+
+void
+check(bool condition, const char* file, int line, const char* expr)
+{
+	if (!condition) {
+		fprintf(stderr, "%s:%d: error: check failed: %s\n", file, line, expr);
+		++n_failures;
+	}
+}
+
+#define CHECK(expr) check((expr), __FILE__, __LINE__, #expr)
+
+/** A plugin for test blocks of type `B`. */
+template<class B>
+class TestPlugin : public PluginImpl
+{
+public:
+	TestPlugin(URIs& uris, const char* name)
+		: PluginImpl(uris,
+		             uris.ingen_Internal.urid_atom(),
+		             URI(std::string(NS_TEST) + name))
+		, _symbol(name)
+	{}
+
+	BlockImpl* instantiate(BufferFactory&      bufs,
+	                       const raul::Symbol& symbol,
+	                       bool                polyphonic,
+	                       GraphImpl*          parent,
+	                       server::Engine&     engine,
+	                       const LilvState*) override
+	{
+		return new B(this, bufs, symbol, polyphonic, parent, engine.sample_rate());
+	}
+
+	raul::Symbol symbol() const override { return _symbol; }
+
+private:
+	const raul::Symbol _symbol;
+};
+
+/** Writes automation events with a value for every `step` frames. */
+class AutomationBlock : public InternalBlock
+{
+public:
+	using Function = std::function<float(uint32_t step_index)>;
+
+	AutomationBlock(PluginImpl*         plugin,
+	                BufferFactory&      bufs,
+	                const raul::Symbol& symbol,
+	                bool                polyphonic,
+	                GraphImpl*          parent,
+	                SampleRate          rate)
+		: InternalBlock(plugin, symbol, polyphonic, parent, rate)
+	{
+		const URIs& uris = bufs.uris();
+		_ports = bufs.maid().make_managed<Ports>(1);
+
+		_out = new OutputPort(bufs, this, raul::Symbol("out"), 0, 1,
+		                      PortType::ATOM, uris.atom_Sequence,
+		                      bufs.forge().make(0.0f));
+		_out->set_property(uris.atom_supports, uris.atom_Float);
+		_ports->at(0) = _out;
+	}
+
+	/** Write `function(k)` at frame `start + phase + k * step` from now on. */
+	void start(FrameTime start, uint32_t step, uint32_t phase, Function function)
+	{
+		_start    = start + phase;
+		_step     = step;
+		_function = std::move(function);
+	}
+
+	void run(RunContext& ctx) override
+	{
+		if (!_function) {
+			return;
+		}
+
+		const URIs&     uris  = _out->bufs().uris();
+		Buffer&         out   = *_out->buffer(0);
+		const FrameTime begin = ctx.start() + ctx.offset();
+		const FrameTime end   = begin + ctx.nframes();
+
+		uint32_t k = (begin > _start) ? (begin - _start + _step - 1) / _step : 0U;
+		for (FrameTime t = _start + (k * _step); t < end; t = _start + (++k * _step)) {
+			const float value = _function(k);
+			out.append_event(t - ctx.start(),
+			                 sizeof(value),
+			                 uris.atom_Float,
+			                 reinterpret_cast<const uint8_t*>(&value));
+		}
+	}
+
+private:
+	OutputPort* _out{nullptr};
+	FrameTime   _start{0U};
+	uint32_t    _step{1U};
+	Function    _function;
+};
+
+/** Outputs the sum of two control inputs, and records the chunks it runs. */
+class ProbeBlock : public InternalBlock
+{
+public:
+	struct Chunk {
+		SampleCount offset;
+		float       a;
+		float       b;
+	};
+
+	ProbeBlock(PluginImpl*         plugin,
+	           BufferFactory&      bufs,
+	           const raul::Symbol& symbol,
+	           bool                polyphonic,
+	           GraphImpl*          parent,
+	           SampleRate          rate)
+		: InternalBlock(plugin, symbol, polyphonic, parent, rate)
+	{
+		const URIs& uris = bufs.uris();
+		const Atom  zero = bufs.forge().make(0.0f);
+		_ports           = bufs.maid().make_managed<Ports>(3);
+
+		_a = new InputPort(bufs, this, raul::Symbol("a"), 0, 1,
+		                   PortType::CONTROL, uris.atom_Sequence, zero);
+		_ports->at(0) = _a;
+
+		_b = new InputPort(bufs, this, raul::Symbol("b"), 1, 1,
+		                   PortType::CONTROL, uris.atom_Sequence, zero);
+		_ports->at(1) = _b;
+
+		_out = new OutputPort(bufs, this, raul::Symbol("out"), 2, 1,
+		                      PortType::CONTROL, uris.atom_Sequence, zero);
+		_ports->at(2) = _out;
+
+		_chunks.reserve(block_length);
+	}
+
+	/** The chunks of the last cycle. */
+	const std::vector<Chunk>& chunks() const { return _chunks; }
+
+	void pre_process(RunContext& ctx) override
+	{
+		InternalBlock::pre_process(ctx);
+		_chunks.clear();
+	}
+
+	void run(RunContext& ctx) override
+	{
+		const float a = *static_cast<const float*>(
+			_a->buffer(0)->port_data(PortType::CONTROL, 0));
+		const float b = *static_cast<const float*>(
+			_b->buffer(0)->port_data(PortType::CONTROL, 0));
+
+		*static_cast<float*>(_out->buffer(0)->port_data(PortType::CONTROL, 0)) =
+			a + b;
+
+		if (_chunks.size() < _chunks.capacity()) {
+			_chunks.push_back({ctx.offset(), a, b});
+		}
+	}
+
+private:
+	InputPort*         _a{nullptr};
+	InputPort*         _b{nullptr};
+	OutputPort*        _out{nullptr};
+	std::vector<Chunk> _chunks;
+};
+
+/** Return the signal of `voice` at `time`, which is exact in float. */
+float
+signal(FrameTime time, uint32_t voice)
+{
+	return static_cast<float>(((time % 61U) + 1U) * (voice + 1U));
+}
+
+/** Outputs signal() for each voice. */
+class SignalBlock : public InternalBlock
+{
+public:
+	SignalBlock(PluginImpl*         plugin,
+	            BufferFactory&      bufs,
+	            const raul::Symbol& symbol,
+	            bool                polyphonic,
+	            GraphImpl*          parent,
+	            SampleRate          rate)
+		: InternalBlock(plugin, symbol, polyphonic, parent, rate)
+	{
+		_ports = bufs.maid().make_managed<Ports>(1);
+		_out   = new OutputPort(bufs, this, raul::Symbol("out"), 0, _polyphony,
+		                        PortType::AUDIO, 0, bufs.forge().make(0.0f));
+		_ports->at(0) = _out;
+	}
+
+	bool voices_independent() const override { return _polyphonic; }
+
+	void run(RunContext& ctx) override { run_voices(ctx, 0U, _polyphony); }
+
+	void run_voices(RunContext& ctx, uint32_t begin, uint32_t end) override
+	{
+		for (uint32_t v = begin; v < std::min(end, _polyphony); ++v) {
+			float* const out = _out->buffer(v)->samples();
+			for (SampleCount i = ctx.offset(); i < ctx.offset() + ctx.nframes(); ++i) {
+				out[i] = signal(ctx.start() + i, v);
+			}
+		}
+	}
+
+private:
+	OutputPort* _out{nullptr};
+};
+
+/// Order in which gain blocks ran, across all threads
+std::atomic<uint32_t> run_order{0U};
+
+/** Outputs twice its input plus one, and records when it ran as one block.
+ *
+ * Voices run in parallel are not recorded, since they run concurrently.
+ */
+class GainBlock : public InternalBlock
+{
+public:
+	GainBlock(PluginImpl*         plugin,
+	          BufferFactory&      bufs,
+	          const raul::Symbol& symbol,
+	          bool                polyphonic,
+	          GraphImpl*          parent,
+	          SampleRate          rate)
+		: InternalBlock(plugin, symbol, polyphonic, parent, rate)
+	{
+		const Atom zero = bufs.forge().make(0.0f);
+		_ports          = bufs.maid().make_managed<Ports>(2);
+
+		_in = new InputPort(bufs, this, raul::Symbol("in"), 0, _polyphony,
+		                    PortType::AUDIO, 0, zero);
+		_ports->at(0) = _in;
+
+		_out = new OutputPort(bufs, this, raul::Symbol("out"), 1, _polyphony,
+		                      PortType::AUDIO, 0, zero);
+		_ports->at(1) = _out;
+	}
+
+	/** The position of the last run in run_order. */
+	uint32_t order() const { return _order; }
+
+	/** The number of runs in the last cycle. */
+	uint32_t n_runs() const { return _n_runs; }
+
+	void pre_process(RunContext& ctx) override
+	{
+		InternalBlock::pre_process(ctx);
+		_n_runs = 0U;
+	}
+
+	bool voices_independent() const override { return _polyphonic; }
+
+	void run(RunContext& ctx) override
+	{
+		_order = run_order++;
+		++_n_runs;
+		run_voices(ctx, 0U, _polyphony);
+	}
+
+	void run_voices(RunContext& ctx, uint32_t begin, uint32_t end) override
+	{
+		for (uint32_t v = begin; v < std::min(end, _polyphony); ++v) {
+			const float* const in  = _in->buffer(v)->samples();
+			float* const       out = _out->buffer(v)->samples();
+			for (SampleCount i = ctx.offset(); i < ctx.offset() + ctx.nframes(); ++i) {
+				out[i] = (2.0f * in[i]) + 1.0f;
+			}
+		}
+	}
+
+private:
+	InputPort*  _in{nullptr};
+	OutputPort* _out{nullptr};
+	uint32_t    _order{0U};
+	uint32_t    _n_runs{0U};
+};
+
+/** An engine with the test plugins, which the test runs one cycle at a time. */
+class TestEngine
+{
+public:
+	struct Options {
+		int32_t threads{1};
+		bool    dataflow{false};
+		int32_t min_slice{1};
+		float   control_epsilon{0.0f};
+	};
+
+	explicit TestEngine(const Options& options)
+	{
+		static char  name[] = "engine_test";
+		static char* args[] = {name, nullptr};
+		int          argc   = 1;
+		char**       argv   = args;
+
+		_world = std::make_unique<World>(nullptr, nullptr, nullptr);
+		_world->load_configuration(argc, argv);
+
+		Configuration& conf  = _world->conf();
+		Forge&         forge = _world->forge();
+		conf.set("threads", forge.make(options.threads));
+		conf.set("dataflow", forge.make(options.dataflow));
+		conf.set("min-slice", forge.make(options.min_slice));
+		conf.set("control-epsilon", forge.make(options.control_epsilon));
+
+		auto engine = std::make_shared<server::Engine>(*_world);
+		_engine     = engine.get();
+		_world->set_engine(engine);
+		_world->set_interface(engine->interface());
+
+		URIs&                 uris    = _world->uris();
+		server::BlockFactory& factory = *engine->block_factory();
+		factory.add_plugin(
+			std::make_shared<TestPlugin<AutomationBlock>>(uris, "automation"));
+		factory.add_plugin(
+			std::make_shared<TestPlugin<ProbeBlock>>(uris, "probe"));
+		factory.add_plugin(
+			std::make_shared<TestPlugin<SignalBlock>>(uris, "signal"));
+		factory.add_plugin(
+			std::make_shared<TestPlugin<GainBlock>>(uris, "gain"));
+
+		engine->init(48000.0, block_length, 4096);
+		engine->activate();
+	}
+
+	TestEngine(const TestEngine&)            = delete;
+	TestEngine& operator=(const TestEngine&) = delete;
+
+	~TestEngine() { _engine->deactivate(); }
+
+	void add_block(const std::string& path,
+	               const char*        plugin,
+	               bool               polyphonic = false)
+	{
+		const URIs& uris = _world->uris();
+
+		const Properties props{
+			{uris.rdf_type, Property(uris.ingen_Block)},
+			{uris.lv2_prototype,
+			 _world->forge().make_urid(URI(std::string(NS_TEST) + plugin))},
+			{uris.ingen_polyphonic, _world->forge().make(polyphonic)}};
+
+		_world->interface()->put(path_to_uri(raul::Path(path)), props);
+	}
+
+	void add_graph(const std::string& path, int32_t polyphony)
+	{
+		const URIs& uris = _world->uris();
+
+		const Properties props{
+			{uris.rdf_type, Property(uris.ingen_Graph)},
+			{uris.ingen_polyphony, _world->forge().make(polyphony)}};
+
+		_world->interface()->put(path_to_uri(raul::Path(path)), props);
+	}
+
+	void connect(const std::string& tail, const std::string& head)
+	{
+		_world->interface()->connect(raul::Path(tail), raul::Path(head));
+	}
+
+	server::Engine& engine() { return *_engine; }
+
+	/** Run cycles until all sent messages are processed. */
+	void flush() { _engine->flush_events(std::chrono::milliseconds(1)); }
+
+	/** Run one cycle. */
+	void cycle()
+	{
+		_engine->run(block_length);
+		_engine->advance(block_length);
+		_engine->main_iteration();
+	}
+
+	/** Return the start time of the next cycle. */
+	FrameTime time() { return _engine->run_context().start(); }
+
+	template<class T>
+	T* find(const std::string& path)
+	{
+		const auto i = _world->store()->find(raul::Path(path));
+		return (i != _world->store()->end())
+		           ? dynamic_cast<T*>(i->second.get())
+		           : nullptr;
+	}
+
+private:
+	std::unique_ptr<World> _world;
+	server::Engine*        _engine{nullptr};
+};
+
+/** Return the number of events in the first voice of `port`. */
+uint32_t
+n_events(const PortImpl& port)
+{
+	uint32_t    n   = 0U;
+	const auto* seq = port.buffer(0)->get<LV2_Atom_Sequence>();
+	LV2_ATOM_SEQUENCE_FOREACH (seq, ev) {
+		++n;
+	}
+	return n;
+}
+
+/** Return the current value of the first voice of `port`. */
+float
+value(const PortImpl& port)
+{
+	return reinterpret_cast<const LV2_Atom_Float*>(port.buffer(0)->value())
+	    ->body;
+}
+
+/** Build automation -> probe -> sink, and return true if it was created. */
+bool
+build_probe_chain(TestEngine& engine)
+{
+	engine.add_block("/automation", "automation");
+	engine.add_block("/probe", "probe");
+	engine.add_block("/sink", "probe");
+	engine.connect("/automation/out", "/probe/a");
+	engine.connect("/probe/out", "/sink/a");
+	engine.flush();
+	engine.cycle();
+
+	return engine.find<AutomationBlock>("/automation") &&
+	       engine.find<PortImpl>("/probe/out") &&
+	       engine.find<PortImpl>("/sink/a");
+}
+
+/* Control outputs are emitted as events only when they change.  A probe is
+   automated every 32 frames, so it runs in 8 chunks per cycle, but its value
+   only steps every 36 chunks.  Over 32 cycles, there are 7 steps:
+   - 3 at the start of a cycle, which are one event each.
+   - 4 within a cycle, which are the previous value at the start of the
+     cycle and then the new one, so that the cycle has a complete sequence.
+   Emitting every chunk would be 256 events, and emitting every cycle then
+   changes would be 36. */
+void
+test_control_changes()
+{
+	TestEngine engine{TestEngine::Options{}};
+	if (!build_probe_chain(engine)) {
+		CHECK(false);
+		return;
+	}
+
+	auto* const automation = engine.find<AutomationBlock>("/automation");
+	auto* const out        = engine.find<PortImpl>("/probe/out");
+	auto* const sink       = engine.find<PortImpl>("/sink/a");
+
+	const auto steps = [](uint32_t k) { return static_cast<float>(k / 36U); };
+
+	automation->start(engine.time(), 32U, 0U, steps);
+	uint32_t n_emitted = 0U;
+	for (uint32_t c = 0U; c < 32U; ++c) {
+		engine.cycle();
+		n_emitted += n_events(*out);
+
+		// The sink follows along, even in cycles where nothing was emitted
+		CHECK(value(*sink) == steps((c * 8U) + 7U));
+	}
+
+	CHECK(n_emitted == 11U);
+}
+
+/* Changes within the control epsilon are not emitted while the value moves,
+   but the exact value is emitted once it stops, so readers do not drift. */
+void
+test_control_epsilon()
+{
+	const float epsilon = 0.001f;
+
+	TestEngine::Options options;
+	options.control_epsilon = epsilon;
+
+	TestEngine engine{options};
+	if (!build_probe_chain(engine)) {
+		CHECK(false);
+		return;
+	}
+
+	auto* const automation = engine.find<AutomationBlock>("/automation");
+	auto* const out        = engine.find<PortImpl>("/probe/out");
+	auto* const sink       = engine.find<PortImpl>("/sink/a");
+
+	// Noise smaller than epsilon on a step is only emitted at the step
+	const auto noisy = [](uint32_t k) {
+		return static_cast<float>(k / 36U) + ((k % 2U) ? 0.0001f : 0.0f);
+	};
+
+	automation->start(engine.time(), 32U, 0U, noisy);
+	uint32_t n_emitted = 0U;
+	for (uint32_t c = 0U; c < 32U; ++c) {
+		engine.cycle();
+		n_emitted += n_events(*out);
+		CHECK(std::fabs(value(*sink) - noisy((c * 8U) + 7U)) <= epsilon);
+	}
+
+	CHECK(n_emitted == 11U);
+
+	// A ramp in steps smaller than epsilon ends at exactly the final value
+	const auto ramp = [](uint32_t k) {
+		return static_cast<float>(std::min(k, 50U)) * 0.0004f;
+	};
+
+	automation->start(engine.time(), 32U, 0U, ramp);
+	for (uint32_t c = 0U; c < 16U; ++c) {
+		engine.cycle();
+	}
+
+	CHECK(value(*sink) == ramp(50U));
+
+	// A new head gets the value, although it has not changed since
+	engine.add_block("/late_sink", "probe");
+	engine.connect("/probe/out", "/late_sink/a");
+	engine.flush();
+	engine.cycle();
+
+	auto* const late_sink = engine.find<PortImpl>("/late_sink/a");
+	CHECK(late_sink && value(*late_sink) == ramp(50U));
+}
+
+/* Blocks run in chunks that start at changes of their control inputs, and
+   are at least the minimum slice long.  A probe has one input automated every
+   32 frames, and another every 80 frames from frame 8.  A change within a
+   slice is applied at the start of the next one. */
+void
+test_min_slice()
+{
+	struct Case {
+		int32_t                  min_slice;
+		std::vector<SampleCount> offsets;
+	};
+
+	const std::vector<Case> cases{
+		{1, {0U, 8U, 32U, 64U, 88U, 96U, 128U, 160U, 168U, 192U, 224U, 248U}},
+		{64, {0U, 64U, 128U, 192U}},
+		{100, {0U, 128U, 248U}},
+	};
+
+	for (const auto& c : cases) {
+		TestEngine::Options options;
+		options.min_slice = c.min_slice;
+
+		TestEngine engine{options};
+		engine.add_block("/a", "automation");
+		engine.add_block("/b", "automation");
+		engine.add_block("/probe", "probe");
+		engine.connect("/a/out", "/probe/a");
+		engine.connect("/b/out", "/probe/b");
+		engine.flush();
+		engine.cycle();
+
+		auto* const a     = engine.find<AutomationBlock>("/a");
+		auto* const b     = engine.find<AutomationBlock>("/b");
+		auto* const probe = engine.find<ProbeBlock>("/probe");
+		if (!a || !b || !probe) {
+			CHECK(false);
+			continue;
+		}
+
+		const FrameTime start = engine.time();
+		a->start(start, 32U, 0U, [](uint32_t k) {
+			return static_cast<float>(k);
+		});
+		b->start(start, 80U, 8U, [](uint32_t k) {
+			return 100.0f + static_cast<float>(k);
+		});
+		engine.cycle();
+
+		const auto& chunks = probe->chunks();
+		CHECK(chunks.size() == c.offsets.size());
+		for (size_t i = 0U; i < std::min(chunks.size(), c.offsets.size()); ++i) {
+			const SampleCount offset = chunks[i].offset;
+			const float       b_value =
+				(offset < 8U) ? 0.0f
+				              : 100.0f + static_cast<float>((offset - 8U) / 80U);
+
+			CHECK(offset == c.offsets[i]);
+			CHECK(chunks[i].a == static_cast<float>(offset / 32U));
+			CHECK(chunks[i].b == b_value);
+		}
+	}
+}
+
+/* Both the task tree and the dataflow schedule run every block once per
+   cycle, after its providers, in a graph with branches of different lengths:
+
+   signal --> left0 --> left1 --> left2 --> join --> tail
+          \--> right -----------------------/
+*/
+void
+test_schedule()
+{
+	for (const bool dataflow : {false, true}) {
+		TestEngine::Options options;
+		options.threads  = 4;
+		options.dataflow = dataflow;
+
+		TestEngine engine{options};
+		engine.add_block("/signal", "signal");
+		for (const char* name : {"left0", "left1", "left2", "right", "join", "tail"}) {
+			engine.add_block(std::string("/") + name, "gain");
+		}
+
+		engine.connect("/signal/out", "/left0/in");
+		engine.connect("/left0/out", "/left1/in");
+		engine.connect("/left1/out", "/left2/in");
+		engine.connect("/left2/out", "/join/in");
+		engine.connect("/signal/out", "/right/in");
+		engine.connect("/right/out", "/join/in");
+		engine.connect("/join/out", "/tail/in");
+		engine.flush();
+
+		auto* const left0 = engine.find<GainBlock>("/left0");
+		auto* const left1 = engine.find<GainBlock>("/left1");
+		auto* const left2 = engine.find<GainBlock>("/left2");
+		auto* const right = engine.find<GainBlock>("/right");
+		auto* const join  = engine.find<GainBlock>("/join");
+		auto* const tail  = engine.find<GainBlock>("/tail");
+		auto* const out   = engine.find<PortImpl>("/tail/out");
+		if (!left0 || !left1 || !left2 || !right || !join || !tail || !out) {
+			CHECK(false);
+			continue;
+		}
+
+		for (uint32_t c = 0U; c < 8U; ++c) {
+			const FrameTime start = engine.time();
+			engine.cycle();
+
+			for (const auto* block : {left0, left1, left2, right, join, tail}) {
+				CHECK(block->n_runs() == 1U);
+			}
+
+			CHECK(left0->order() < left1->order());
+			CHECK(left1->order() < left2->order());
+			CHECK(left2->order() < join->order());
+			CHECK(right->order() < join->order());
+			CHECK(join->order() < tail->order());
+
+			// join = (8s + 7) + (2s + 1), so tail = 2 * (2 * join + 1) + 1
+			const float* const samples = out->buffer(0)->samples();
+			for (uint32_t i = 0U; i < block_length; ++i) {
+				CHECK(samples[i] == (40.0f * signal(start + i, 0U)) + 35.0f);
+			}
+		}
+	}
+}
+
+/* Running the voices of polyphonic blocks in parallel gives exactly the
+   output of running them in one thread, in a polyphonic graph with a chain
+   that can be grouped by voice and a join that can not:
+
+   signal --> chain0 --> chain1 --> join
+          \--> side ---------------/
+*/
+void
+test_voices()
+{
+	constexpr uint32_t n_voices = 4U;
+	constexpr uint32_t n_cycles = 8U;
+
+	struct Run {
+		int32_t threads;
+		bool    dataflow;
+	};
+
+	std::vector<std::vector<float>> outputs;
+	for (const Run run : {Run{1, false}, Run{4, false}, Run{4, true}}) {
+		TestEngine::Options options;
+		options.threads  = run.threads;
+		options.dataflow = run.dataflow;
+
+		TestEngine engine{options};
+		engine.add_graph("/poly", static_cast<int32_t>(n_voices));
+		engine.add_block("/poly/signal", "signal", true);
+		for (const char* name : {"chain0", "chain1", "side", "join"}) {
+			engine.add_block(std::string("/poly/") + name, "gain", true);
+		}
+
+		engine.connect("/poly/signal/out", "/poly/chain0/in");
+		engine.connect("/poly/chain0/out", "/poly/chain1/in");
+		engine.connect("/poly/chain1/out", "/poly/join/in");
+		engine.connect("/poly/signal/out", "/poly/side/in");
+		engine.connect("/poly/side/out", "/poly/join/in");
+		engine.flush();
+
+		auto* const out = engine.find<PortImpl>("/poly/join/out");
+		if (!out || out->poly() != n_voices) {
+			CHECK(false);
+			continue;
+		}
+
+		std::vector<float>& output = outputs.emplace_back();
+		output.reserve(size_t{n_cycles} * n_voices * block_length);
+		for (uint32_t c = 0U; c < n_cycles; ++c) {
+			const FrameTime start = engine.time();
+			engine.cycle();
+
+			// join = (4s + 3) + (2s + 1), so out = 2 * join + 1
+			for (uint32_t v = 0U; v < n_voices; ++v) {
+				const float* const samples = out->buffer(v)->samples();
+				for (uint32_t i = 0U; i < block_length; ++i) {
+					CHECK(samples[i] == (12.0f * signal(start + i, v)) + 9.0f);
+					output.push_back(samples[i]);
+				}
+			}
+		}
+	}
+
+	CHECK(outputs.size() == 3U);
+	for (const auto& output : outputs) {
+		CHECK(output == outputs.front());
+	}
+}
+
+/* Sequences are merged by time, and events at the same time stay in the order
+   of their sources, even with more sources than fit in the merger at once. */
+void
+test_mix_many_sequences()
+{
+	TestEngine      engine{TestEngine::Options{}};
+	server::Engine& eng  = engine.engine();
+	RunContext&     ctx  = eng.run_context();
+	BufferFactory&  bufs = *eng.buffer_factory();
+	const URIs&     uris = eng.world().uris();
+
+	const uint32_t n_srcs = (2U * ctx.sequence_merger().capacity()) + 3U;
+
+	// Each source has one integer event with its index, at one of 4 times
+	std::vector<BufferRef>     srcs;
+	std::vector<const Buffer*> src_ptrs;
+	for (uint32_t i = 0U; i < n_srcs; ++i) {
+		srcs.push_back(bufs.create(uris.atom_Sequence, 0, 64U));
+		srcs.back()->prepare_write(ctx);
+
+		const auto body = static_cast<int32_t>(i);
+		srcs.back()->append_event(static_cast<int64_t>((n_srcs - i) % 4U),
+		                          sizeof(body),
+		                          uris.atom_Int,
+		                          reinterpret_cast<const uint8_t*>(&body));
+		src_ptrs.push_back(srcs.back().get());
+	}
+
+	const BufferRef dst =
+		bufs.create(uris.atom_Sequence, 0, (n_srcs * 32U) + 64U);
+	dst->prepare_write(ctx);
+	server::mix(ctx, dst.get(), src_ptrs.data(), n_srcs);
+
+	uint32_t n_events = 0U;
+	int64_t  time     = 0;
+	int32_t  index    = -1;
+	const auto* seq   = dst->get<LV2_Atom_Sequence>();
+	LV2_ATOM_SEQUENCE_FOREACH (seq, ev) {
+		const int32_t i = reinterpret_cast<const LV2_Atom_Int*>(&ev->body)->body;
+		CHECK(ev->time.frames >= time);
+		CHECK(ev->time.frames > time || i > index);
+		time  = ev->time.frames;
+		index = i;
+		++n_events;
+	}
+
+	CHECK(n_events == n_srcs);
+}
+
+} // namespace
+} // namespace ingen::test
+
+int
+main()
+{
+	ingen::test::test_control_changes();
+	ingen::test::test_control_epsilon();
+	ingen::test::test_min_slice();
+	ingen::test::test_schedule();
+	ingen::test::test_voices();
+	ingen::test::test_mix_many_sequences();
+
+	return ingen::test::n_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
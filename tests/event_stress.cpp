@@ -0,0 +1,199 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <ingen/Atom.hpp>
+#include <ingen/EngineBase.hpp>
+#include <ingen/Forge.hpp>
+#include <ingen/Interface.hpp>
+#include <ingen/Message.hpp>
+#include <ingen/Properties.hpp>
+#include <ingen/Resource.hpp>
+#include <ingen/URI.hpp>
+#include <ingen/URIs.hpp>
+#include <ingen/World.hpp>
+#include <ingen/paths.hpp>
+#include <ingen/runtime_paths.hpp>
+#include <raul/Path.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace ingen::test {
+namespace {
+
+constexpr uint32_t n_producers = 16;   ///< Number of producer threads
+constexpr int32_t  n_events    = 4096; ///< Events sent by each producer
+
+std::unique_ptr<ingen::World> world;
+
+void
+ingen_try(bool cond, const char* msg)
+{
+	if (!cond) {
+		std::cerr << "ingen: Error: " << msg << "\n";
+		world.reset();
+		exit(EXIT_FAILURE);
+	}
+}
+
+URI
+subject(uint32_t producer)
+{
+	return path_to_uri(raul::Path("/n" + std::to_string(producer)));
+}
+
+/** Client that checks values set by each producer arrive in order. */
+class StressClient : public Interface
+{
+public:
+	explicit StressClient(URI key) noexcept : _key(std::move(key)) {}
+
+	URI uri() const override { return URI("ingen:stressClient"); }
+
+	void message(const Message& msg) override {
+		const auto* const set = std::get_if<SetProperty>(&msg);
+		if (!set || set->predicate != _key) {
+			return;
+		}
+
+		const int32_t value = set->value.get<int32_t>();
+		int32_t&      last  = _last_values.emplace(set->subject, -1).first->second;
+		if (value != last + 1) {
+			std::cerr << "error: " << set->subject << " set to " << value
+			          << " after " << last << "\n";
+			++_n_errors;
+		}
+
+		last = value;
+	}
+
+	bool check() const {
+		for (uint32_t i = 0; i < n_producers; ++i) {
+			const auto v = _last_values.find(subject(i));
+			if (v == _last_values.end() || v->second != n_events - 1) {
+				std::cerr << "error: missing values for " << subject(i) << "\n";
+				return false;
+			}
+		}
+
+		return _n_errors == 0;
+	}
+
+private:
+	URI                    _key;
+	std::map<URI, int32_t> _last_values;
+	uint32_t               _n_errors{0};
+};
+
+int
+run(int argc, char** argv)
+{
+	try {
+		world = std::make_unique<ingen::World>(nullptr, nullptr, nullptr);
+		world->load_configuration(argc, argv);
+	} catch (std::exception& e) {
+		std::cout << "ingen: " << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	ingen_try(world->load_module("server"), "Unable to load server module");
+	ingen_try(!!world->engine(), "Unable to create engine");
+
+	EngineBase& engine = *world->engine();
+	engine.init(48000.0, 256, 4096);
+	engine.activate();
+
+	const URIs& uris = world->uris();
+	const URI   key("http://drobilla.net/ns/ingen#stressValue");
+
+	auto client = std::make_shared<StressClient>(key);
+	engine.register_client(client);
+
+	// Create a block for each producer to set properties on
+	for (uint32_t i = 0; i < n_producers; ++i) {
+		world->interface()->put(
+			subject(i),
+			{{uris.rdf_type, Property(uris.ingen_Block)},
+			 {uris.lv2_prototype,
+			  world->forge().make_urid(
+				  URI("http://drobilla.net/ns/ingen-internals#BlockDelay"))}});
+	}
+	engine.flush_events(std::chrono::milliseconds(10));
+
+	// Submit events from every producer at once
+	std::atomic<uint32_t>    n_running{n_producers};
+	std::vector<std::thread> producers;
+	for (uint32_t i = 0; i < n_producers; ++i) {
+		producers.emplace_back([&, i] {
+			Interface&  iface = *world->interface();
+			const URI   uri   = subject(i);
+			for (int32_t j = 0; j < n_events; ++j) {
+				iface.message(
+					SetProperty{0, uri, key, world->forge().make(j),
+					            Resource::Graph::DEFAULT});
+			}
+			--n_running;
+		});
+	}
+
+	// Run the engine until everything has been processed
+	uint64_t n_processed = 0;
+	while (n_running || engine.pending_events()) {
+		engine.advance(256);
+		n_processed += engine.run(256);
+		engine.main_iteration();
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	for (auto& p : producers) {
+		p.join();
+	}
+
+	engine.main_iteration();
+	engine.deactivate();
+
+	const uint64_t n_expected = static_cast<uint64_t>(n_producers) * n_events;
+	if (n_processed != n_expected) {
+		std::cerr << "error: processed " << n_processed << " of " << n_expected
+		          << " events\n";
+		return EXIT_FAILURE;
+	}
+
+	return client->check() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace
+} // namespace ingen::test
+
+int
+main(int argc, char** argv)
+{
+	ingen::set_bundle_path_from_code(
+	    reinterpret_cast<void (*)()>(&ingen::test::ingen_try));
+
+	return ingen::test::run(argc, argv);
+}
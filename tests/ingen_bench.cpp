@@ -14,16 +14,28 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include "TestClient.hpp"
+
 #include <ingen/Atom.hpp>
-#include <ingen/Clock.hpp>
 #include <ingen/Configuration.hpp>
 #include <ingen/EngineBase.hpp>
 #include <ingen/Forge.hpp>
+#include <ingen/Interface.hpp>
+#include <ingen/Node.hpp>
 #include <ingen/Parser.hpp>
+#include <ingen/Properties.hpp>
+#include <ingen/Resource.hpp>
+#include <ingen/Store.hpp>
+#include <ingen/URI.hpp>
+#include <ingen/URIs.hpp>
 #include <ingen/World.hpp>
+#include <ingen/paths.hpp>
 #include <ingen/runtime_paths.hpp>
+#include <raul/Path.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
@@ -31,6 +43,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace ingen::bench {
 namespace {
@@ -56,6 +69,361 @@ real_path(const char* path)
 	return result;
 }
 
+/* Synthetic graph generation.
+ *
+ * These graphs use only internal blocks so that results are reproducible
+ * without any installed plugins.  The blocks themselves do very little work,
+ * so the results mostly reflect scheduling, mixing, and buffer overhead.
+ */
+
+void
+add_block(const std::string& path, const char* plugin, bool polyphonic = false)
+{
+	const URIs& uris = world->uris();
+
+	Properties props{
+		{uris.rdf_type, Property(uris.ingen_Block)},
+		{uris.lv2_prototype,
+		 world->forge().make_urid(
+			 URI(std::string("http://drobilla.net/ns/ingen-internals#") +
+			     plugin))}};
+
+	if (polyphonic) {
+		props.put(uris.ingen_polyphonic, world->forge().make(true));
+	}
+
+	world->interface()->put(path_to_uri(raul::Path(path)), props);
+}
+
+void
+add_graph(const std::string& path, int32_t poly)
+{
+	const URIs& uris = world->uris();
+
+	const Properties props{
+		{uris.rdf_type, Property(uris.ingen_Graph)},
+		{uris.ingen_polyphony, world->forge().make(poly)},
+		{uris.ingen_enabled, world->forge().make(true)}};
+
+	world->interface()->put(path_to_uri(raul::Path(path)),
+	                        props,
+	                        Resource::Graph::INTERNAL);
+}
+
+void
+add_port(const std::string& path,
+         const URIs::Quark& direction,
+         const URIs::Quark& type)
+{
+	const URIs& uris = world->uris();
+
+	Properties props{{uris.rdf_type, Property(direction)},
+	                 {uris.rdf_type, Property(type)}};
+
+	if (type == uris.atom_AtomPort) {
+		props.put(uris.atom_bufferType, Property(uris.atom_Sequence));
+		props.put(uris.atom_supports, Property(uris.midi_MidiEvent));
+	}
+
+	world->interface()->put(path_to_uri(raul::Path(path)), props);
+}
+
+/// Number of arcs requested while building the graph
+uint32_t n_connects = 0;
+
+void
+connect(const std::string& tail, const std::string& head)
+{
+	world->interface()->connect(raul::Path(tail), raul::Path(head));
+	++n_connects;
+}
+
+/// Return the number of arcs in all graphs in the store
+size_t
+count_arcs()
+{
+	size_t n = 0;
+	for (const auto& o : *world->store()) {
+		n += o.second->arcs().size();
+	}
+
+	return n;
+}
+
+/// Return the number of blocks (not graphs) in the store
+size_t
+count_blocks()
+{
+	size_t n = 0;
+	for (const auto& o : *world->store()) {
+		if (o.second->graph_type() == Node::GraphType::BLOCK) {
+			++n;
+		}
+	}
+
+	return n;
+}
+
+std::string
+indexed(const char* prefix, uint32_t i)
+{
+	return prefix + std::to_string(i);
+}
+
+/// A series of `n` blocks, with no parallelism at all
+void
+build_chain(uint32_t n)
+{
+	for (uint32_t i = 0; i < n; ++i) {
+		add_block(indexed("/d", i), "BlockDelay");
+		if (i > 0) {
+			connect(indexed("/d", i - 1) + "/out", indexed("/d", i) + "/in");
+		}
+	}
+}
+
+/// One block feeding `n` parallel blocks, which are all mixed into one
+void
+build_fanout(uint32_t n)
+{
+	add_block("/src", "BlockDelay");
+	add_block("/sink", "BlockDelay");
+	for (uint32_t i = 0; i < n; ++i) {
+		add_block(indexed("/w", i), "BlockDelay");
+		connect("/src/out", indexed("/w", i) + "/in");
+		connect(indexed("/w", i) + "/out", "/sink/in");
+	}
+}
+
+/// A series of `n` diamonds, each of which splits into two parallel blocks
+void
+build_diamond(uint32_t n)
+{
+	add_block("/j0", "BlockDelay");
+	for (uint32_t i = 0; i < n; ++i) {
+		const std::string top    = indexed("/j", i);
+		const std::string left   = indexed("/l", i);
+		const std::string right  = indexed("/r", i);
+		const std::string bottom = indexed("/j", i + 1);
+
+		add_block(left, "BlockDelay");
+		add_block(right, "BlockDelay");
+		add_block(bottom, "BlockDelay");
+		connect(top + "/out", left + "/in");
+		connect(top + "/out", right + "/in");
+		connect(left + "/out", bottom + "/in");
+		connect(right + "/out", bottom + "/in");
+	}
+}
+
+/// A subgraph with `n` voices, each an audio chain and a note block
+void
+build_poly(uint32_t n)
+{
+	static constexpr uint32_t chain_length = 4;
+
+	const URIs& uris = world->uris();
+
+	add_graph("/voices", static_cast<int32_t>(n));
+	add_port("/voices/in", uris.lv2_InputPort, uris.lv2_AudioPort);
+	add_port("/voices/control", uris.lv2_InputPort, uris.atom_AtomPort);
+	add_port("/voices/out", uris.lv2_OutputPort, uris.lv2_AudioPort);
+	add_port("/voices/gate", uris.lv2_OutputPort, uris.lv2_CVPort);
+
+	// Audio through a chain of delays in every voice
+	for (uint32_t i = 0; i < chain_length; ++i) {
+		add_block(indexed("/voices/d", i), "BlockDelay", true);
+		connect(i == 0 ? std::string("/voices/in")
+		               : indexed("/voices/d", i - 1) + "/out",
+		        indexed("/voices/d", i) + "/in");
+	}
+	connect(indexed("/voices/d", chain_length - 1) + "/out", "/voices/out");
+
+	// Notes from the control input allocated to voices, with gate as CV
+	add_block("/voices/note", "Note", true);
+	connect("/voices/control", "/voices/note/input");
+	connect("/voices/note/gate", "/voices/gate");
+
+	add_block("/src", "BlockDelay");
+	add_block("/sink", "BlockDelay");
+	connect("/src/out", "/voices/in");
+	connect("/control", "/voices/control");
+	connect("/voices/out", "/sink/in");
+	connect("/voices/gate", "/sink/in");
+}
+
+/// Control input to `n` note blocks, whose outputs are all merged into one
+void
+build_sequence(uint32_t n)
+{
+	add_block("/trigger", "Trigger");
+	for (uint32_t i = 0; i < n; ++i) {
+		const std::string note = indexed("/note", i);
+
+		add_block(note, "Note");
+		connect("/control", note + "/input");
+		connect(note + "/gate", "/trigger/input");
+		connect(note + "/trigger", "/trigger/input");
+	}
+}
+
+/// Send a note on or off to the root control input every few cycles
+void
+drive_notes(uint32_t cycle)
+{
+	static constexpr uint32_t period = 8;
+
+	const uint32_t phase = cycle % period;
+	if (phase != 0 && phase != period / 2) {
+		return;
+	}
+
+	// Play a repeating run of notes, so voices are allocated and stolen
+	const URIs&   uris   = world->uris();
+	const auto    note   = static_cast<uint8_t>(48 + ((cycle / period) % 24));
+	const uint8_t msg[3] = {
+		static_cast<uint8_t>(phase == 0 ? 0x90 : 0x80), note, 0x40};
+
+	world->interface()->set_property(
+		path_to_uri(raul::Path("/control")),
+		uris.ingen_value,
+		Atom(sizeof(msg), uris.midi_MidiEvent, msg));
+}
+
+bool
+build_graph(const std::string& topology, uint32_t size, bool& notes)
+{
+	if (topology == "chain") {
+		build_chain(size);
+	} else if (topology == "fanout") {
+		build_fanout(size);
+	} else if (topology == "diamond") {
+		build_diamond(size);
+	} else if (topology == "poly") {
+		build_poly(size);
+		notes = true;
+	} else if (topology == "sequence") {
+		build_sequence(size);
+		notes = true;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+/* Results */
+
+/// Return the value at `fraction` of the way through sorted `times`
+double
+percentile(const std::vector<double>& times, double fraction)
+{
+	const auto i = static_cast<size_t>(
+		(fraction * static_cast<double>(times.size() - 1)) + 0.5);
+
+	return times[std::min(i, times.size() - 1)];
+}
+
+std::unique_ptr<FILE, int (*)(FILE*)>
+open_log(const std::string& path, const char* header)
+{
+	std::unique_ptr<FILE, int (*)(FILE*)> log{fopen(path.c_str(), "a"),
+	                                          &fclose};
+
+	ingen_try(!!log, "Unable to open output file");
+	if (ftell(log.get()) == 0) {
+		fprintf(log.get(), "%s\n", header);
+	}
+
+	return log;
+}
+
+/// Write the number of cycles that took up to each power of two microseconds
+void
+write_histogram(const std::string&         path,
+                const std::string&         name,
+                uint32_t                   size,
+                int32_t                    n_threads,
+                uint32_t                   block_length,
+                const std::vector<double>& times)
+{
+	const auto log = open_log(
+		path,
+		"# topology\tsize\tn_threads\tblock_length\tmax_time_us\tcycles");
+
+	double   bound = 1.0;
+	uint32_t count = 0;
+	for (const double t : times) {
+		while (t > bound) {
+			if (count) {
+				fprintf(log.get(), "%s\t%u\t%d\t%u\t%.0f\t%u\n",
+				        name.c_str(), size, n_threads, block_length, bound,
+				        count);
+			}
+			bound *= 2.0;
+			count = 0;
+		}
+		++count;
+	}
+
+	fprintf(log.get(), "%s\t%u\t%d\t%u\t%.0f\t%u\n",
+	        name.c_str(), size, n_threads, block_length, bound, count);
+}
+
+/* Block creation */
+
+/// Return the mean time in microseconds to process `n` block puts
+double
+time_puts(uint32_t n, const char* prefix, const Atom& prototype)
+{
+	using Clock = std::chrono::steady_clock;
+
+	const URIs&      uris  = world->uris();
+	const Properties props{{uris.rdf_type, Property(uris.ingen_Block)},
+	                       {uris.lv2_prototype, prototype}};
+
+	const Clock::time_point start = Clock::now();
+	for (uint32_t i = 0; i < n; ++i) {
+		world->interface()->put(path_to_uri(raul::Path(indexed(prefix, i))),
+		                        props);
+	}
+
+	world->engine()->flush_events(std::chrono::milliseconds(1));
+
+	return std::chrono::duration<double, std::micro>(Clock::now() - start)
+	           .count() /
+	       n;
+}
+
+/// Time instantiating `n` blocks of `plugin`, then duplicating one `n` times
+bool
+bench_blocks(const std::string& plugin, uint32_t n, const std::string& out_file)
+{
+	Forge& forge = world->forge();
+
+	// LV2Block::instantiate() via the plugin
+	const double instantiate_us =
+		time_puts(n, "/b", forge.make_urid(URI(plugin)));
+
+	// LV2Block::duplicate() of the first block
+	const double duplicate_us = time_puts(
+		n, "/c", forge.make_urid(path_to_uri(raul::Path("/b0"))));
+
+	if (count_blocks() != 2 * size_t{n}) {
+		std::cerr << "error: " << count_blocks() << " of " << 2 * n
+		          << " blocks created\n";
+		return false;
+	}
+
+	const auto log = open_log(out_file,
+	                          "# plugin\tblocks\tinstantiate_us\tduplicate_us");
+
+	fprintf(log.get(), "%s\t%u\t%f\t%f\n",
+	        plugin.c_str(), n, instantiate_us, duplicate_us);
+
+	return true;
+}
+
 int
 run(int argc, char** argv)
 {
@@ -63,9 +431,29 @@ run(int argc, char** argv)
 	try {
 		world = std::make_unique<ingen::World>(nullptr, nullptr, nullptr);
 
+		ingen::Forge& forge = world->forge();
 		world->conf().add(
 			"output", "output", 'O', "File to write benchmark output",
-			ingen::Configuration::SESSION, world->forge().String, Atom());
+			ingen::Configuration::SESSION, forge.String, Atom());
+		world->conf().add(
+			"topology", "topology", 0,
+			"Generated graph (chain, fanout, diamond, poly, sequence)",
+			ingen::Configuration::SESSION, forge.String, Atom());
+		world->conf().add(
+			"size", "size", 0, "Size parameter of generated graph",
+			ingen::Configuration::SESSION, forge.Int, forge.make(16));
+		world->conf().add(
+			"frames", "frames", 0, "Number of frames to run",
+			ingen::Configuration::SESSION, forge.Int, forge.make(1 << 20));
+		world->conf().add(
+			"histogram", "histogram", 0, "File to write cycle time histogram",
+			ingen::Configuration::SESSION, forge.String, Atom());
+		world->conf().add(
+			"loadOutput", "load-output", 0, "File to write graph load time",
+			ingen::Configuration::SESSION, forge.String, Atom());
+		world->conf().add(
+			"plugin", "plugin", 0, "Plugin to time block creation with",
+			ingen::Configuration::SESSION, forge.String, Atom());
 		world->load_configuration(argc, argv);
 	} catch (std::exception& e) {
 		std::cout << "ingen: " << e.what() << "\n";
@@ -73,24 +461,41 @@ run(int argc, char** argv)
 	}
 
 	// Get mandatory command line arguments
-	const Atom& load = world->conf().option("load");
-	const Atom& out  = world->conf().option("output");
-	if (!load.is_valid() || !out.is_valid()) {
-		std::cerr << "Usage: ingen_bench --load START_GRAPH --output OUT_FILE\n";
+	const Atom& load     = world->conf().option("load");
+	const Atom& topology = world->conf().option("topology");
+	const Atom& plugin   = world->conf().option("plugin");
+	const Atom& out      = world->conf().option("output");
+	if ((!load.is_valid() && !topology.is_valid() && !plugin.is_valid()) ||
+	    !out.is_valid()) {
+		std::cerr << "Usage: ingen_bench --load START_GRAPH [--load-threads N] "
+		             "[--load-output LOAD_FILE] --output OUT_FILE\n"
+		          << "       ingen_bench --topology NAME [--size N] "
+		             "--output OUT_FILE\n"
+		          << "       ingen_bench --plugin URI [--size N] "
+		             "--output OUT_FILE\n";
 		return EXIT_FAILURE;
 	}
 
 	// Get start graph and output file options
-	const std::string start_graph =
-	    real_path(static_cast<const char*>(load.get_body()));
+	std::string start_graph;
+	if (load.is_valid()) {
+		start_graph = real_path(static_cast<const char*>(load.get_body()));
+		if (start_graph.empty()) {
+			std::cerr << "error: initial graph '"
+			          << static_cast<const char*>(load.get_body())
+			          << "' does not exist\n";
+			return EXIT_FAILURE;
+		}
+	}
 
 	const std::string out_file = static_cast<const char*>(out.get_body());
-	if (start_graph.empty()) {
-		std::cerr << "error: initial graph '"
-		          << static_cast<const char*>(load.get_body())
-		          << "' does not exist\n";
-		return EXIT_FAILURE;
-	}
+	const auto size = static_cast<uint32_t>(
+		world->conf().option("size").get<int32_t>());
+	const auto block_length = static_cast<uint32_t>(
+		world->conf().option("buffer-size").get<int32_t>());
+	const auto n_test_frames = static_cast<uint32_t>(
+		world->conf().option("frames").get<int32_t>());
+	const int32_t n_threads = world->conf().option("threads").get<int32_t>();
 
 	// Load modules
 	ingen_try(world->load_module("server"),
@@ -99,41 +504,141 @@ run(int argc, char** argv)
 	// Initialise engine
 	ingen_try(!!world->engine(),
 	          "Unable to create engine");
-	world->engine()->init(48000.0, 4096, 4096);
+	world->engine()->init(48000.0, block_length, 4096);
 	world->engine()->activate();
 
-	// Load graph
-	if (!world->parser()->parse_file(*world, *world->interface(), start_graph)) {
-		std::cerr << "error: failed to load initial graph " << start_graph
-		          << "\n";
+	// Fail on any error response, such as a rejected connection
+	const std::shared_ptr<Interface> client{new TestClient(world->log())};
 
-		return EXIT_FAILURE;
+	world->interface()->set_respondee(client);
+	world->interface()->set_response_id(1);
+	world->engine()->register_client(client);
+
+	// Time block creation only, without running the engine
+	if (plugin.is_valid()) {
+		const bool success = bench_blocks(
+			static_cast<const char*>(plugin.get_body()), size, out_file);
+
+		world->engine()->deactivate();
+		return success ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	using Clock = std::chrono::steady_clock;
+
+	// Load or generate graph
+	std::string name;
+	bool        notes = false;
+	if (!start_graph.empty()) {
+		name = start_graph;
+
+		// Load in a bundle so the engine can create blocks in parallel
+		const int32_t load_threads =
+			world->conf().option("load-threads").get<int32_t>();
+
+		const Clock::time_point load_start = Clock::now();
+		if (load_threads > 1) {
+			world->interface()->bundle_begin();
+		}
+
+		if (!world->parser()->parse_file(*world, *world->interface(), start_graph)) {
+			std::cerr << "error: failed to load initial graph " << start_graph
+			          << "\n";
+
+			return EXIT_FAILURE;
+		}
+
+		if (load_threads > 1) {
+			world->interface()->bundle_end();
+		}
+
+		// Time until every event of the load has been processed
+		world->engine()->flush_events(std::chrono::milliseconds(1));
+		const double load_ms = std::chrono::duration<double, std::milli>(
+			Clock::now() - load_start).count();
+
+		const Atom& load_out = world->conf().option("load-output");
+		if (load_out.is_valid()) {
+			const auto log =
+				open_log(static_cast<const char*>(load_out.get_body()),
+				         "# graph\tload_threads\tblocks\tload_ms");
+
+			fprintf(log.get(), "%s\t%d\t%zu\t%f\n",
+			        name.c_str(), load_threads, count_blocks(), load_ms);
+		}
+	} else {
+		name = static_cast<const char*>(topology.get_body());
+		if (!build_graph(name, size, notes)) {
+			std::cerr << "error: unknown topology '" << name << "'\n";
+			return EXIT_FAILURE;
+		}
 	}
 	world->engine()->flush_events(std::chrono::milliseconds(20));
 
-	// Run benchmark
+	if (start_graph.empty() && count_arcs() != n_connects) {
+		std::cerr << "error: " << count_arcs() << " of " << n_connects
+		          << " connections made\n";
+		return EXIT_FAILURE;
+	}
+
+	// Run a few cycles first so that buffers and caches are warm
+	const uint32_t n_warmup_cycles = 64;
+	for (uint32_t i = 0; i < n_warmup_cycles; ++i) {
+		if (notes) {
+			drive_notes(i);
+		}
+
+		world->engine()->advance(block_length);
+		world->engine()->run(block_length);
+	}
+
+	// Run benchmark, timing every cycle
 	// TODO: Set up real-time scheduling for this and worker threads
-	const ingen::Clock clock;
-	const uint32_t     n_test_frames = 1 << 20;
-	const uint32_t     block_length  = 4096;
-	const uint64_t     t_start       = clock.now_microseconds();
-	for (uint32_t i = 0; i < n_test_frames; i += block_length) {
+	const uint32_t      n_cycles = std::max(1U, n_test_frames / block_length);
+	std::vector<double> times(n_cycles);
+	for (uint32_t i = 0; i < n_cycles; ++i) {
+		if (notes) {
+			drive_notes(n_warmup_cycles + i);
+		}
+
 		world->engine()->advance(block_length);
+
+		const Clock::time_point t_start = Clock::now();
 		world->engine()->run(block_length);
-		//world->engine()->main_iteration();
+		const Clock::time_point t_end = Clock::now();
+
+		times[i] = std::chrono::duration<double, std::micro>(t_end - t_start)
+		               .count();
 	}
-	const uint64_t t_end = clock.now_microseconds();
+
+	// Calculate statistics
+	double total = 0.0;
+	for (const double t : times) {
+		total += t;
+	}
+
+	std::sort(times.begin(), times.end());
+
+	const double mean      = total / n_cycles;
+	const double period_us = block_length * 1000000.0 / 48000.0;
 
 	// Write log output
-	const std::unique_ptr<FILE, int (*)(FILE*)> log{fopen(out_file.c_str(), "a"),
-	                                                &fclose};
-	if (ftell(log.get()) == 0) {
-		fprintf(log.get(), "# n_threads\trun_time\treal_time\n");
+	{
+		const auto log = open_log(out_file,
+		                          "# topology\tsize\tn_threads\tblock_length\t"
+		                          "cycles\tmean_us\tp50_us\tp99_us\tmax_us\tload");
+
+		fprintf(log.get(), "%s\t%u\t%d\t%u\t%u\t%f\t%f\t%f\t%f\t%f\n",
+		        name.c_str(), start_graph.empty() ? size : 0U, n_threads,
+		        block_length, n_cycles, mean, percentile(times, 0.5),
+		        percentile(times, 0.99), times.back(), mean / period_us);
+	}
+
+	const Atom& histogram = world->conf().option("histogram");
+	if (histogram.is_valid()) {
+		write_histogram(static_cast<const char*>(histogram.get_body()),
+		                name, start_graph.empty() ? size : 0U, n_threads,
+		                block_length, times);
 	}
-	fprintf(log.get(), "%d\t%f\t%f\n",
-	        world->conf().option("threads").get<int32_t>(),
-	        static_cast<double>(t_end - t_start) / 1000000.0,
-	        (n_test_frames / 48000.0));
 
 	// Shut down
 	world->engine()->deactivate();
@@ -0,0 +1,322 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SequenceMerger.hpp"
+#include "mix_kernels.hpp"
+#include "types.hpp"
+
+#include <lv2/atom/atom.h>
+#include <lv2/atom/util.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace ingen::bench {
+namespace {
+
+using ingen::server::MixAudioKernel;
+using ingen::server::MixAudioKernelInfo;
+using ingen::server::SequenceMerger;
+
+using Clock  = std::chrono::steady_clock;
+using Events = std::vector<const LV2_Atom_Event*>;
+
+/** The original mixing code: copy the first source, then add each other. */
+void
+reference_mix(Sample*              dst,
+              const Sample* const* srcs,
+              uint32_t             n_srcs,
+              Sample               offset,
+              uint32_t             n_frames)
+{
+	std::copy(srcs[0], srcs[0] + n_frames, dst);
+	for (uint32_t i = 1; i < n_srcs; ++i) {
+		for (uint32_t j = 0; j < n_frames; ++j) {
+			dst[j] += srcs[i][j];
+		}
+	}
+
+	for (uint32_t j = 0; j < n_frames; ++j) {
+		dst[j] += offset;
+	}
+}
+
+/** Return the mean time to mix a block in nanoseconds. */
+double
+time_kernel(MixAudioKernel             kernel,
+            std::vector<Sample>&       dst,
+            const std::vector<Sample*>& srcs,
+            uint32_t                   n_frames)
+{
+	const auto n_srcs = static_cast<uint32_t>(srcs.size());
+
+	// Run for roughly the same number of samples in every configuration
+	const uint32_t n_runs = std::max(
+		16U, (1U << 24U) / (n_frames * n_srcs));
+
+	kernel(dst.data(), srcs.data(), n_srcs, 0.5f, n_frames); // Warm up
+
+	const Clock::time_point start = Clock::now();
+	for (uint32_t r = 0; r < n_runs; ++r) {
+		kernel(dst.data(), srcs.data(), n_srcs, 0.5f, n_frames);
+	}
+	const Clock::time_point end = Clock::now();
+
+	return std::chrono::duration<double, std::nano>(end - start).count() /
+	       n_runs;
+}
+
+/** Check a mix result against the reference, allowing for rounding. */
+int
+check_mix(const char*                name,
+          const std::vector<Sample>& dst,
+          const std::vector<Sample>& expected,
+          uint32_t                   n_srcs,
+          uint32_t                   n_frames)
+{
+	for (uint32_t j = 0; j < n_frames; ++j) {
+		if (std::fabs(dst[j] - expected[j]) > 1.0e-4f * static_cast<float>(n_srcs)) {
+			fprintf(stderr, "error: %s result %f != %f at %u\n",
+			        name, dst[j], expected[j], j);
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int
+run_audio()
+{
+	static const uint32_t n_sources[]   = {2U, 4U, 8U, 32U, 33U};
+	static const uint32_t block_sizes[] = {64U, 256U, 1024U, 4096U};
+
+	const std::vector<MixAudioKernelInfo> kernels =
+		ingen::server::supported_mix_audio_kernels();
+
+	printf("# kernel\tsources\tframes\tns_per_block\tspeedup\n");
+
+	int status = EXIT_SUCCESS;
+	for (const uint32_t n_srcs : n_sources) {
+		for (const uint32_t n_frames : block_sizes) {
+			// Allocate sources with odd lengths to exercise unaligned tails
+			std::vector<std::vector<Sample>> bufs(n_srcs);
+			std::vector<Sample*>             srcs(n_srcs);
+			for (uint32_t i = 0; i < n_srcs; ++i) {
+				bufs[i].resize(n_frames + 1);
+				for (uint32_t j = 0; j < n_frames; ++j) {
+					bufs[i][j] = static_cast<Sample>(rand() % 1000) / 1000.0f - 0.5f;
+				}
+				srcs[i] = bufs[i].data() + 1;
+			}
+
+			std::vector<Sample> expected(n_frames);
+			std::vector<Sample> dst(n_frames);
+			reference_mix(expected.data(), srcs.data(), n_srcs, 0.5f, n_frames - 1);
+
+			const double ref_ns = time_kernel(reference_mix, dst, srcs, n_frames - 1);
+			printf("reference\t%u\t%u\t%.1f\t%.2f\n",
+			       n_srcs, n_frames - 1, ref_ns, 1.0);
+
+			for (const auto& k : kernels) {
+				const double ns = time_kernel(k.kernel, dst, srcs, n_frames - 1);
+				printf("%s\t%u\t%u\t%.1f\t%.2f\n",
+				       k.name, n_srcs, n_frames - 1, ns, ref_ns / ns);
+
+				// Check the result, allowing for different rounding
+				status |= check_mix(k.name, dst, expected, n_srcs, n_frames - 1);
+
+				// Accumulate onto the first source, as mix_audio() does
+				std::vector<Sample> first(srcs[0], srcs[0] + n_frames - 1);
+				std::vector<Sample*> aliased(srcs);
+				aliased[0] = first.data();
+				k.kernel(first.data(), aliased.data(), n_srcs, 0.5f, n_frames - 1);
+				status |= check_mix(k.name, first, expected, n_srcs, n_frames - 1);
+			}
+		}
+	}
+
+	return status;
+}
+
+/** Build a sequence of MIDI events at sorted random times in a block. */
+std::vector<uint64_t>
+make_sequence(uint32_t n_events, uint32_t n_frames)
+{
+	static constexpr uint32_t ev_size = sizeof(LV2_Atom_Event) + 8U;
+
+	std::vector<int64_t> times(n_events);
+	for (auto& t : times) {
+		t = rand() % n_frames;
+	}
+	std::sort(times.begin(), times.end());
+
+	// Use 64-bit words so the sequence is suitably aligned
+	std::vector<uint64_t> buf(
+		(sizeof(LV2_Atom_Sequence) + (n_events * ev_size)) / sizeof(uint64_t));
+
+	auto* const seq = reinterpret_cast<LV2_Atom_Sequence*>(buf.data());
+	seq->atom.size  = sizeof(LV2_Atom_Sequence_Body) + (n_events * ev_size);
+	seq->atom.type  = 1U;
+
+	auto* ev = lv2_atom_sequence_begin(&seq->body);
+	for (const int64_t t : times) {
+		static const uint8_t note_on[] = {0x90U, 0x40U, 0x7FU};
+
+		ev->time.frames = t;
+		ev->body.size   = sizeof(note_on);
+		ev->body.type   = 2U;
+		memcpy(ev + 1, note_on, sizeof(note_on));
+		ev = lv2_atom_sequence_next(ev);
+	}
+
+	return buf;
+}
+
+/** The original sequence merge, which scans every source for each event. */
+void
+scan_merge(const std::vector<const LV2_Atom_Sequence*>& seqs, Events& out)
+{
+	const LV2_Atom_Event* iters[256];
+	for (size_t i = 0; i < seqs.size(); ++i) {
+		iters[i] = lv2_atom_sequence_begin(&seqs[i]->body);
+		if (lv2_atom_sequence_is_end(&seqs[i]->body, seqs[i]->atom.size, iters[i])) {
+			iters[i] = nullptr;
+		}
+	}
+
+	while (true) {
+		const LV2_Atom_Event* first   = nullptr;
+		size_t                first_i = 0;
+		for (size_t i = 0; i < seqs.size(); ++i) {
+			const LV2_Atom_Event* const ev = iters[i];
+			if (!first || (ev && ev->time.frames < first->time.frames)) {
+				first   = ev;
+				first_i = i;
+			}
+		}
+
+		if (!first) {
+			break;
+		}
+
+		out.push_back(first);
+		iters[first_i] = lv2_atom_sequence_next(first);
+		if (lv2_atom_sequence_is_end(&seqs[first_i]->body,
+		                             seqs[first_i]->atom.size,
+		                             iters[first_i])) {
+			iters[first_i] = nullptr;
+		}
+	}
+}
+
+/** Merge sequences with a heap, as mix() does. */
+void
+heap_merge(const std::vector<const LV2_Atom_Sequence*>& seqs, Events& out)
+{
+	static SequenceMerger merger{256U};
+
+	merger.clear();
+	for (const auto* seq : seqs) {
+		merger.add(seq);
+	}
+
+	while (const LV2_Atom_Event* const ev = merger.next()) {
+		out.push_back(ev);
+	}
+}
+
+/** Return the mean time to merge sequences in nanoseconds. */
+template<typename Merge>
+double
+time_merge(Merge                                        merge,
+           const std::vector<const LV2_Atom_Sequence*>& seqs,
+           Events&                                      out)
+{
+	static constexpr uint32_t n_runs = 2000U;
+
+	const Clock::time_point start = Clock::now();
+	for (uint32_t r = 0; r < n_runs; ++r) {
+		out.clear();
+		merge(seqs, out);
+	}
+	const Clock::time_point end = Clock::now();
+
+	return std::chrono::duration<double, std::nano>(end - start).count() /
+	       n_runs;
+}
+
+int
+run_sequence()
+{
+	static const uint32_t n_sources[] = {2U, 4U, 8U, 16U, 32U, 128U};
+	static const uint32_t n_events[]  = {4U, 32U};
+	static const uint32_t n_frames    = 1024U;
+
+	printf("# merge\tsources\tevents\tns_per_block\tspeedup\n");
+
+	int status = EXIT_SUCCESS;
+	for (const uint32_t n_srcs : n_sources) {
+		for (const uint32_t n_evs : n_events) {
+			std::vector<std::vector<uint64_t>>    bufs;
+			std::vector<const LV2_Atom_Sequence*> seqs;
+			for (uint32_t i = 0; i < n_srcs; ++i) {
+				bufs.push_back(make_sequence(n_evs, n_frames));
+				seqs.push_back(
+					reinterpret_cast<const LV2_Atom_Sequence*>(bufs.back().data()));
+			}
+
+			Events expected;
+			Events actual;
+			expected.reserve(n_srcs * n_evs);
+			actual.reserve(n_srcs * n_evs);
+
+			const double scan_ns = time_merge(scan_merge, seqs, expected);
+			const double heap_ns = time_merge(heap_merge, seqs, actual);
+
+			printf("scan\t%u\t%u\t%.1f\t%.2f\n", n_srcs, n_evs, scan_ns, 1.0);
+			printf("heap\t%u\t%u\t%.1f\t%.2f\n",
+			       n_srcs, n_evs, heap_ns, scan_ns / heap_ns);
+
+			if (actual != expected) {
+				fprintf(stderr,
+				        "error: heap merge of %u sources differs from scan\n",
+				        n_srcs);
+				status = EXIT_FAILURE;
+			}
+		}
+	}
+
+	return status;
+}
+
+} // namespace
+} // namespace ingen::bench
+
+int
+main()
+{
+	const int audio_status    = ingen::bench::run_audio();
+	const int sequence_status = ingen::bench::run_sequence();
+
+	return audio_status ? audio_status : sequence_status;
+}
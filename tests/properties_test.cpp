@@ -0,0 +1,189 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/* Tests of URI copies and URID-keyed properties. */
+
+#include <ingen/Atom.hpp>
+#include <ingen/FilePath.hpp>
+#include <ingen/Forge.hpp>
+#include <ingen/Properties.hpp>
+#include <ingen/URI.hpp>
+#include <ingen/URIDProperties.hpp>
+#include <ingen/URIMap.hpp>
+#include <ingen/URIs.hpp>
+#include <ingen/World.hpp>
+#include <lv2/urid/urid.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+namespace ingen::test {
+namespace {
+
+int n_failures = 0;
+
+void
+check(bool condition, const char* file, int line, const char* expr)
+{
+	if (!condition) {
+		fprintf(stderr, "%s:%d: error: check failed: %s\n", file, line, expr);
+		++n_failures;
+	}
+}
+
+#define CHECK(expr) check((expr), __FILE__, __LINE__, #expr)
+
+/// Return true iff `chunk` is empty or lies within the string of `uri`
+bool
+in_buffer(const URI& uri, const URI::Chunk& chunk)
+{
+	return chunk.empty() || (chunk.data() >= uri.begin() &&
+	                         chunk.data() + chunk.size() <= uri.end());
+}
+
+/// Check that `copy` has the parts of a URI equal to `expected`
+void
+check_parts(const URI& copy, const URI& expected)
+{
+	CHECK(copy == expected);
+	CHECK(copy.string() == expected.string());
+	CHECK(copy.scheme() == expected.scheme());
+	CHECK(copy.authority() == expected.authority());
+	CHECK(copy.path() == expected.path());
+	CHECK(copy.query() == expected.query());
+	CHECK(copy.fragment() == expected.fragment());
+
+	CHECK(in_buffer(copy, copy.scheme()));
+	CHECK(in_buffer(copy, copy.authority()));
+	CHECK(in_buffer(copy, copy.path()));
+	CHECK(in_buffer(copy, copy.query()));
+	CHECK(in_buffer(copy, copy.fragment()));
+}
+
+void
+test_uri_copy()
+{
+	const URI expected("http://example.org:8080/a/b?k=v#frag");
+
+	// Copies point into their own node, so outlive the original
+	auto original = std::make_unique<URI>(expected.string());
+	URI  copy(*original);
+	CHECK(copy.c_str() != original->c_str());
+	check_parts(copy, *original);
+	original.reset();
+	check_parts(copy, expected);
+
+	// Assignment replaces both the node and the parsed parts
+	URI assigned("file:///tmp/x");
+	assigned = copy;
+	CHECK(assigned.c_str() != copy.c_str());
+	check_parts(assigned, expected);
+
+	// Self-assignment leaves the URI intact
+	const char* const data = assigned.c_str();
+	const URI&        self = assigned;
+	assigned = self;
+	CHECK(assigned.c_str() == data);
+	check_parts(assigned, expected);
+
+	// URIs resolved against a base and file URIs copy the same way
+	const URI base("http://example.org/dir/");
+	const URI resolved("sub/file?q", base);
+	check_parts(URI(resolved), resolved);
+
+	const URI file(FilePath("/tmp/some file"));
+	const URI file_copy(file);
+	check_parts(file_copy, file);
+	CHECK(file_copy.file_path() == file.file_path());
+
+	// Copies of null URIs are null
+	const URI empty;
+	const URI empty_copy(empty);
+	CHECK(empty_copy.empty());
+	CHECK(empty_copy.length() == 0U);
+}
+
+void
+test_urid_properties(World& world)
+{
+	URIMap&     map   = world.uri_map();
+	const URIs& uris  = world.uris();
+	Forge&      forge = world.forge();
+
+	// Values are sorted by key, and values with equal keys stay in order
+	URIDProperties props;
+	props.put(uris.rdf_type, uris.ingen_Block);
+	props.put(uris.lv2_name, forge.alloc("name"));
+	props.put(uris.rdf_type, uris.ingen_Graph, Property::Graph::INTERNAL);
+
+	CHECK(props.size() == 3U);
+	CHECK(props.count(uris.rdf_type) == 2U);
+	CHECK(props.count(uris.lv2_index) == 0U);
+	CHECK(props.find(uris.lv2_index) == props.end());
+	CHECK(props.find(uris.rdf_type)->second == uris.ingen_Block);
+	CHECK(props.contains(uris.rdf_type, uris.ingen_Graph.urid_atom()));
+	CHECK(!props.contains(uris.rdf_type, uris.lv2_InputPort.urid_atom()));
+
+	LV2_URID last = 0;
+	for (const auto& p : props) {
+		CHECK(p.first >= last);
+		last = p.first;
+	}
+
+	const auto types = props.equal_range(uris.rdf_type);
+	CHECK(types.second - types.first == 2);
+	CHECK(types.first->second == uris.ingen_Block);
+	CHECK((types.first + 1)->second == uris.ingen_Graph);
+	CHECK((types.first + 1)->second.context() == Property::Graph::INTERNAL);
+
+	CHECK(props.erase(uris.rdf_type) == 2U);
+	CHECK(props.size() == 1U);
+	CHECK(props.count(uris.lv2_name) == 1U);
+
+	// Conversion keeps every value and the order of values with equal keys
+	const URI        key("http://example.org/key");
+	const Properties uri_props{
+		{uris.rdf_type, Property(uris.ingen_Graph)},
+		{key, Property(forge.make(1), Property::Graph::EXTERNAL)},
+		{uris.rdf_type, Property(uris.ingen_Block)}};
+
+	const URIDProperties urid_props(map, uri_props);
+	CHECK(urid_props.size() == 3U);
+	CHECK(urid_props.count(map.map_uri(key.c_str())) == 1U);
+	CHECK(urid_props.find(uris.rdf_type)->second == uris.ingen_Graph);
+
+	const Properties round_trip = urid_props.to_properties(map);
+	CHECK(round_trip == uri_props);
+	CHECK(round_trip.find(key)->second.context() ==
+	      Property::Graph::EXTERNAL);
+}
+
+} // namespace
+} // namespace ingen::test
+
+int
+main()
+{
+	ingen::World world{nullptr, nullptr, nullptr};
+
+	ingen::test::test_uri_copy();
+	ingen::test::test_urid_properties(world);
+
+	return ingen::test::n_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,295 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/* Unit tests for header-only parts of the engine. */
+
+#include "SequenceMerger.hpp"
+#include "TurtleSplitter.hpp"
+#include "VoiceMask.hpp"
+#include "mix_kernels.hpp"
+#include "types.hpp"
+
+#include <lv2/atom/atom.h>
+#include <lv2/atom/util.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace ingen::test {
+namespace {
+
+using ingen::server::MixAudioKernelInfo;
+using ingen::server::SequenceMerger;
+using ingen::server::TurtleSplitter;
+using ingen::server::VoiceMask;
+
+int n_failures = 0;
+
+void
+check(bool condition, const char* file, int line, const char* expr)
+{
+	if (!condition) {
+		fprintf(stderr, "%s:%d: error: check failed: %s\n", file, line, expr);
+		++n_failures;
+	}
+}
+
+#define CHECK(expr) check((expr), __FILE__, __LINE__, #expr)
+
+void
+test_voice_mask()
+{
+	static constexpr SampleCount release = 1000U;
+	static constexpr SampleCount block   = 64U;
+
+	// Without an allocator, every voice is always active
+	VoiceMask unclaimed{release};
+	CHECK(unclaimed.active(0U, 0U));
+	CHECK(unclaimed.active(3U, 10U * release));
+
+	// Without a release time, even a claimed mask skips nothing
+	VoiceMask no_release{0U};
+	no_release.claim(block);
+	CHECK(no_release.active(3U, 10U * release));
+
+	// While claimed, voices are active until the release time passes
+	VoiceMask mask{release};
+	FrameTime now = 0U;
+	for (; now < 4U * release; now += block) {
+		mask.claim(now + block);
+		mask.touch(1U, now + block);
+		CHECK(mask.active(1U, now));
+	}
+
+	CHECK(mask.active(1U, now));
+	CHECK(!mask.active(2U, now));
+	CHECK(mask.released(2U, now));
+	CHECK(!mask.released(1U, now));
+
+	// A released voice stays active for the release time, then is skipped
+	const FrameTime released_at = now;
+	for (; now < released_at + (2U * release); now += block) {
+		mask.claim(now + block);
+		CHECK(mask.active(1U, now) == (now < released_at + release));
+	}
+
+	// Touching a released voice makes it active again
+	mask.touch(1U, now);
+	CHECK(mask.active(1U, now));
+
+	// Once the claim expires, every voice is active again
+	const FrameTime expired_at = now + release;
+	CHECK(!mask.active(2U, expired_at - 1U));
+	CHECK(mask.active(2U, expired_at));
+	CHECK(mask.active(3U, expired_at + (10U * release)));
+
+	// Out of range voices are always active
+	CHECK(mask.active(VoiceMask::max_voices, now));
+}
+
+void
+test_mix_aliasing()
+{
+	static constexpr uint32_t n_srcs   = 40U;
+	static constexpr uint32_t n_frames = 100U;
+	static constexpr uint32_t max_srcs = 32U; // Batch size of mix_audio()
+
+	std::vector<std::vector<Sample>> bufs(n_srcs, std::vector<Sample>(n_frames));
+	for (uint32_t i = 0; i < n_srcs; ++i) {
+		for (uint32_t j = 0; j < n_frames; ++j) {
+			bufs[i][j] = static_cast<Sample>((i * 7U) + j);
+		}
+	}
+
+	for (const MixAudioKernelInfo& k : ingen::server::supported_mix_audio_kernels()) {
+		// Mix in batches, continuing each batch onto the output like mix_audio()
+		std::vector<Sample>        out(n_frames);
+		std::vector<const Sample*> srcs;
+		for (uint32_t i = 0; i < n_srcs; ++i) {
+			if (srcs.size() == max_srcs) {
+				k.kernel(out.data(), srcs.data(), max_srcs, 0.0f, n_frames);
+				srcs = {out.data()};
+			}
+			srcs.push_back(bufs[i].data());
+		}
+		k.kernel(out.data(),
+		         srcs.data(),
+		         static_cast<uint32_t>(srcs.size()),
+		         0.5f,
+		         n_frames);
+
+		for (uint32_t j = 0; j < n_frames; ++j) {
+			const auto expected = static_cast<Sample>(
+				(7U * (n_srcs * (n_srcs - 1U) / 2U)) + (n_srcs * j)) + 0.5f;
+			if (std::fabs(out[j] - expected) > 1.0e-3f) {
+				fprintf(stderr, "error: %s mixed %f != %f at %u\n",
+				        k.name, out[j], expected, j);
+				++n_failures;
+				break;
+			}
+		}
+	}
+}
+
+/** Build a sequence of empty events at the given times. */
+std::vector<uint64_t>
+make_sequence(const std::vector<int64_t>& times)
+{
+	// Use 64-bit words so the sequence is suitably aligned
+	std::vector<uint64_t> buf(
+		(sizeof(LV2_Atom_Sequence) + (times.size() * sizeof(LV2_Atom_Event))) /
+		sizeof(uint64_t));
+
+	auto* const seq = reinterpret_cast<LV2_Atom_Sequence*>(buf.data());
+	seq->atom.size  = static_cast<uint32_t>(
+		sizeof(LV2_Atom_Sequence_Body) + (times.size() * sizeof(LV2_Atom_Event)));
+
+	auto* ev = lv2_atom_sequence_begin(&seq->body);
+	for (const int64_t t : times) {
+		ev->time.frames = t;
+		ev->body.size   = 0U;
+		ev->body.type   = 1U;
+		ev              = lv2_atom_sequence_next(ev);
+	}
+
+	return buf;
+}
+
+const LV2_Atom_Sequence*
+as_sequence(const std::vector<uint64_t>& buf)
+{
+	return reinterpret_cast<const LV2_Atom_Sequence*>(buf.data());
+}
+
+void
+test_sequence_merger()
+{
+	const std::vector<uint64_t> a = make_sequence({0, 5, 5, 9});
+	const std::vector<uint64_t> b = make_sequence({1, 5});
+	const std::vector<uint64_t> c = make_sequence({});
+	const std::vector<uint64_t> d = make_sequence({2});
+
+	const auto* const seq_a = as_sequence(a);
+	const auto* const seq_b = as_sequence(b);
+	const auto* const seq_c = as_sequence(c);
+	const auto* const seq_d = as_sequence(d);
+
+	// Empty sources take no space, but a full merger rejects more
+	SequenceMerger merger{2U};
+	CHECK(merger.capacity() == 2U);
+	CHECK(merger.add(seq_a));
+	CHECK(merger.add(seq_c));
+	CHECK(merger.add(seq_b));
+	CHECK(!merger.add(seq_d));
+	CHECK(merger.size() == 2U);
+
+	// Events are in time order, then in the order sources were added
+	const LV2_Atom_Event* const a_begin = lv2_atom_sequence_begin(&seq_a->body);
+	const LV2_Atom_Event* const b_begin = lv2_atom_sequence_begin(&seq_b->body);
+	const LV2_Atom_Event* const b_5     = lv2_atom_sequence_next(b_begin);
+
+	std::vector<int64_t>               times;
+	std::vector<const LV2_Atom_Event*> events;
+	while (const LV2_Atom_Event* const ev = merger.next()) {
+		times.push_back(ev->time.frames);
+		events.push_back(ev);
+	}
+
+	CHECK((times == std::vector<int64_t>{0, 1, 5, 5, 5, 9}));
+	CHECK(events.size() == 6U && events[0] == a_begin && events[1] == b_begin);
+	CHECK(events.size() == 6U && events[4] == b_5);
+
+	// A cleared merger can be reused
+	merger.clear();
+	CHECK(merger.empty());
+	CHECK(merger.add(seq_d));
+	CHECK(merger.next() && !merger.next());
+}
+
+/** Split `text` into statements, as it arrives in chunks of `chunk` bytes. */
+std::vector<std::string>
+split(const std::string& text, size_t chunk)
+{
+	std::vector<std::string> statements;
+	TurtleSplitter           splitter;
+	std::string              input;
+	for (size_t i = 0U; i < text.size(); i += chunk) {
+		input += text.substr(i, chunk);
+
+		size_t offset = 0U;
+		size_t end    = 0U;
+		while ((end = splitter.next(input.data(), input.size()))) {
+			statements.push_back(input.substr(offset, end - offset));
+			offset = end;
+		}
+
+		input.erase(0U, offset);
+		splitter.consumed(offset);
+	}
+
+	return statements;
+}
+
+void
+test_turtle_splitter()
+{
+	// Dots that do not end a statement, in every context the splitter tracks
+	const std::vector<std::string> expected{
+		"<a.b> <p> \"x. y\" .",
+		"\n<a> <p> 1.5, ex:x.y .",
+		"\n# Not the end.\n<a> <p> [ <q> \"in. blank\" ] .",
+		"\n<a> <p> \"\"\"Long. \"quoted\" \\\"\"\"\" .",
+		"\n<a> <p> 'single. \\' quote' .",
+		"\n[] <p> <o>.",
+	};
+
+	std::string text;
+	for (const auto& s : expected) {
+		text += s;
+	}
+	text += "\n";
+
+	// The same statements are found regardless of how input arrives
+	for (const size_t chunk : {1U, 2U, 3U, 7U, 4096U}) {
+		const std::vector<std::string> statements = split(text, chunk);
+		CHECK(statements == expected);
+	}
+
+	// A final dot is not the end until the next character shows it is
+	CHECK(split("<a> <p> <o> .", 4096U).empty());
+	CHECK(split(std::string("<a> <p> <o> .") + '\0', 4096U).size() == 1U);
+	CHECK(split("<a> <p> ex:o.", 4096U).empty());
+	CHECK(split("<a> <p> \"\"\"open .\" .\n", 4096U).empty());
+}
+
+} // namespace
+} // namespace ingen::test
+
+int
+main()
+{
+	ingen::test::test_voice_mask();
+	ingen::test::test_mix_aliasing();
+	ingen::test::test_sequence_merger();
+	ingen::test::test_turtle_splitter();
+
+	return ingen::test::n_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
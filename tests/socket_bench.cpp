@@ -0,0 +1,174 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <ingen/Atom.hpp>
+#include <ingen/Forge.hpp>
+#include <ingen/Interface.hpp>
+#include <ingen/Message.hpp>
+#include <ingen/Resource.hpp>
+#include <ingen/SocketReader.hpp>
+#include <ingen/SocketWriter.hpp>
+#include <ingen/URI.hpp>
+#include <ingen/WireFormat.hpp>
+#include <ingen/World.hpp>
+#include <ingen/paths.hpp>
+#include <raul/Path.hpp>
+#include <raul/Socket.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <variant>
+#include <vector>
+
+namespace ingen::bench {
+namespace {
+
+constexpr uint32_t max_clients = 8;    ///< Largest number of connections
+constexpr int32_t  n_messages  = 4096; ///< Messages sent by each client
+
+/** Interface that counts the set messages read from a connection. */
+class CountingClient : public Interface
+{
+public:
+	URI uri() const override { return URI("ingen:/clients/bench"); }
+
+	void message(const Message& msg) override {
+		if (std::get_if<SetProperty>(&msg)) {
+			++_n_received;
+		}
+	}
+
+	uint32_t n_received() const { return _n_received; }
+
+private:
+	std::atomic<uint32_t> _n_received{0};
+};
+
+/** Return the messages per second read from `n_clients` connections. */
+double
+run_connections(World& world, WireFormat format, uint32_t n_clients)
+{
+	using Clock = std::chrono::steady_clock;
+
+	const URI key("http://drobilla.net/ns/ingen#benchValue");
+
+	std::vector<std::unique_ptr<CountingClient>> clients;
+	std::vector<std::unique_ptr<SocketReader>>   readers;
+	std::vector<std::shared_ptr<raul::Socket>>   write_socks;
+	for (uint32_t i = 0; i < n_clients; ++i) {
+		int fds[2] = {-1, -1};
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+			return 0.0;
+		}
+
+		auto read_sock = std::make_shared<raul::Socket>(
+			raul::Socket::Type::UNIX, "", nullptr, 0, fds[0]);
+
+		write_socks.emplace_back(std::make_shared<raul::Socket>(
+			raul::Socket::Type::UNIX, "", nullptr, 0, fds[1]));
+
+		clients.emplace_back(std::make_unique<CountingClient>());
+		readers.emplace_back(
+			std::make_unique<SocketReader>(world, *clients.back(), read_sock));
+	}
+
+	// Send from every client at once
+	const auto               start = Clock::now();
+	std::vector<std::thread> writers;
+	for (uint32_t i = 0; i < n_clients; ++i) {
+		writers.emplace_back([&, i] {
+			SocketWriter writer(world.uri_map(),
+			                    world.uris(),
+			                    URI("ingen:/clients/bench"),
+			                    write_socks[i],
+			                    format);
+
+			const URI subject =
+				path_to_uri(raul::Path("/n" + std::to_string(i)));
+
+			for (int32_t j = 0; j < n_messages; ++j) {
+				writer.message(SetProperty{0, subject, key,
+				                           world.forge().make(j),
+				                           Resource::Graph::DEFAULT});
+			}
+		});
+	}
+
+	for (auto& w : writers) {
+		w.join();
+	}
+
+	// Wait until every message has been read, or give up after a while
+	const auto deadline = start + std::chrono::seconds(60);
+	for (const auto& c : clients) {
+		while (c->n_received() < static_cast<uint32_t>(n_messages) &&
+		       Clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+
+		if (c->n_received() < static_cast<uint32_t>(n_messages)) {
+			fprintf(stderr, "error: received %u of %d messages\n",
+			        c->n_received(), n_messages);
+			return 0.0;
+		}
+	}
+
+	const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+	readers.clear();
+
+	return (n_clients * static_cast<double>(n_messages)) / elapsed.count();
+}
+
+int
+run()
+{
+	World world{nullptr, nullptr, nullptr};
+
+	int status = EXIT_SUCCESS;
+	printf("# format\tclients\tmessages\tmsgs_per_sec\n");
+	for (const auto format : {WireFormat::TURTLE, WireFormat::ATOM}) {
+		const char* const name =
+			(format == WireFormat::ATOM) ? "atom" : "turtle";
+
+		for (uint32_t n_clients = 1; n_clients <= max_clients; n_clients *= 2) {
+			const double rate = run_connections(world, format, n_clients);
+			if (rate <= 0.0) {
+				status = EXIT_FAILURE;
+			}
+
+			printf("%s\t%u\t%d\t%.0f\n", name, n_clients, n_messages, rate);
+		}
+	}
+
+	return status;
+}
+
+} // namespace
+} // namespace ingen::bench
+
+int
+main()
+{
+	return ingen::bench::run();
+}
@@ -0,0 +1,285 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/* Tests of the queueing and non-blocking output of the socket loop. */
+
+#include "ClientQueue.hpp"
+#include "QueuedSocketWriter.hpp"
+
+#include <ingen/Atom.hpp>
+#include <ingen/Forge.hpp>
+#include <ingen/Interface.hpp>
+#include <ingen/Message.hpp>
+#include <ingen/Resource.hpp>
+#include <ingen/URI.hpp>
+#include <ingen/URIs.hpp>
+#include <ingen/World.hpp>
+#include <raul/Socket.hpp>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <variant>
+#include <vector>
+
+namespace ingen::test {
+namespace {
+
+using ingen::server::ClientQueue;
+using ingen::server::QueuedSocketWriter;
+
+int n_failures = 0;
+
+void
+check(bool condition, const char* file, int line, const char* expr)
+{
+	if (!condition) {
+		fprintf(stderr, "%s:%d: error: check failed: %s\n", file, line, expr);
+		++n_failures;
+	}
+}
+
+#define CHECK(expr) check((expr), __FILE__, __LINE__, #expr)
+
+/** A writer which can send raw bytes. */
+class TestWriter : public QueuedSocketWriter
+{
+public:
+	using QueuedSocketWriter::QueuedSocketWriter;
+	using QueuedSocketWriter::send_all;
+};
+
+/** A connected pair of sockets with small buffers, so they fill quickly. */
+struct Pair {
+	Pair() {
+		int fds[2] = {-1, -1};
+		if (!socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+			const int size = 4096;
+			setsockopt(fds[0], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+			setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+			reader = std::make_shared<raul::Socket>(
+				raul::Socket::Type::UNIX, "", nullptr, 0, fds[0]);
+			writer = std::make_shared<raul::Socket>(
+				raul::Socket::Type::UNIX, "", nullptr, 0, fds[1]);
+		}
+	}
+
+	/** Receive whatever has arrived without blocking.
+	 *
+	 * @return False at the end of the stream.
+	 */
+	bool receive(std::vector<uint8_t>& out) const {
+		uint8_t buf[4096];
+		while (true) {
+			const ssize_t n = recv(reader->fd(), buf, sizeof(buf), MSG_DONTWAIT);
+			if (n > 0) {
+				out.insert(out.end(), buf, buf + n);
+			} else {
+				return n < 0;
+			}
+		}
+	}
+
+	std::shared_ptr<raul::Socket> reader;
+	std::shared_ptr<raul::Socket> writer;
+};
+
+std::vector<uint8_t>
+make_chunk(uint32_t index, size_t size)
+{
+	std::vector<uint8_t> chunk(size);
+	for (size_t j = 0U; j < size; ++j) {
+		chunk[j] = static_cast<uint8_t>((index * 7U) + j);
+	}
+	return chunk;
+}
+
+/** Output the socket does not accept is queued and sent in order later. */
+void
+test_partial_write(World& world)
+{
+	static constexpr uint32_t n_chunks   = 64U;
+	static constexpr size_t   chunk_size = 4096U;
+
+	const Pair pair;
+	TestWriter writer(world.uri_map(), world.uris(), world.log(), pair.writer,
+	                  n_chunks * chunk_size);
+
+	std::vector<uint8_t> sent;
+	for (uint32_t i = 0U; i < n_chunks; ++i) {
+		const std::vector<uint8_t> chunk = make_chunk(i, chunk_size);
+		CHECK(writer.send_all(chunk.data(), chunk.size()));
+		sent.insert(sent.end(), chunk.begin(), chunk.end());
+	}
+
+	// The socket took some, and the rest is waiting
+	CHECK(writer.n_queued() > 0U);
+	CHECK(writer.n_queued() < sent.size());
+	CHECK(!writer.failed());
+
+	// Read and flush until everything arrives
+	std::vector<uint8_t> received;
+	for (uint32_t i = 0U; i < 100000U && received.size() < sent.size(); ++i) {
+		CHECK(pair.receive(received));
+		CHECK(writer.flush());
+	}
+
+	CHECK(writer.n_queued() == 0U);
+	CHECK(received == sent);
+}
+
+/** A client which lets too much output pile up is disconnected. */
+void
+test_overflow(World& world)
+{
+	static constexpr size_t max_queued = 16384U;
+	static constexpr size_t chunk_size = 1024U;
+
+	const Pair pair;
+	TestWriter writer(world.uri_map(), world.uris(), world.log(), pair.writer,
+	                  max_queued);
+
+	// Write without reading until the writer gives up
+	size_t n_sent = 0U;
+	for (uint32_t i = 0U; i < 1024U; ++i) {
+		const std::vector<uint8_t> chunk = make_chunk(i, chunk_size);
+		if (!writer.send_all(chunk.data(), chunk.size())) {
+			break;
+		}
+		n_sent += chunk_size;
+	}
+
+	CHECK(n_sent >= max_queued);
+	CHECK(n_sent < 1024U * chunk_size);
+	CHECK(writer.failed());
+	CHECK(writer.n_queued() == 0U);
+	CHECK(!writer.flush());
+	CHECK(!writer.send_all("x", 1U));
+
+	// The peer sees whatever the socket accepted, then the end of the stream
+	std::vector<uint8_t> received;
+	CHECK(!pair.receive(received));
+	CHECK(received.size() >= n_sent - max_queued);
+	CHECK(received.size() <= n_sent - max_queued + chunk_size);
+}
+
+/** A client can be disconnected explicitly. */
+void
+test_disconnect(World& world)
+{
+	const Pair pair;
+	TestWriter writer(world.uri_map(), world.uris(), world.log(), pair.writer,
+	                  4096U);
+
+	CHECK(writer.send_all("x", 1U));
+	writer.disconnect();
+	CHECK(writer.failed());
+	CHECK(!writer.send_all("y", 1U));
+
+	std::vector<uint8_t> received;
+	CHECK(!pair.receive(received));
+	CHECK(received == std::vector<uint8_t>{'x'});
+}
+
+/** Interface that records the messages sent to a client. */
+class RecordingClient : public Interface
+{
+public:
+	URI uri() const override { return URI("ingen:/clients/test"); }
+
+	void message(const Message& msg) override { messages.push_back(msg); }
+
+	std::vector<Message> messages;
+};
+
+SetProperty
+set(World& world, const char* subject, const URI& key, int32_t value)
+{
+	return SetProperty{0, URI(subject), key, world.forge().make(value),
+	                   Resource::Graph::DEFAULT};
+}
+
+/** Monitored values are merged and dropped, other messages never are. */
+void
+test_client_queue(World& world)
+{
+	const URIs& uris = world.uris();
+
+	auto     client         = std::make_shared<RecordingClient>();
+	unsigned n_disconnected = 0U;
+	unsigned n_notified     = 0U;
+
+	ClientQueue queue(
+		world.log(), uris, client, 4U,
+		[&n_disconnected] { ++n_disconnected; },
+		[&n_notified] { ++n_notified; });
+
+	// A later value of the same port replaces one that is not sent yet
+	for (int32_t i = 0; i < 10; ++i) {
+		queue.message(set(world, "ingen:/main/a", uris.ingen_value, i));
+	}
+	CHECK(queue.n_coalesced() == 9U);
+
+	// Values are not moved past other changes
+	queue.message(set(world, "ingen:/main/a", uris.lv2_name, 0));
+	queue.message(set(world, "ingen:/main/a", uris.ingen_value, 10));
+	CHECK(queue.n_coalesced() == 9U);
+
+	// Values of other ports are dropped once the queue is full
+	queue.message(set(world, "ingen:/main/b", uris.ingen_activity, 1));
+	queue.message(set(world, "ingen:/main/c", uris.ingen_activity, 1));
+	CHECK(queue.n_dropped() == 1U);
+	CHECK(!queue.overflowed());
+	CHECK(n_disconnected == 0U);
+
+	CHECK(queue.drain() == 4U);
+	CHECK(client->messages.size() == 4U);
+	const auto* const first = std::get_if<SetProperty>(&client->messages[0]);
+	CHECK(first && first->value.get<int32_t>() == 9);
+
+	// Any other message that does not fit disconnects the client once
+	for (int32_t i = 0; i < 6; ++i) {
+		queue.message(set(world, "ingen:/main/a", uris.lv2_name, i));
+	}
+	queue.message(set(world, "ingen:/main/a", uris.ingen_value, 0));
+	CHECK(queue.overflowed());
+	CHECK(n_disconnected == 1U);
+	CHECK(n_notified == 17U);
+	CHECK(queue.drain() == 4U);
+}
+
+} // namespace
+} // namespace ingen::test
+
+int
+main()
+{
+	ingen::World world{nullptr, nullptr, nullptr};
+
+	ingen::test::test_partial_write(world);
+	ingen::test::test_overflow(world);
+	ingen::test::test_disconnect(world);
+	ingen::test::test_client_queue(world);
+
+	return ingen::test::n_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
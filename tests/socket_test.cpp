@@ -0,0 +1,360 @@
+/*
+  This file is part of Ingen.
+  Copyright 2026 agent <agent@local>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/* Tests of socket format negotiation and reading untrusted atoms. */
+
+#include <ingen/Atom.hpp>
+#include <ingen/Forge.hpp>
+#include <ingen/Interface.hpp>
+#include <ingen/Message.hpp>
+#include <ingen/Resource.hpp>
+#include <ingen/SocketReader.hpp>
+#include <ingen/SocketWriter.hpp>
+#include <ingen/URI.hpp>
+#include <ingen/WireFormat.hpp>
+#include <ingen/World.hpp>
+#include <lv2/atom/atom.h>
+#include <raul/Socket.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <variant>
+#include <vector>
+
+namespace ingen::test {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const URI subject("ingen:/main/n");
+const URI key("http://drobilla.net/ns/ingen#testValue");
+
+int n_failures = 0;
+
+void
+check(bool condition, const char* file, int line, const char* expr)
+{
+	if (!condition) {
+		fprintf(stderr, "%s:%d: error: check failed: %s\n", file, line, expr);
+		++n_failures;
+	}
+}
+
+#define CHECK(expr) check((expr), __FILE__, __LINE__, #expr)
+
+/** Interface that records the values of set messages read from a socket. */
+class RecordingClient : public Interface
+{
+public:
+	URI uri() const override { return URI("ingen:/clients/test"); }
+
+	void message(const Message& msg) override {
+		const std::lock_guard<std::mutex> lock{_mutex};
+		if (const auto* const set = std::get_if<SetProperty>(&msg)) {
+			_values.push_back(set->value.get<int32_t>());
+		} else {
+			++_n_other;
+		}
+	}
+
+	/** Wait until `n` values have arrived and return them. */
+	std::vector<int32_t> wait(size_t n) {
+		const auto deadline = Clock::now() + std::chrono::seconds(10);
+		while (Clock::now() < deadline) {
+			{
+				const std::lock_guard<std::mutex> lock{_mutex};
+				if (_values.size() >= n) {
+					return _values;
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		const std::lock_guard<std::mutex> lock{_mutex};
+		return _values;
+	}
+
+	uint32_t n_other() const { return _n_other; }
+
+private:
+	std::mutex            _mutex;
+	std::vector<int32_t>  _values;
+	std::atomic<uint32_t> _n_other{0};
+};
+
+/** A connected pair of sockets. */
+struct Pair {
+	Pair() {
+		int fds[2] = {-1, -1};
+		if (!socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+			reader = std::make_shared<raul::Socket>(
+				raul::Socket::Type::UNIX, "", nullptr, 0, fds[0]);
+			writer = std::make_shared<raul::Socket>(
+				raul::Socket::Type::UNIX, "", nullptr, 0, fds[1]);
+		}
+	}
+
+	/** Send raw bytes from the writing end. */
+	void send(const void* buf, size_t len) const {
+		CHECK(::send(writer->fd(), buf, len, 0) == static_cast<ssize_t>(len));
+	}
+
+	std::shared_ptr<raul::Socket> reader;
+	std::shared_ptr<raul::Socket> writer;
+};
+
+void
+set(SocketWriter& writer, World& world, int32_t value)
+{
+	writer.message(SetProperty{0, subject, key, world.forge().make(value),
+	                           Resource::Graph::DEFAULT});
+}
+
+/** A server reading from a client that requests atoms switches to atoms. */
+void
+test_request_atoms(World& world)
+{
+	const Pair      pair;
+	RecordingClient client;
+	WireFormat      format = WireFormat::TURTLE;
+	{
+		const SocketReader reader(
+			world, client, pair.reader, WireFormat::TURTLE,
+			[&format](WireFormat f) { format = f; });
+
+		SocketWriter writer(world.uri_map(), world.uris(), client.uri(),
+		                    pair.writer, WireFormat::ATOM);
+		set(writer, world, 1);
+		set(writer, world, 2);
+
+		CHECK((client.wait(2U) == std::vector<int32_t>{1, 2}));
+		pair.writer->shutdown();
+	}
+
+	CHECK(format == WireFormat::ATOM);
+}
+
+/** A client skips Turtle until the server acknowledges its request. */
+void
+test_acknowledge_atoms(World& world)
+{
+	const Pair      pair;
+	RecordingClient client;
+	bool            fell_back = false;
+	{
+		const SocketReader reader(
+			world, client, pair.reader, WireFormat::ATOM,
+			[&fell_back](WireFormat) { fell_back = true; });
+
+		// Server sends Turtle, then acknowledges before the next message
+		SocketWriter writer(world.uri_map(), world.uris(), client.uri(),
+		                    pair.writer, WireFormat::TURTLE);
+		set(writer, world, 1);
+		writer.set_format(WireFormat::ATOM);
+		set(writer, world, 2);
+
+		CHECK((client.wait(1U) == std::vector<int32_t>{2}));
+		pair.writer->shutdown();
+	}
+
+	CHECK(!fell_back);
+}
+
+/** A server acknowledges a request for atoms without waiting for output.
+ *
+ * The server has nothing to send for longer than a client waits for the
+ * acknowledgement, then both sides must still be speaking atoms.
+ */
+void
+test_acknowledge_idle(World& world)
+{
+	const Pair      pair;
+	RecordingClient client;
+	RecordingClient server;
+	bool            fell_back = false;
+	{
+		// Server side, which switches its writer when it reads the request
+		SocketWriter       server_writer(world.uri_map(), world.uris(),
+		                                 server.uri(), pair.reader);
+		const SocketReader server_reader(
+			world, server, pair.reader, WireFormat::TURTLE,
+			[&server_writer](WireFormat f) { server_writer.set_format(f); });
+
+		// Client side, which requests atoms
+		SocketWriter       client_writer(world.uri_map(), world.uris(),
+		                                 client.uri(), pair.writer,
+		                                 WireFormat::ATOM);
+		const SocketReader client_reader(
+			world, client, pair.writer, WireFormat::ATOM,
+			[&fell_back](WireFormat) { fell_back = true; });
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+
+		set(client_writer, world, 1);
+		set(server_writer, world, 2);
+		CHECK((server.wait(1U) == std::vector<int32_t>{1}));
+		CHECK((client.wait(1U) == std::vector<int32_t>{2}));
+		CHECK(server.n_other() == 0U);
+		CHECK(client.n_other() == 0U);
+		pair.reader->shutdown();
+		pair.writer->shutdown();
+	}
+
+	CHECK(!fell_back);
+}
+
+/** A client whose request is never acknowledged falls back to Turtle. */
+void
+test_fall_back_to_turtle(World& world)
+{
+	const Pair      pair;
+	RecordingClient client;
+	WireFormat      format = WireFormat::ATOM;
+	{
+		const SocketReader reader(
+			world, client, pair.reader, WireFormat::ATOM,
+			[&format](WireFormat f) { format = f; });
+
+		// Server only speaks Turtle, and ignores the request
+		SocketWriter writer(world.uri_map(), world.uris(), client.uri(),
+		                    pair.writer, WireFormat::TURTLE);
+		set(writer, world, 1);
+		set(writer, world, 2);
+
+		// Messages sent before the timeout are read as well as those after
+		CHECK((client.wait(2U) == std::vector<int32_t>{1, 2}));
+		set(writer, world, 3);
+		CHECK((client.wait(3U) == std::vector<int32_t>{1, 2, 3}));
+		pair.writer->shutdown();
+	}
+
+	CHECK(format == WireFormat::TURTLE);
+}
+
+/** Append words to a raw message. */
+void
+append_words(std::vector<uint8_t>& buf, std::initializer_list<uint32_t> words)
+{
+	for (const uint32_t w : words) {
+		const auto* const bytes = reinterpret_cast<const uint8_t*>(&w);
+		buf.insert(buf.end(), bytes, bytes + sizeof(w));
+	}
+}
+
+/** Append an atom header to a raw message. */
+void
+append_atom(std::vector<uint8_t>& buf, uint32_t size, uint32_t type)
+{
+	append_words(buf, {size, type});
+}
+
+/** Append a definition of a peer URID to a raw message.
+ *
+ * Like every message, this is exactly as long as its header says, without
+ * padding, so the next message starts right after the URI.
+ */
+void
+append_urid(std::vector<uint8_t>& buf, uint32_t urid, const char* uri)
+{
+	const size_t len = strlen(uri) + 1U;
+
+	append_atom(buf, static_cast<uint32_t>(sizeof(urid) + len),
+	            wire_urid_definition);
+	append_words(buf, {urid});
+	buf.insert(buf.end(), uri, uri + len);
+}
+
+/** Malformed atoms are rejected without reading past them. */
+void
+test_malformed_atoms(World& world)
+{
+	static constexpr uint32_t tuple  = 100U;
+	static constexpr uint32_t vector = 101U;
+	static constexpr uint32_t i32    = 102U;
+
+	const Pair      pair;
+	RecordingClient client;
+	{
+		const SocketReader reader(world, client, pair.reader);
+
+		SocketWriter writer(world.uri_map(), world.uris(), client.uri(),
+		                    pair.writer, WireFormat::ATOM);
+
+		std::vector<uint8_t> msgs;
+		append_urid(msgs, tuple, LV2_ATOM__Tuple);
+		append_urid(msgs, vector, LV2_ATOM__Vector);
+		append_urid(msgs, i32, LV2_ATOM__Int);
+
+		// Tuple with a child that is truncated by the end of the tuple
+		append_atom(msgs, 16U, tuple);
+		append_atom(msgs, 1024U, i32);
+		append_words(msgs, {0U, 0U});
+
+		// Tuple with a child so large that its end wraps around
+		append_atom(msgs, 16U, tuple);
+		append_atom(msgs, 0xFFFFFFF8U, i32);
+		append_words(msgs, {0U, 0U});
+
+		// Vector with a child size that does not match its child type
+		append_atom(msgs, 16U, vector);
+		append_words(msgs, {8U, i32, 0U, 0U});
+
+		// Tuples nested deeper than any message needs
+		static constexpr uint32_t depth = 1000U;
+		for (uint32_t d = 0U; d < depth; ++d) {
+			append_atom(msgs, ((depth - d - 1U) * 8U) + 16U, tuple);
+		}
+		append_atom(msgs, 4U, i32);
+		append_words(msgs, {0U, 0U});
+
+		pair.send(msgs.data(), msgs.size());
+
+		// The connection is still usable afterwards
+		set(writer, world, 1);
+		CHECK((client.wait(1U) == std::vector<int32_t>{1}));
+		CHECK(client.n_other() == 0U);
+		pair.writer->shutdown();
+	}
+}
+
+} // namespace
+} // namespace ingen::test
+
+int
+main()
+{
+	ingen::World world{nullptr, nullptr, nullptr};
+
+	ingen::test::test_request_atoms(world);
+	ingen::test::test_acknowledge_atoms(world);
+	ingen::test::test_acknowledge_idle(world);
+	ingen::test::test_fall_back_to_turtle(world);
+	ingen::test::test_malformed_atoms(world);
+
+	return ingen::test::n_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}